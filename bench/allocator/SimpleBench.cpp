@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <afina/allocator/Error.h>
+#include <afina/allocator/Pointer.h>
+#include <afina/allocator/Simple.h>
+
+using namespace Afina::Allocator;
+
+/**
+ * Throughput of Allocator::Simple against malloc on the same random mix of
+ * alloc, realloc and free of 16..1024 bytes, live data takes about half of
+ * the arena. Simple defrags whenever allocation fails. Usage:
+ *
+ *   benchAllocatorSimple [arena size in KB...]
+ *
+ * by default runs on 64KB, 1MB and 16MB
+ */
+
+static const size_t operations = 2000000;
+
+struct Operation {
+    size_t index;
+    size_t size; // 0 means free
+};
+
+static std::vector<Operation> Workload(size_t slots) {
+    std::mt19937_64 random(42);
+    std::vector<bool> live(slots);
+    std::vector<Operation> ops;
+    ops.reserve(operations);
+    for (size_t i = 0; i < operations; i++) {
+        size_t index = random() % slots;
+        size_t size = 16 + random() % 1009;
+        if (live[index] && random() % 2 == 0) {
+            size = 0;
+        }
+        live[index] = size != 0;
+        ops.push_back({index, size});
+    }
+    return ops;
+}
+
+static double RunSimple(size_t arena, const std::vector<Operation> &ops, size_t slots, size_t &defrags) {
+    std::vector<char> memory(arena);
+    Simple allocator(memory.data(), memory.size());
+    std::vector<Pointer> ptrs(slots);
+
+    defrags = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const Operation &op : ops) {
+        Pointer &p = ptrs[op.index];
+        if (op.size == 0) {
+            allocator.free(p);
+            continue;
+        }
+        try {
+            allocator.realloc(p, op.size);
+        } catch (AllocError &) {
+            allocator.defrag();
+            defrags++;
+            try {
+                allocator.realloc(p, op.size);
+            } catch (AllocError &) {
+                allocator.free(p);
+                continue;
+            }
+        }
+        *static_cast<char *>(p.get()) = 1;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    for (Pointer &p : ptrs) {
+        allocator.free(p);
+    }
+    return std::chrono::duration<double, std::nano>(end - start).count() / ops.size();
+}
+
+static double RunMalloc(const std::vector<Operation> &ops, size_t slots) {
+    std::vector<void *> ptrs(slots);
+
+    auto start = std::chrono::steady_clock::now();
+    for (const Operation &op : ops) {
+        void *&p = ptrs[op.index];
+        if (op.size == 0) {
+            std::free(p);
+            p = nullptr;
+            continue;
+        }
+        p = std::realloc(p, op.size);
+        *static_cast<char *>(p) = 1;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    for (void *p : ptrs) {
+        std::free(p);
+    }
+    return std::chrono::duration<double, std::nano>(end - start).count() / ops.size();
+}
+
+int main(int argc, char **argv) {
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; i++) {
+        sizes.push_back(std::strtoull(argv[i], nullptr, 10) * 1024);
+    }
+    if (sizes.empty()) {
+        sizes = {64 * 1024, 1024 * 1024, 16 * 1024 * 1024};
+    }
+
+    std::cout << "arena\tsimple ns/op\tmalloc ns/op\tdefrags" << std::endl;
+    for (size_t arena : sizes) {
+        // About 2/3 of slots are live on average, 520 bytes each
+        size_t slots = std::max<size_t>(1, arena / 2 / 520 * 3 / 2);
+        std::vector<Operation> ops = Workload(slots);
+        size_t defrags;
+        double simple = RunSimple(arena, ops, slots, defrags);
+        double system = RunMalloc(ops, slots);
+        std::cout << arena << "\t" << simple << "\t" << system << "\t" << defrags << std::endl;
+    }
+    return 0;
+}
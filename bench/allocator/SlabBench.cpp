@@ -0,0 +1,131 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <afina/allocator/Arena.h>
+#include <afina/allocator/ConcurrentSlabAllocator.h>
+#include <afina/allocator/SlabAllocator.h>
+
+using namespace Afina::Allocator;
+
+/**
+ * Throughput of ConcurrentSlabAllocator against SlabAllocator behind a mutex, both over
+ * the same arena. Each thread allocates and frees 64..1024 bytes at random keeping up to
+ * 1000 objects live, every fourth object is freed by the neighbour thread. Usage:
+ *
+ *   benchAllocatorSlab [number of threads...]
+ *
+ * by default runs on 1, 2, 4 and 8 threads
+ */
+
+static const size_t operations = 2000000;
+static const size_t live = 1000;
+static const size_t arena_size = 256 << 20;
+
+// SlabAllocator shared by threads the plain way
+class LockedSlabAllocator {
+public:
+    explicit LockedSlabAllocator(std::shared_ptr<Arena> arena) : _allocator(std::move(arena)) {}
+
+    void *Allocate(std::size_t size) {
+        std::lock_guard<std::mutex> guard(_lock);
+        return _allocator.Allocate(size);
+    }
+
+    void Free(void *object, std::size_t size) {
+        std::lock_guard<std::mutex> guard(_lock);
+        _allocator.Free(object, size);
+    }
+
+private:
+    std::mutex _lock;
+    SlabAllocator _allocator;
+};
+
+// Objects one thread hands over to another one to free
+struct Mailbox {
+    std::mutex lock;
+    std::vector<std::pair<void *, size_t>> objects;
+};
+
+template <typename Allocator> static double Run(size_t threads) {
+    Allocator allocator(std::make_shared<Arena>(arena_size));
+    std::vector<Mailbox> mailboxes(threads);
+
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&allocator, &mailboxes, threads, t]() {
+            std::mt19937_64 random(t);
+            std::vector<std::pair<void *, size_t>> own, incoming;
+            for (size_t i = 0; i < operations / threads; i++) {
+                if (own.size() < live && (own.empty() || random() % 2 == 0)) {
+                    size_t size = 64 + random() % 961;
+                    void *object = allocator.Allocate(size);
+                    *static_cast<char *>(object) = 1;
+                    own.emplace_back(object, size);
+                    continue;
+                }
+
+                std::size_t victim = random() % own.size();
+                std::swap(own[victim], own.back());
+                if (random() % 4 == 0) {
+                    Mailbox &next = mailboxes[(t + 1) % threads];
+                    std::lock_guard<std::mutex> guard(next.lock);
+                    next.objects.push_back(own.back());
+                } else {
+                    allocator.Free(own.back().first, own.back().second);
+                }
+                own.pop_back();
+
+                if (i % 64 == 0) {
+                    {
+                        std::lock_guard<std::mutex> guard(mailboxes[t].lock);
+                        incoming.swap(mailboxes[t].objects);
+                    }
+                    for (auto &object : incoming) {
+                        allocator.Free(object.first, object.second);
+                    }
+                    incoming.clear();
+                }
+            }
+            for (auto &object : own) {
+                allocator.Free(object.first, object.second);
+            }
+        });
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    for (auto &mailbox : mailboxes) {
+        for (auto &object : mailbox.objects) {
+            allocator.Free(object.first, object.second);
+        }
+    }
+    return std::chrono::duration<double, std::nano>(end - start).count() / operations;
+}
+
+int main(int argc, char **argv) {
+    std::vector<size_t> threads;
+    for (int i = 1; i < argc; i++) {
+        threads.push_back(std::strtoull(argv[i], nullptr, 10));
+    }
+    if (threads.empty()) {
+        threads = {1, 2, 4, 8};
+    }
+
+    std::cout << "threads\tlocked ns/op\tmagazines ns/op" << std::endl;
+    for (size_t n : threads) {
+        double locked = Run<LockedSlabAllocator>(n);
+        double magazines = Run<ConcurrentSlabAllocator>(n);
+        std::cout << n << "\t" << locked << "\t" << magazines << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "storage/EvictionPolicy.h"
+#include "storage/SimpleLRU.h"
+
+using namespace Afina::Backend;
+
+/**
+ * Shows how W-TinyLFU admission protects working set from scans: Zipfian
+ * requests to a read-through cache (get, put on miss) are interrupted by
+ * periodic scans of keys that are never requested again. Reports share of hits
+ * among Zipfian requests for every eviction policy with and without admission.
+ * Usage:
+ *
+ *   benchStorageAdmission [scan length...]
+ *
+ * by default runs with scans of 0, 20k and 100k keys
+ */
+
+static const size_t keys = 200000;
+static const size_t requests = 2000000;
+static const double exponent = 0.9;
+
+// Scan starts after each that many Zipfian requests
+static const size_t scan_period = 100000;
+
+// Cache fits about 10% of Zipfian keys
+static const size_t value_size = 100;
+static const size_t cache_size = keys / 10 * (value_size + 16);
+
+// Request is either rank of a Zipfian key or number of a one-off scan key with the high bit set
+static const uint32_t scan_bit = 1u << 31;
+
+static std::vector<uint32_t> MakeTrace(size_t scan_length) {
+    std::vector<double> cdf(keys);
+    double sum = 0;
+    for (size_t i = 0; i < keys; i++) {
+        sum += 1.0 / std::pow(double(i + 1), exponent);
+        cdf[i] = sum;
+    }
+
+    std::mt19937_64 random(42);
+    std::uniform_real_distribution<double> uniform(0, sum);
+    std::vector<uint32_t> trace;
+    trace.reserve(requests + requests / scan_period * scan_length);
+    uint32_t scanned = 0;
+    for (size_t i = 0; i < requests; i++) {
+        if (i % scan_period == 0) {
+            for (size_t j = 0; j < scan_length; j++) {
+                trace.push_back(scan_bit | scanned++);
+            }
+        }
+        trace.push_back(std::lower_bound(cdf.begin(), cdf.end(), uniform(random)) - cdf.begin());
+    }
+    return trace;
+}
+
+// Returns share of hits among Zipfian requests
+static double Replay(SimpleLRU &storage, const std::vector<std::string> &names, const std::vector<uint32_t> &trace) {
+    const std::string value(value_size, 'v');
+    std::string out;
+    size_t hits = 0;
+    for (uint32_t request : trace) {
+        if (request & scan_bit) {
+            std::string key = "scan:" + std::to_string(request & ~scan_bit);
+            if (!storage.Get(key, out)) {
+                storage.Put(key, value);
+            }
+            continue;
+        }
+
+        const std::string &key = names[request];
+        if (storage.Get(key, out)) {
+            hits++;
+        } else {
+            storage.Put(key, value);
+        }
+    }
+    return double(hits) / requests;
+}
+
+int main(int argc, char **argv) {
+    std::vector<size_t> scans;
+    for (int i = 1; i < argc; i++) {
+        scans.push_back(std::strtoull(argv[i], nullptr, 10));
+    }
+    if (scans.empty()) {
+        scans = {0, 20000, 100000};
+    }
+
+    std::vector<std::string> names;
+    names.reserve(keys);
+    for (size_t i = 0; i < keys; i++) {
+        names.push_back("object:" + std::to_string(i));
+    }
+
+    std::cout << "scan\tpolicy\thit ratio\thit ratio with admission" << std::endl;
+    const char *policies[] = {"lru", "clock", "slru"};
+    for (size_t scan : scans) {
+        std::vector<uint32_t> trace = MakeTrace(scan);
+        for (const char *name : policies) {
+            EvictionPolicy::Kind kind = EvictionPolicy::Parse(name);
+            SimpleLRU plain(cache_size, &SimpleLRU::SystemClock, kind, false);
+            SimpleLRU admitting(cache_size, &SimpleLRU::SystemClock, kind, true);
+            std::cout << scan << "\t" << name << "\t" << Replay(plain, names, trace) << "\t"
+                      << Replay(admitting, names, trace) << std::endl;
+        }
+    }
+    return 0;
+}
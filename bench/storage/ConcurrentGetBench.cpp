@@ -0,0 +1,96 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/RcuLRU.h"
+#include "storage/ShardedLRU.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+using namespace Afina::Backend;
+
+/**
+ * Compares throughput of get on a read mostly workload for storages that could be
+ * shared by threads: single lock, lock per shard and lock free reads. Every thread
+ * does the same number of requests, 1% of them are puts. Usage:
+ *
+ *   benchStorageConcurrentGet [number of threads...]
+ *
+ * by default runs with 1, 2, 4 and 8 threads
+ */
+
+static const size_t keys = 100000;
+static const size_t requests = 2000000;
+static const size_t shards = 16;
+static const size_t value_size = 100;
+
+// Whole working set fits, so that only synchronization is measured
+static const size_t cache_size = keys * (value_size + 32);
+
+// Prevents compiler from throwing gets away
+static std::atomic<size_t> sink(0);
+
+// Returns total number of requests per microsecond
+static double Measure(Afina::Storage &storage, const std::vector<std::string> &names, size_t threads) {
+    const std::string value(value_size, 'v');
+    for (auto &name : names) {
+        storage.Put(name, value);
+    }
+
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&storage, &names, &value, t]() {
+            std::mt19937_64 random(t);
+            std::string out;
+            size_t found = 0;
+            for (size_t i = 0; i < requests; i++) {
+                const std::string &key = names[random() % names.size()];
+                if (i % 100 == 0) {
+                    storage.Put(key, value);
+                } else {
+                    found += storage.Get(key, out);
+                }
+            }
+            sink += found;
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return threads * requests / std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+int main(int argc, char **argv) {
+    std::vector<size_t> counts;
+    for (int i = 1; i < argc; i++) {
+        counts.push_back(std::strtoull(argv[i], nullptr, 10));
+    }
+    if (counts.empty()) {
+        counts = {1, 2, 4, 8};
+    }
+
+    std::vector<std::string> names;
+    names.reserve(keys);
+    for (size_t i = 0; i < keys; i++) {
+        names.push_back("object:" + std::to_string(i));
+    }
+
+    std::cout << "threads\tmt_lru Mops/s\tmt_sharded_lru Mops/s\tmt_rcu_clock Mops/s" << std::endl;
+    for (size_t threads : counts) {
+        ThreadSafeSimplLRU locked(cache_size);
+        ShardedLRU sharded(cache_size, shards);
+        RcuLRU rcu(cache_size);
+
+        double locked_mops = Measure(locked, names, threads);
+        double sharded_mops = Measure(sharded, names, threads);
+        double rcu_mops = Measure(rcu, names, threads);
+        std::cout << threads << "\t" << locked_mops << "\t" << sharded_mops << "\t" << rcu_mops << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "storage/SimpleLRU.h"
+
+using namespace Afina::Backend;
+
+/**
+ * Regression benchmark for SimpleLRU::Delete: latency of a single delete must
+ * not depend on number of items in the cache. Usage:
+ *
+ *   benchStorageDelete [number of items...]
+ *
+ * by default runs on 10k, 100k and 1M items
+ */
+
+static const size_t deletes = 10000;
+
+static void Run(size_t items) {
+    std::vector<std::string> keys;
+    keys.reserve(items);
+    for (size_t i = 0; i < items; i++) {
+        keys.push_back("session:" + std::to_string(i));
+    }
+
+    SimpleLRU storage(items * 64);
+    for (auto &key : keys) {
+        storage.Put(key, "value");
+    }
+
+    // Deleted keys are spread over the whole LRU list
+    std::mt19937_64 random(42);
+    std::shuffle(keys.begin(), keys.end(), random);
+    keys.resize(std::min(items, deletes));
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto &key : keys) {
+        storage.Delete(key);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    std::cout << items << "\t" << std::chrono::duration<double, std::nano>(end - start).count() / keys.size()
+              << std::endl;
+}
+
+int main(int argc, char **argv) {
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; i++) {
+        sizes.push_back(std::strtoull(argv[i], nullptr, 10));
+    }
+    if (sizes.empty()) {
+        sizes = {10000, 100000, 1000000};
+    }
+
+    std::cout << "items\tns/delete" << std::endl;
+    for (size_t items : sizes) {
+        Run(items);
+    }
+    return 0;
+}
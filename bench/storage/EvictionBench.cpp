@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/EvictionPolicy.h"
+#include "storage/SimpleLRU.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+using namespace Afina::Backend;
+
+/**
+ * Compares eviction policies on Zipfian traces: share of hits and throughput
+ * of a read-through cache (get, put on miss) for single SimpleLRU and for
+ * ThreadSafeSimplLRU shared by several threads. Usage:
+ *
+ *   benchStorageEviction [zipf exponent...]
+ *
+ * by default runs with exponents 0.8, 0.99 and 1.2
+ */
+
+static const size_t keys = 1000000;
+static const size_t requests = 4000000;
+static const size_t threads = 4;
+
+// Cache fits about 10% of all the items
+static const size_t value_size = 100;
+static const size_t cache_size = keys / 10 * (value_size + 16);
+
+// Ranks of keys drawn from Zipf distribution with the given exponent
+static std::vector<uint32_t> MakeTrace(double exponent) {
+    std::vector<double> cdf(keys);
+    double sum = 0;
+    for (size_t i = 0; i < keys; i++) {
+        sum += 1.0 / std::pow(double(i + 1), exponent);
+        cdf[i] = sum;
+    }
+
+    std::mt19937_64 random(42);
+    std::uniform_real_distribution<double> uniform(0, sum);
+    std::vector<uint32_t> trace(requests);
+    for (auto &rank : trace) {
+        rank = std::lower_bound(cdf.begin(), cdf.end(), uniform(random)) - cdf.begin();
+    }
+    return trace;
+}
+
+// Returns number of hits
+template <typename S>
+static size_t Replay(S &storage, const std::vector<std::string> &names, const std::vector<uint32_t> &trace, size_t from,
+                     size_t to) {
+    const std::string value(value_size, 'v');
+    std::string out;
+    size_t hits = 0;
+    for (size_t i = from; i < to; i++) {
+        const std::string &key = names[trace[i]];
+        if (storage.Get(key, out)) {
+            hits++;
+        } else {
+            storage.Put(key, value);
+        }
+    }
+    return hits;
+}
+
+static void Run(double exponent, const std::vector<std::string> &names) {
+    std::vector<uint32_t> trace = MakeTrace(exponent);
+
+    const char *policies[] = {"lru", "clock", "slru"};
+    for (const char *name : policies) {
+        EvictionPolicy::Kind kind = EvictionPolicy::Parse(name);
+
+        double hit_ratio, single_mops;
+        {
+            SimpleLRU storage(cache_size, &SimpleLRU::SystemClock, kind);
+            auto start = std::chrono::steady_clock::now();
+            size_t hits = Replay(storage, names, trace, 0, trace.size());
+            auto end = std::chrono::steady_clock::now();
+
+            hit_ratio = double(hits) / trace.size();
+            single_mops = trace.size() / std::chrono::duration<double, std::micro>(end - start).count();
+        }
+
+        double shared_mops;
+        {
+            ThreadSafeSimplLRU storage(cache_size, kind);
+            std::vector<std::thread> workers;
+            auto start = std::chrono::steady_clock::now();
+            for (size_t t = 0; t < threads; t++) {
+                workers.emplace_back([&storage, &names, &trace, t]() {
+                    size_t slice = trace.size() / threads;
+                    Replay(storage, names, trace, t * slice, (t + 1) * slice);
+                });
+            }
+            for (auto &worker : workers) {
+                worker.join();
+            }
+            auto end = std::chrono::steady_clock::now();
+            shared_mops = trace.size() / std::chrono::duration<double, std::micro>(end - start).count();
+        }
+
+        std::cout << exponent << "\t" << name << "\t" << hit_ratio << "\t" << single_mops << "\t" << shared_mops
+                  << std::endl;
+    }
+}
+
+int main(int argc, char **argv) {
+    std::vector<double> exponents;
+    for (int i = 1; i < argc; i++) {
+        exponents.push_back(std::strtod(argv[i], nullptr));
+    }
+    if (exponents.empty()) {
+        exponents = {0.8, 0.99, 1.2};
+    }
+
+    std::vector<std::string> names;
+    names.reserve(keys);
+    for (size_t i = 0; i < keys; i++) {
+        names.push_back("object:" + std::to_string(i));
+    }
+
+    std::cout << "zipf\tpolicy\thit ratio\tMops/s 1 thread\tMops/s " << threads << " threads" << std::endl;
+    for (double exponent : exponents) {
+        Run(exponent, names);
+    }
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "storage/HashIndex.h"
+
+using namespace Afina::Backend;
+
+/**
+ * Compares lookup latency of the std::map based index SimpleLRU used to have
+ * against HashIndex. Usage:
+ *
+ *   benchStorageIndex [number of keys...]
+ *
+ * by default runs on 10k, 1M and 10M keys
+ */
+
+// Same shape as the old SimpleLRU node: index points to a node that owns the key
+struct Node {
+    std::string key;
+    uint64_t hash;
+};
+
+using MapIndex = std::map<std::reference_wrapper<const std::string>, std::reference_wrapper<Node>, std::less<std::string>>;
+
+static const size_t lookups = 1000000;
+
+// Prevents compiler from throwing lookups away
+static volatile size_t sink;
+
+template <typename F> static double MeasureNs(F f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / lookups;
+}
+
+static void Run(size_t keys) {
+    std::vector<std::unique_ptr<Node>> nodes;
+    nodes.reserve(keys);
+    for (size_t i = 0; i < keys; i++) {
+        std::string key = "some/prefix/key:" + std::to_string(i);
+        uint64_t hash = HashBytes(key.data(), key.size());
+        nodes.emplace_back(new Node{key, hash});
+    }
+
+    // Lookups go in random order, so that neither index benefits from locality of insertion order
+    std::mt19937_64 random(42);
+    std::vector<std::string> queries;
+    queries.reserve(lookups);
+    for (size_t i = 0; i < lookups; i++) {
+        queries.push_back(nodes[random() % keys]->key);
+    }
+
+    double map_ns, hash_ns;
+    {
+        MapIndex index;
+        for (auto &node : nodes) {
+            index.emplace(std::cref(node->key), std::ref(*node));
+        }
+
+        map_ns = MeasureNs([&]() {
+            size_t found = 0;
+            for (auto &q : queries) {
+                found += index.find(q) != index.end();
+            }
+            sink = found;
+        });
+    }
+
+    {
+        HashIndex<Node *> index;
+        for (auto &node : nodes) {
+            index.Insert(node->hash, node.get());
+        }
+
+        hash_ns = MeasureNs([&]() {
+            size_t found = 0;
+            for (auto &q : queries) {
+                const char *key = q.data();
+                size_t size = q.size();
+                found += index.Find(HashBytes(key, size), [key, size](Node *node) {
+                    return node->key.size() == size && std::memcmp(node->key.data(), key, size) == 0;
+                }) != nullptr;
+            }
+            sink = found;
+        });
+    }
+
+    std::cout << keys << "\t" << map_ns << "\t" << hash_ns << std::endl;
+}
+
+int main(int argc, char **argv) {
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; i++) {
+        sizes.push_back(std::strtoull(argv[i], nullptr, 10));
+    }
+    if (sizes.empty()) {
+        sizes = {10000, 1000000, 10000000};
+    }
+
+    std::cout << "keys\tstd::map ns/lookup\tHashIndex ns/lookup" << std::endl;
+    for (size_t keys : sizes) {
+        Run(keys);
+    }
+    return 0;
+}
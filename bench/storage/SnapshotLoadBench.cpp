@@ -0,0 +1,71 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "storage/RcuLRU.h"
+#include "storage/SimpleLRU.h"
+#include "storage/Snapshot.h"
+
+using namespace Afina::Backend;
+
+/**
+ * Warm start benchmark: time to load the same snapshot into storage that maps values (SimpleLRU)
+ * and into one that copies them (RcuLRU). Mapped load should depend on number of items only,
+ * copying one on the total size of values as well. Usage:
+ *
+ *   benchStorageSnapshotLoad [value size...]
+ *
+ * by default loads 100k items with values of 100 bytes, 1KB and 10KB
+ */
+
+static const size_t items = 100000;
+
+static double Load(Afina::Storage &storage, const std::string &path) {
+    auto start = std::chrono::steady_clock::now();
+    LoadSnapshot(storage, path);
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static void Run(size_t value_size) {
+    const std::string path = "/tmp/afina_snapshot_bench_" + std::to_string(getpid());
+    size_t max_size = items * (value_size + 64);
+    {
+        SimpleLRU storage(max_size);
+        std::string value(value_size, 'x');
+        for (size_t i = 0; i < items; i++) {
+            storage.Put("session:" + std::to_string(i), value);
+        }
+        SnapshotProgress progress;
+        WriteSnapshot(storage, path, 1024, progress);
+    }
+
+    // Both runs start with the file in the page cache
+    SimpleLRU mapped(max_size);
+    double mapped_ms = Load(mapped, path);
+    RcuLRU copied(max_size);
+    double copied_ms = Load(copied, path);
+    unlink(path.c_str());
+
+    std::cout << value_size << "\t" << mapped_ms << "\t" << copied_ms << std::endl;
+}
+
+int main(int argc, char **argv) {
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; i++) {
+        sizes.push_back(std::strtoull(argv[i], nullptr, 10));
+    }
+    if (sizes.empty()) {
+        sizes = {100, 1000, 10000};
+    }
+
+    std::cout << "value\tmapped ms\tcopied ms" << std::endl;
+    for (size_t size : sizes) {
+        Run(size);
+    }
+    return 0;
+}
@@ -1,7 +1,15 @@
 #ifndef AFINA_STORAGE_H
 #define AFINA_STORAGE_H
 
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
+
+#include <afina/ValueRef.h>
 
 namespace Afina {
 
@@ -10,6 +18,51 @@ namespace Afina {
  */
 class Storage {
 public:
+    /**
+     * Outcome of the conditional update, see CompareAndSet
+     */
+    enum class CasResult {
+        // Value stored
+        Stored,
+        // Association doesn't fit into the storage
+        NotStored,
+        // Association was modified since version has been read
+        Exists,
+        // There is no association for the key
+        NotFound
+    };
+
+    /**
+     * Outcome of the counter update, see Increment
+     */
+    enum class CounterResult {
+        // Counter updated
+        Updated,
+        // There is no association for the key
+        NotFound,
+        // Value isn't a decimal representation of 64-bit unsigned integer
+        NotNumber,
+        // New value doesn't fit into the storage, counter stays unchanged
+        NoMemory,
+        // Update couldn't be written to the operation log, counter could be changed in memory but won't
+        // survive a restart
+        NotLogged
+    };
+
+    /**
+     * Receives items found by MultiGet: position of the key in the request, value bytes, client flags
+     * and version of the association. Value bytes are valid only until visitor returns
+     */
+    using GetVisitor =
+        std::function<void(std::size_t index, const char *value, std::size_t size, uint32_t flags, uint64_t cas)>;
+
+    /**
+     * Receives items visited by Scan: key and value bytes, client flags and expiration time. Bytes are
+     * valid only until visitor returns
+     */
+    using ScanVisitor = std::function<void(const char *key, std::size_t key_size, const char *value,
+                                           std::size_t value_size, uint32_t flags, time_t expire)>;
+
     Storage() {}
     virtual ~Storage() {}
 
@@ -23,12 +76,33 @@ public:
      *
      * Method returns true if success and false in case of any error. Once
      * method returns true any subsequent access to storage must indicates that
-     * key->value association exists
+     * key->value association exists until it expires
      *
      * @param key to be associated with value
      * @param value to be assigned for the key
+     * @param flags opaque client flags kept along with the value
+     * @param expire unix time association expires at, 0 means never. Association
+     * with expire time in the past is not visible right away
+     */
+    virtual bool Put(const std::string &key, const std::string &value, uint32_t flags = 0, time_t expire = 0) = 0;
+
+    /**
+     * Same as Put, but value bytes could stay where they are: in memory kept alive by the owner, for
+     * example in a mapped snapshot file. Storage holds a reference to the owner while it serves at least
+     * one such value and copies bytes out once the value is updated. Storages that can't serve external
+     * bytes copy them right away, that is what default implementation does.
+     *
+     * @param key to be associated with value
+     * @param value first byte of the value, must stay unchanged while owner is alive
+     * @param size number of bytes in the value
+     * @param flags opaque client flags kept along with the value
+     * @param expire unix time association expires at, see Put
+     * @param owner keeps value bytes alive
      */
-    virtual bool Put(const std::string &key, const std::string &value) = 0;
+    virtual bool PutExternal(const std::string &key, const char *value, std::size_t size, uint32_t flags,
+                             time_t expire, const std::shared_ptr<const void> &/*owner*/) {
+        return Put(key, std::string(value, size), flags, expire);
+    }
 
     /**
      * Stores association between given key/value pair if key isn't present in
@@ -40,8 +114,11 @@ public:
      *
      * @param key to be associated with value
      * @param value to be assigned for the key
+     * @param flags opaque client flags kept along with the value
+     * @param expire unix time association expires at, see Put
      */
-    virtual bool PutIfAbsent(const std::string &key, const std::string &value) = 0;
+    virtual bool PutIfAbsent(const std::string &key, const std::string &value, uint32_t flags = 0,
+                             time_t expire = 0) = 0;
 
     /**
      * Updates existing association between given key/value pair
@@ -49,12 +126,71 @@ public:
      * doesnt change anything.
      *
      * If given key found then existing association gets update to point to
-     * the given value.
+     * the given value, flags and expiration time.
+     *
+     * @param key to be associated with value
+     * @param value to be assigned for the key
+     * @param flags opaque client flags kept along with the value
+     * @param expire unix time association expires at, see Put
+     */
+    virtual bool Set(const std::string &key, const std::string &value, uint32_t flags = 0, time_t expire = 0) = 0;
+
+    /**
+     * Updates existing association only if it is still of the given version.
+     * Each change of the association gets a new version, so that once caller
+     * read the value along with the version (see Get) it could write back the
+     * derived value without any external lock: the write succeeds only if
+     * nobody changed the value in between.
      *
      * @param key to be associated with value
      * @param value to be assigned for the key
+     * @param cas version the association must have, as returned by Get
+     * @param flags opaque client flags kept along with the value
+     * @param expire unix time association expires at, see Put
+     */
+    virtual CasResult CompareAndSet(const std::string &key, const std::string &value, uint64_t cas,
+                                    uint32_t flags = 0, time_t expire = 0) = 0;
+
+    /**
+     * Adds data to the end of the existing value in a single lookup. Flags and
+     * expiration time of the association stay the same, version changes.
+     * If requested key doesn't present in storage method returns false and
+     * doesnt change anything.
+     *
+     * @param key association to update
+     * @param value data to be added after the current value
+     */
+    virtual bool Append(const std::string &key, const std::string &value) = 0;
+
+    /**
+     * Adds data to the beginning of the existing value, see Append
+     *
+     * @param key association to update
+     * @param value data to be added before the current value
+     */
+    virtual bool Prepend(const std::string &key, const std::string &value) = 0;
+
+    /**
+     * Treats existing value as decimal 64-bit unsigned integer and adds given
+     * delta to it, result wraps around on overflow. Value is parsed and updated
+     * inside of the storage in a single lookup. Flags and expiration time of the
+     * association stay the same, version changes.
+     *
+     * @param key association to update
+     * @param delta number to add
+     * @param value output parameter to copy new value of the counter to
+     */
+    virtual CounterResult Increment(const std::string &key, uint64_t delta, uint64_t &value) = 0;
+
+    /**
+     * Subtracts delta from the existing counter, see Increment. Counter never
+     * goes below 0
+     *
+     * @param key association to update
+     * @param delta number to subtract
+     * @param value output parameter to copy new value of the counter to
      */
-    virtual bool Set(const std::string &key, const std::string &value) = 0;
+    virtual CounterResult Decrement(const std::string &key, uint64_t delta, uint64_t &value) = 0;
 
     /**
      * Removes association for the given key
@@ -77,13 +213,94 @@ public:
      * If there is an association for the given key then method copies value
      * into given output parameter (possibly extends its size) and return true
      *
-     * In case if given key not found method returns false and doesn't perform
-     * any changes on the output parameter
+     * In case if given key not found or association has expired method returns
+     * false and doesn't perform any changes on the output parameter
      *
      * @param key to retrive1 value for
      * @param value output parameter to copy value to
+     * @param flags optional output parameter to copy client flags to
+     * @param cas optional output parameter to copy version of the association to,
+     * versions are never 0
+     * @param expire optional output parameter to copy expiration time to, 0 means never
+     */
+    virtual bool Get(const std::string &key, std::string &value, uint32_t *flags = nullptr, uint64_t *cas = nullptr,
+                     time_t *expire = nullptr) = 0;
+
+    /**
+     * Retrive pinned value for the given key without copying it, see ValueRef.
+     * Otherwise same as Get, but could also return false if storage has no memory
+     * to make the view
+     *
+     * @param key to retrive value for
+     * @param value output parameter to put view of the value to
+     * @param flags optional output parameter to copy client flags to
+     * @param cas optional output parameter to copy version of the association to
+     */
+    virtual bool GetRef(const std::string &key, ValueRef &value, uint32_t *flags = nullptr,
+                        uint64_t *cas = nullptr) = 0;
+
+    /**
+     * Retrives values for the given keys at once. Visitor is called for every
+     * key found, keys that are missing or expired are skipped. Order of calls
+     * is up to implementation, so that it could group keys by internal locks,
+     * index of the key tells which one is being visited. Callers that need
+     * the order of keys restore it by index.
+     *
+     * Visitor could be called with storage locks held, it must not call back
+     * into the storage.
+     *
+     * @param keys to retrive values for
+     * @param count number of keys
+     * @param visitor to be called for each key found
+     */
+    virtual void MultiGet(const std::string *keys, std::size_t count, const GetVisitor &visitor) {
+        std::string value;
+        uint32_t flags;
+        uint64_t cas;
+        for (std::size_t i = 0; i < count; i++) {
+            if (Get(keys[i], value, &flags, &cas)) {
+                visitor(i, value.data(), value.size(), flags, cas);
+            }
+        }
+    }
+
+    /**
+     * Appends implementation specific counters to the given list, each one as
+     * a name/value pair. Used by the "stats" command, implementations that
+     * have nothing to report may leave the list untouched.
+     *
+     * @param stats output parameter to append counters to
+     */
+    virtual void Stats(std::vector<std::pair<std::string, std::string>> &/*stats*/) {}
+
+    /**
+     * Visits live items part by part, so that the whole storage could be walked through without
+     * blocking it for long: each call looks at no more than count internal positions and holds
+     * locks only meanwhile. Scan starts with cursor 0 and goes on with the cursor returned by the
+     * previous call until 0 is returned.
+     *
+     * Items present during the whole scan are visited at least once, items stored, updated or
+     * deleted meanwhile may be visited or not. Visitor could be called with storage locks held,
+     * it must not call back into the storage.
+     *
+     * @param cursor position to continue from, 0 to start
+     * @param count number of positions to look at, at least 1
+     * @param visitor to be called for each live item
+     * @return cursor to continue from, 0 once all items are visited
+     */
+    virtual std::size_t Scan(std::size_t /*cursor*/, std::size_t /*count*/, const ScanVisitor &/*visitor*/) {
+        return 0;
+    }
+
+    /**
+     * Changes limit of memory storage could take, including all the overhead of items
+     * and index. Storage that holds more than the new limit shrinks gradually, in background
+     * of the following operations, so that none of them is stalled by evicting a lot of items.
+     *
+     * @param limit number of bytes, 0 removes the limit
+     * @return false if storage doesn't support resizing
      */
-    virtual bool Get(const std::string &key, std::string &value) = 0;
+    virtual bool SetMemoryLimit(std::size_t /*limit*/) { return false; }
 };
 
 } // namespace Afina
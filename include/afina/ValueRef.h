@@ -0,0 +1,83 @@
+#ifndef AFINA_VALUE_REF_H
+#define AFINA_VALUE_REF_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace Afina {
+
+/**
+ * # Pinned value
+ * Read only view of value bytes that stay inside of the storage. While there
+ * is at least one view storage doesn't touch the bytes: updates are written
+ * into a new place, evicted and deleted items are kept aside until the last
+ * view is gone. So view could be read without any storage lock, for example
+ * handed to writev as is.
+ *
+ * Views are counted in the item itself, copying or dropping a view is a single
+ * atomic operation. View must not outlive storage it came from.
+ */
+class ValueRef {
+public:
+    ValueRef() : _data(nullptr), _size(0), _refs(nullptr) {}
+
+    /**
+     * Wraps bytes pinned by storage, takes over a reference storage already
+     * added to the counter
+     *
+     * @param data first byte of the value
+     * @param size number of bytes in the value
+     * @param refs counter of views of the item
+     */
+    ValueRef(const char *data, std::size_t size, std::atomic<uint32_t> *refs) : _data(data), _size(size), _refs(refs) {}
+
+    ValueRef(const ValueRef &other) : _data(other._data), _size(other._size), _refs(other._refs) {
+        if (_refs != nullptr) {
+            _refs->fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    ValueRef(ValueRef &&other) : _data(other._data), _size(other._size), _refs(other._refs) {
+        other._data = nullptr;
+        other._size = 0;
+        other._refs = nullptr;
+    }
+
+    ValueRef &operator=(ValueRef other) {
+        std::swap(_data, other._data);
+        std::swap(_size, other._size);
+        std::swap(_refs, other._refs);
+        return *this;
+    }
+
+    ~ValueRef() { Reset(); }
+
+    // Drops the view, storage may reuse the bytes afterwards
+    void Reset() {
+        if (_refs != nullptr) {
+            // Release: reads of the bytes must happen before storage sees the item unpinned
+            _refs->fetch_sub(1, std::memory_order_release);
+        }
+        _data = nullptr;
+        _size = 0;
+        _refs = nullptr;
+    }
+
+    const char *data() const { return _data; }
+    std::size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    std::string str() const { return std::string(_data, _size); }
+
+private:
+    const char *_data;
+    std::size_t _size;
+    std::atomic<uint32_t> *_refs;
+};
+
+} // namespace Afina
+
+#endif // AFINA_VALUE_REF_H
@@ -0,0 +1,76 @@
+#ifndef AFINA_ALLOCATOR_ARENA_H
+#define AFINA_ALLOCATOR_ARENA_H
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * Reserves one big region of address space and hands it out in slabs of fixed size,
+ * the first level of slab allocation: Arena -> SlabCache -> Mempool.
+ *
+ * Region is mapped once, pages get physical memory on the first touch only. Slabs are
+ * aligned to their size, so the slab an object belongs to is found by its address. Slabs
+ * given back are reused by the following Map calls and never returned to the system
+ * until arena is destroyed.
+ *
+ * Arena is shared by all the slab caches, Map and Unmap are thread safe.
+ */
+class Arena {
+public:
+    /**
+     * Throws AllocError of NoMemory type if region can't be mapped
+     *
+     * @param size bytes to reserve, rounded down to slabs but at least a single slab
+     * @param slab_size power of two
+     */
+    Arena(std::size_t size, std::size_t slab_size = default_slab_size);
+    ~Arena();
+
+    // Returns a slab, nullptr if all of them are taken
+    void *Map();
+
+    // Takes slab back
+    void Unmap(void *slab);
+
+    // True if Map would return a slab now
+    bool Available();
+
+    std::size_t SlabSize() const { return _slab_size; }
+
+    // Number of slabs arena has
+    std::size_t Capacity() const { return _capacity; }
+
+    // Number of slabs taken now
+    std::size_t Used();
+
+    static const std::size_t default_slab_size = 1 << 20;
+
+private:
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    const std::size_t _slab_size;
+    std::size_t _capacity;
+
+    // Mapped region and its first slab aligned part
+    void *_region;
+    std::size_t _region_size;
+    char *_begin;
+
+    std::mutex _lock;
+
+    // Slabs that have never been taken start from this one
+    std::size_t _next;
+
+    // Slabs given back
+    std::vector<void *> _free;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_ARENA_H
@@ -0,0 +1,148 @@
+#ifndef AFINA_ALLOCATOR_CONCURRENT_SLAB_ALLOCATOR_H
+#define AFINA_ALLOCATOR_CONCURRENT_SLAB_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <afina/allocator/SlabAllocator.h>
+
+namespace Afina {
+namespace Allocator {
+
+class Arena;
+
+/**
+ * SlabAllocator shared by many threads, with per thread magazines in front of each size class.
+ *
+ * Magazine is a stack of free objects of a single class. Every thread has two of them per
+ * class: allocation pops an object from the loaded one and free pushes it there, so as long as
+ * loaded magazine is neither empty nor full, nothing is shared and no atomics are involved.
+ * Otherwise magazines are swapped, and if that doesn't help either, the thread exchanges a whole
+ * magazine with the depot: it takes a full magazine on allocation and gives its full one away on
+ * free. Depot is a lock-free stack of full magazines per class with a tagged head. Only when
+ * depot is empty the thread takes the lock and fills its magazine from the class mempool by
+ * a batch, and when depot holds depot_limit magazines already the one given away is drained
+ * into mempool, so that slabs could get empty and go to other classes. Class that is out of
+ * slabs drains depots of all the classes for the same reason.
+ *
+ * Objects don't belong to threads, so an object freed by another thread than the one that
+ * allocated it simply joins magazines of the freeing one, and full magazines get back to the
+ * threads that allocate through the depot.
+ *
+ * Thread keeps its magazines until it exits or until it destroys the allocator, allocator state
+ * lives while any thread has magazines of it.
+ *
+ * Slab could be moved from one class to another, see SlabMover: BeginMove stops allocations from
+ * it and asks threads to give their magazines back on their next slow path, owners of objects move
+ * them out and FinishMove returns the slab once all its objects are back.
+ */
+class ConcurrentSlabAllocator {
+public:
+    // Counters of a size class slab mover chooses classes by, cumulative ones grow from the start
+    struct ClassUsage {
+        // Object size of the class
+        std::size_t size;
+
+        std::size_t slabs;
+
+        // Times Allocate of the class found neither free objects nor a slab to take, cumulative
+        std::uint64_t starved;
+
+        // Batches of objects taken by threads from the depot or the mempool, cumulative
+        std::uint64_t refills;
+    };
+
+    /**
+     * @param arena slabs come from
+     * @param min_size size of the smallest class
+     * @param factor ratio of sizes of neighbour classes, bigger than 1
+     */
+    ConcurrentSlabAllocator(std::shared_ptr<Arena> arena, std::size_t min_size = SlabAllocator::default_min_size,
+                            double factor = SlabAllocator::default_factor);
+
+    // Gives magazines of the calling thread back, other threads do that on exit
+    ~ConcurrentSlabAllocator();
+
+    // Returns object of at least size bytes, size must not exceed MaxSize. Returns nullptr if arena is
+    // out of slabs and there are no free objects of that class left
+    void *Allocate(std::size_t size);
+
+    // Takes object back, size is the one it was allocated for
+    void Free(void *object, std::size_t size);
+
+    // True if Allocate of that size would likely succeed now, other threads could take the object first.
+    // Never waits for the lock and changes nothing, so it is cheap to ask on every eviction
+    bool Available(std::size_t size);
+
+    // Number of bytes object allocated for the given size has
+    std::size_t ClassSize(std::size_t size) const;
+
+    // Largest size served, quarter of the slab
+    std::size_t MaxSize() const;
+
+    // Bytes of the slabs taken from the arena
+    std::size_t Reserved();
+
+    std::size_t SlabSize() const;
+
+    // Counters of all the classes in ascending order of sizes
+    std::vector<ClassUsage> Usage();
+
+    /**
+     * Starts moving the coldest slab of the class objects of that size fit into: nothing is allocated
+     * from it anymore and threads give their magazines back. Returns the slab, nullptr if class has
+     * less than two slabs to allocate from
+     */
+    void *BeginMove(std::size_t size);
+
+    /**
+     * Gives back magazines of the calling thread and the depot, returns true if the slab taken by
+     * BeginMove has got all its objects back and is free to go to other classes. Objects that
+     * other threads haven't given back yet keep it, FinishMove could be called again later
+     */
+    bool FinishMove(std::size_t size, void *slab);
+
+    // Counts objects owners have moved out of slabs and dropped, reported by Stats
+    void CountMoved(std::size_t relocated, std::size_t evicted);
+
+    /**
+     * Appends occupancy of slabs to the list, see SlabAllocator::Stats: objects of magazines and of
+     * the depot are reported as used ones. Followed by number of times each class was starved, number
+     * of full magazines in the depot, number of batches magazines were filled by and drained into
+     * mempools, and progress of slab moves: slabs moved, slabs being moved, objects moved out of them
+     * and objects dropped
+     */
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats);
+
+    // Objects a magazine holds
+    static const std::size_t magazine_size = 32;
+
+    // Full magazines depot keeps per class
+    static const std::size_t depot_limit = 8;
+
+private:
+    ConcurrentSlabAllocator(const ConcurrentSlabAllocator &) = delete;
+    ConcurrentSlabAllocator &operator=(const ConcurrentSlabAllocator &) = delete;
+
+    struct Magazine;
+    struct Core;
+    struct ThreadCache;
+
+    // Magazines of the calling thread, created on the first use
+    ThreadCache &Cache();
+
+    // State shared with magazines of threads
+    std::shared_ptr<Core> _core;
+
+    // Magazines of allocators the thread has used
+    static thread_local std::vector<std::unique_ptr<ThreadCache>> _caches;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_CONCURRENT_SLAB_ALLOCATOR_H
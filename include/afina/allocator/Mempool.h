@@ -0,0 +1,96 @@
+#ifndef AFINA_ALLOCATOR_MEMPOOL_H
+#define AFINA_ALLOCATOR_MEMPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Afina {
+namespace Allocator {
+
+class SlabCache;
+
+/**
+ * Objects of a single size, the last level of slab allocation: Arena -> SlabCache -> Mempool.
+ *
+ * Slab starts with a header followed by objects. Free objects of the slab are linked
+ * into its own list, objects that have never been used are cut from the slab tail. Pool
+ * allocates from slabs that have free objects, the ones filled up are set aside until some
+ * object of theirs is freed, and a slab that got empty goes back to the slab cache. Slab
+ * could be drained: it is set aside as well and waits for its objects to be freed.
+ *
+ * That is NOT thread safe implementation!!
+ */
+class Mempool {
+public:
+    /**
+     * @param cache slabs come from, must outlive the pool
+     * @param object_size multiple of 16 that leaves room for at least a single object in a slab
+     */
+    Mempool(SlabCache &cache, std::size_t object_size);
+
+    // Returns all the slabs to the cache, objects that haven't been freed are gone as well
+    ~Mempool();
+
+    // Returns object, nullptr if there is no memory left
+    void *Alloc();
+
+    // Takes object of this pool back
+    void Free(void *object);
+
+    // True if Alloc would return an object without taking a slab, or there is a slab to take
+    bool Available() const;
+
+    // Slab objects were allocated from the longest ago, nullptr if less than two slabs take allocations
+    void *Coldest() const;
+
+    /**
+     * Stops allocations from the slab of this pool, so that it goes back to the cache once its
+     * objects are freed. Slab is counted by Slabs until then
+     */
+    void Drain(void *slab);
+
+    // True if slab is given to Drain and still has objects
+    bool Draining(void *slab) const;
+
+    // Pool object belongs to
+    static Mempool *Of(void *object, std::size_t slab_size);
+
+    std::size_t ObjectSize() const { return _object_size; }
+
+    // Objects a single slab holds
+    std::size_t ObjectsPerSlab() const { return _per_slab; }
+
+    // Slabs pool has and objects allocated from them
+    std::size_t Slabs() const { return _slabs; }
+    std::size_t Used() const { return _used; }
+
+private:
+    Mempool(const Mempool &) = delete;
+    Mempool &operator=(const Mempool &) = delete;
+
+    struct Slab;
+
+    // Moves slab between the lists
+    static void Link(Slab *&list, Slab *slab);
+    static void Unlink(Slab *&list, Slab *slab);
+
+    SlabCache &_cache;
+    const std::size_t _object_size;
+    std::size_t _per_slab;
+
+    // Slabs that have free objects, the ones that haven't and the ones being emptied
+    Slab *_partial;
+    Slab *_full;
+    Slab *_draining;
+
+    std::size_t _slabs;
+    std::size_t _used;
+
+    // Number of allocations made, slabs remember it to tell the cold ones
+    std::uint64_t _ticks;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_MEMPOOL_H
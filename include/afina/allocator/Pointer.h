@@ -7,6 +7,11 @@ namespace Allocator {
 // to avoid expensive macros calculations and increase compile speed
 class Simple;
 
+/**
+ * Handle of a block allocated by Simple. Refers to a slot of the allocator table rather than to the
+ * block itself, so it stays valid when block is moved. Copies refer to the same slot, empty Pointer
+ * refers to none.
+ */
 class Pointer {
 public:
     Pointer();
@@ -17,7 +22,15 @@ public:
     Pointer &operator=(const Pointer &);
     Pointer &operator=(Pointer &&);
 
-    void *get() const { return 0; }
+    // Current address of the block, nullptr for empty Pointer. Address changes on realloc and defrag
+    void *get() const { return _slot == nullptr ? nullptr : *_slot; }
+
+private:
+    friend class Simple;
+
+    explicit Pointer(void **slot) : _slot(slot) {}
+
+    void **_slot;
 };
 
 } // namespace Allocator
@@ -0,0 +1,69 @@
+#ifndef AFINA_ALLOCATOR_REGION_H
+#define AFINA_ALLOCATOR_REGION_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace Afina {
+namespace Allocator {
+
+class Arena;
+
+/**
+ * Allocator of short living objects freed all at once, like region of tarantool: objects are cut
+ * one after another from slabs of the shared arena, and Reset gives them all back in O(slabs).
+ * Suits memory of a single request or connection, for example containers of StlAllocator.
+ *
+ * Free takes back only the object allocated last, so temporaries freed in reverse order don't
+ * waste the region, memory of others stays taken until Reset.
+ *
+ * That is NOT thread safe implementation!! Threads sharing an arena should have region each.
+ */
+class Region {
+public:
+    explicit Region(std::shared_ptr<Arena> arena);
+
+    // Returns all the slabs to the arena, objects must not be used afterwards
+    ~Region();
+
+    // Returns object of at least size bytes aligned to 16, size must not exceed MaxSize. Empty
+    // object gets its own address as well. Returns nullptr if arena is out of slabs
+    void *Allocate(std::size_t size);
+
+    // Takes object back if it is the last one allocated, does nothing otherwise
+    void Free(void *object, std::size_t size);
+
+    // Frees all the objects, the first slab is kept for the following ones
+    void Reset();
+
+    // Largest size served, the whole slab
+    std::size_t MaxSize() const { return _slab_size; }
+
+    // Bytes of objects allocated since the last Reset
+    std::size_t Used() const { return _used; }
+
+    // Slabs taken from the arena
+    std::size_t Slabs() const { return _slabs.size(); }
+
+private:
+    Region(const Region &) = delete;
+    Region &operator=(const Region &) = delete;
+
+    std::shared_ptr<Arena> _arena;
+    const std::size_t _slab_size;
+
+    // Slabs in order they were taken, objects are cut from the last one
+    std::vector<char *> _slabs;
+
+    // Free part of the last slab
+    char *_top;
+    char *_end;
+
+    std::size_t _used;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_REGION_H
@@ -1,8 +1,9 @@
 #ifndef AFINA_ALLOCATOR_SIMPLE_H
 #define AFINA_ALLOCATOR_SIMPLE_H
 
-#include <string>
 #include <cstddef>
+#include <cstdint>
+#include <string>
 
 namespace Afina {
 namespace Allocator {
@@ -18,44 +19,119 @@ class Pointer;
  * Allocator instance doesn't take ownership of wrapped memmory and do not delete it
  * on destruction. So caller must take care of resource cleaup after allocator stop
  * being needs
+ *
+ * Area is split in two parts growing towards each other: blocks from the bottom and the table of
+ * handles from the top. Pointer refers to a slot of the table and the slot holds address of the block,
+ * so defrag could move blocks and fix a single slot per block. Free space between the last block and
+ * the table is the wilderness, blocks are cut from it once free lists have nothing that fits.
+ *
+ * Every block starts with a word of its size and flags, followed by the slot of its owner when in use.
+ * Free block keeps links of the free list instead and copy of the size in its last word, so free
+ * neighbours are merged on free in O(1). Free blocks of sizes below 512 bytes are kept in lists of exact
+ * size, bigger ones in lists of quarters of power of two ranges. Allocation takes the best fit among the
+ * first blocks of the list of its own range and the first block of any bigger list otherwise.
+ *
+ * Blocks move on defrag, so it can't back allocators of the C++ standard that hand out raw pointers,
+ * StlAllocator works over Region and slab allocators instead.
  */
-// TODO: Implements interface to allow usage as C++ allocators
 class Simple {
 public:
     Simple(void *base, const size_t size);
 
     /**
-     * TODO: semantics
+     * Allocates block of at least N bytes, its address could change on realloc and defrag but
+     * Pointer always follows it. Allocation of 0 bytes returns empty Pointer
+     *
+     * Throws AllocError of NoMemory type if there is no free space of that size, fragmented memory
+     * could be joined by defrag
+     *
      * @param N size_t
      */
     Pointer alloc(size_t N);
 
     /**
-     * TODO: semantics
+     * Changes size of the block to N bytes keeping the first bytes of its content. Block is resized in
+     * place if it shrinks or the next block is free, otherwise content is moved to a new block. Empty
+     * Pointer gets a new block, size of 0 frees the block
+     *
+     * Throws AllocError of NoMemory type if there is no space, block stays unchanged, and of InvalidFree
+     * type if Pointer doesn't refer to a block of this allocator
+     *
      * @param p Pointer
      * @param N size_t
      */
     void realloc(Pointer &p, size_t N);
 
     /**
-     * TODO: semantics
+     * Releases the block and empties Pointer. Other copies of the Pointer must not be used afterwards,
+     * slot they refer to is given to the next allocation. Empty Pointer is ignored
+     *
+     * Throws AllocError of InvalidFree type if Pointer doesn't refer to a block of this allocator
+     *
      * @param p Pointer
      */
     void free(Pointer &p);
 
     /**
-     * TODO: semantics
+     * Moves all blocks to the beginning of the area keeping their order, so all the free space makes a
+     * single wilderness. Addresses got from Pointer::get before the call are no longer valid
      */
     void defrag();
 
     /**
-     * TODO: semantics
+     * Text description of the area: one line per block with its offset, size and state, followed by the
+     * wilderness and the table of handles
      */
     std::string dump() const;
 
 private:
+    struct Block;
+
+    // Size of the block that holds N bytes, 0 if there is no such size
+    std::size_t BlockSize(std::size_t N) const;
+
+    // Takes slot of the table, grows table if there are no free ones. Returns nullptr if there is no space
+    void **TakeSlot();
+
+    // Takes block of the given size out of free lists or wilderness, returns nullptr if there is none
+    Block *TakeBlock(std::size_t size);
+
+    // Marks free block as used, part of it that isn't needed goes back to free lists
+    void UseBlock(Block *block, std::size_t size);
+
+    // Returns used block to free lists merging it with free neighbours or wilderness
+    void ReleaseBlock(Block *block);
+
+    // Block Pointer refers to, throws AllocError if there is none
+    Block *BlockOf(const Pointer &p) const;
+
+    // Free lists maintenance
+    static std::size_t ListOf(std::size_t size);
+    void Link(Block *block);
+    void Unlink(Block *block);
+
     void *_base;
     const size_t _base_len;
+
+    // Aligned bounds of the area
+    char *_begin;
+    char *_end;
+
+    // End of the last block and the first slot of the table, wilderness lies between
+    char *_heap_end;
+    char *_table;
+
+    // Free slots of the table, each one keeps address of the next
+    void **_free_slots;
+
+    // Heads of free lists and bitmap of non empty ones
+    static const std::size_t exact_lists = 32;
+    static const std::size_t list_count = 256;
+    Block *_lists[list_count];
+    uint64_t _list_map[list_count / 64];
+
+    // Number of blocks looked at for the best fit
+    static const std::size_t best_fit_scan = 16;
 };
 
 } // namespace Allocator
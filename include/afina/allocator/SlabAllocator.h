@@ -0,0 +1,102 @@
+#ifndef AFINA_ALLOCATOR_SLAB_ALLOCATOR_H
+#define AFINA_ALLOCATOR_SLAB_ALLOCATOR_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <afina/allocator/Mempool.h>
+#include <afina/allocator/SlabCache.h>
+
+namespace Afina {
+namespace Allocator {
+
+class Arena;
+
+/**
+ * Allocator of objects of any size up to MaxSize over the shared arena: every size is
+ * rounded up to the nearest of geometric size classes, and each class is a mempool of
+ * its own over the slab cache of this allocator. Each class is factor times bigger than
+ * the previous one, so rounding wastes at most that part of an object.
+ *
+ * That is NOT thread safe implementation!! Threads sharing an arena should have allocator
+ * each.
+ */
+class SlabAllocator {
+public:
+    /**
+     * @param arena slabs come from
+     * @param min_size size of the smallest class
+     * @param factor ratio of sizes of neighbour classes, bigger than 1
+     */
+    SlabAllocator(std::shared_ptr<Arena> arena, std::size_t min_size = default_min_size,
+                  double factor = default_factor);
+
+    // Returns object of at least size bytes, size must not exceed MaxSize. Returns nullptr if arena is
+    // out of slabs
+    void *Allocate(std::size_t size);
+
+    // Takes object back, size is the one it was allocated for
+    void Free(void *object, std::size_t size);
+
+    // True if Allocate of that size would succeed now
+    bool Available(std::size_t size) const;
+
+    // Number of bytes object allocated for the given size has
+    std::size_t ClassSize(std::size_t size) const { return _pools[ClassOf(size)]->ObjectSize(); }
+
+    // Largest size served, quarter of the slab
+    std::size_t MaxSize() const { return _pools.back()->ObjectSize(); }
+
+    // Number of size classes
+    std::size_t Classes() const { return _pools.size(); }
+
+    // Index of the smallest class objects of that size fit into
+    std::size_t ClassOf(std::size_t size) const;
+
+    // Object size of the class with the given index
+    std::size_t ClassObjectSize(std::size_t index) const { return _pools[index]->ObjectSize(); }
+
+    // Slabs class with the given index has
+    std::size_t ClassSlabs(std::size_t index) const { return _pools[index]->Slabs(); }
+
+    /**
+     * Drains the coldest slab of the class with the given index, see Mempool::Drain. Returns the slab,
+     * nullptr if class has less than two slabs not being drained already
+     */
+    void *DrainColdest(std::size_t index);
+
+    // True while slab taken by DrainColdest has objects of the class
+    bool Draining(std::size_t index, void *slab) const { return _pools[index]->Draining(slab); }
+
+    std::size_t SlabSize() const { return _cache.SlabSize(); }
+
+    // Bytes of the slabs taken from the arena
+    std::size_t Reserved() const { return _cache.Slabs() * _cache.SlabSize(); }
+
+    /**
+     * Appends occupancy of slabs to the list, see Storage::Stats: slabs and spare slabs
+     * allocator has, and per class number of slabs, objects in use and free objects in
+     * those slabs
+     */
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) const;
+
+    static const std::size_t default_min_size = 64;
+    static constexpr double default_factor = 1.25;
+
+private:
+    SlabAllocator(const SlabAllocator &) = delete;
+    SlabAllocator &operator=(const SlabAllocator &) = delete;
+
+    SlabCache _cache;
+
+    // One pool per class in ascending order of sizes
+    std::vector<std::unique_ptr<Mempool>> _pools;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_SLAB_ALLOCATOR_H
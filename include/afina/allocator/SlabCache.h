@@ -0,0 +1,62 @@
+#ifndef AFINA_ALLOCATOR_SLAB_CACHE_H
+#define AFINA_ALLOCATOR_SLAB_CACHE_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace Afina {
+namespace Allocator {
+
+class Arena;
+
+/**
+ * Slabs of a single owner, the second level of slab allocation: Arena -> SlabCache -> Mempool.
+ *
+ * Takes slabs from the shared arena for mempools and keeps a few empty ones given back, so
+ * that a pool which frees and takes a slab back and forth doesn't go to the arena every
+ * time. Slabs above that are returned to the arena for other caches to use.
+ *
+ * That is NOT thread safe implementation!!
+ */
+class SlabCache {
+public:
+    explicit SlabCache(std::shared_ptr<Arena> arena);
+
+    // Returns spare slabs to the arena, slabs of mempools must be given back before
+    ~SlabCache();
+
+    // Returns a slab, nullptr if arena is out of them
+    void *Get();
+
+    // Takes empty slab back
+    void Put(void *slab);
+
+    // True if Get would return a slab now
+    bool Available() const;
+
+    std::size_t SlabSize() const { return _slab_size; }
+
+    // Slabs taken from the arena, including spare ones
+    std::size_t Slabs() const { return _slabs; }
+
+    // Empty slabs kept for reuse
+    std::size_t Spare() const { return _spare.size(); }
+
+    // Number of empty slabs kept
+    static const std::size_t max_spare = 2;
+
+private:
+    SlabCache(const SlabCache &) = delete;
+    SlabCache &operator=(const SlabCache &) = delete;
+
+    std::shared_ptr<Arena> _arena;
+    const std::size_t _slab_size;
+    std::size_t _slabs;
+    std::vector<void *> _spare;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_SLAB_CACHE_H
@@ -0,0 +1,104 @@
+#ifndef AFINA_ALLOCATOR_SLAB_MOVER_H
+#define AFINA_ALLOCATOR_SLAB_MOVER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <afina/allocator/ConcurrentSlabAllocator.h>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * Background thread that moves slabs between size classes of ConcurrentSlabAllocator as sizes
+ * of objects change, so that memory doesn't stay in classes nobody allocates from anymore.
+ *
+ * Every pass it looks at how many times each class was starved since the previous pass, that is
+ * had no memory for the object asked for, and for how many passes each class hasn't taken a
+ * single batch of objects. If some class was starved, the oldest of classes that weren't gives
+ * its coldest slab away: allocator stops allocations from the slab, client moves objects it holds
+ * there to other slabs of the class or drops them, and once all objects are back the slab is free
+ * for the starved class to take. Objects that threads keep in magazines hold the slab until these
+ * threads give them back, the move is finished by one of the following passes then. Client could
+ * spread vacating a slab over several passes as well, so that no pass holds it busy for long.
+ *
+ * Progress is reported by ConcurrentSlabAllocator::Stats.
+ */
+class SlabMover {
+public:
+    // Owner of objects of the allocator
+    class Client {
+    public:
+        virtual ~Client() {}
+
+        /**
+         * Moves every object of the allocator it holds in the slab into another object of the same
+         * class or frees it. Adds numbers of objects moved and freed. Client could do that in parts:
+         * returns false if it stopped early and has to be called again on the next pass, true once it
+         * has looked at all of its objects. Called from the mover thread
+         *
+         * @param slab first byte of the slab
+         * @param size slab size
+         * @param restart true on the first call for the slab, false when the move is resumed or retried
+         */
+        virtual bool Vacate(const char *slab, std::size_t size, bool restart, std::size_t &relocated,
+                            std::size_t &evicted) = 0;
+    };
+
+    /**
+     * @param allocator slabs of which are moved
+     * @param client all the objects of allocator belong to, must outlive the mover
+     * @param interval milliseconds between passes
+     */
+    SlabMover(std::shared_ptr<ConcurrentSlabAllocator> allocator, Client &client, uint32_t interval);
+    ~SlabMover();
+
+    // Starts background passes
+    void Start();
+
+    // Stops background passes, a move in progress stays unfinished
+    void Stop();
+
+    // Single pass, returns true if a slab has been freed by it
+    bool Step();
+
+    // Passes class must go without taking objects to give a slab away
+    static const uint32_t min_age = 2;
+
+private:
+    SlabMover(const SlabMover &) = delete;
+    SlabMover &operator=(const SlabMover &) = delete;
+
+    // Background thread body
+    void OnRun();
+
+    // Index of the class to take a slab from, size of usage if there is none
+    std::size_t Donor(const std::vector<ConcurrentSlabAllocator::ClassUsage> &usage, std::size_t starved) const;
+
+    std::shared_ptr<ConcurrentSlabAllocator> _allocator;
+    Client &_client;
+    const uint32_t _interval;
+
+    // Counters seen by the previous pass and number of passes each class hasn't taken objects for
+    std::vector<ConcurrentSlabAllocator::ClassUsage> _last;
+    std::vector<uint32_t> _ages;
+
+    // Slab being moved and its object size, null if there is none
+    void *_slab;
+    std::size_t _slab_class;
+
+    std::thread _thread;
+    std::mutex _lock;
+    std::condition_variable _stop_requested;
+    bool _running;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_SLAB_MOVER_H
@@ -0,0 +1,100 @@
+#ifndef AFINA_ALLOCATOR_STL_ALLOCATOR_H
+#define AFINA_ALLOCATOR_STL_ALLOCATOR_H
+
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * Allocator of the C++ standard over allocators of afina, so that std::vector, std::basic_string,
+ * std::map and others take memory from a Region, SlabAllocator or ConcurrentSlabAllocator:
+ *
+ *   Region region(arena);
+ *   std::vector<int, StlAllocator<int, Region>> numbers(StlAllocator<int, Region>(region));
+ *
+ * Source is any class with methods void *Allocate(size_t), void Free(void *, size_t) and
+ * size_t MaxSize() const, Allocate returns nullptr if it is out of memory and the memory is aligned
+ * to 16. Blocks bigger than MaxSize come from the global operator new instead.
+ *
+ * Instance refers to the source and doesn't own it, so the source must outlive all the containers.
+ * Instances are equal if they share the source. Containers take the allocator of the other one on
+ * copy and move assignment and on swap, so memory is always given back to the source it came from.
+ * Allocator is thread safe as long as the source is.
+ */
+template <typename T, typename Source> class StlAllocator {
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+    template <typename U> struct rebind { using other = StlAllocator<U, Source>; };
+
+    static_assert(alignof(T) <= 16, "Sources align memory to 16 only");
+
+    explicit StlAllocator(Source &source) noexcept : _source(&source) {}
+
+    template <typename U> StlAllocator(const StlAllocator<U, Source> &other) noexcept : _source(&other.source()) {}
+
+    /**
+     * Returns memory for n objects, throws std::bad_alloc if the source is out of memory
+     *
+     * @param n size_t
+     */
+    T *allocate(std::size_t n) {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+            throw std::bad_alloc();
+        }
+        std::size_t size = n * sizeof(T);
+        void *p = size > _source->MaxSize() ? ::operator new(size) : _source->Allocate(size);
+        if (p == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T *>(p);
+    }
+
+    /**
+     * Gives memory back to the source
+     *
+     * @param p memory returned by allocate of an equal instance
+     * @param n size_t passed to allocate
+     */
+    void deallocate(T *p, std::size_t n) noexcept {
+        std::size_t size = n * sizeof(T);
+        if (size > _source->MaxSize()) {
+            ::operator delete(p);
+        } else {
+            _source->Free(p, size);
+        }
+    }
+
+    // Containers copied take the same source
+    StlAllocator select_on_container_copy_construction() const noexcept { return *this; }
+
+    Source &source() const noexcept { return *_source; }
+
+private:
+    Source *_source;
+};
+
+template <typename T, typename U, typename Source>
+bool operator==(const StlAllocator<T, Source> &a, const StlAllocator<U, Source> &b) noexcept {
+    return &a.source() == &b.source();
+}
+
+template <typename T, typename U, typename Source>
+bool operator!=(const StlAllocator<T, Source> &a, const StlAllocator<U, Source> &b) noexcept {
+    return !(a == b);
+}
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_STL_ALLOCATOR_H
@@ -0,0 +1,37 @@
+#ifndef AFINA_EXECUTE_CACHE_MEMLIMIT_H
+#define AFINA_EXECUTE_CACHE_MEMLIMIT_H
+
+#include <cstdint>
+#include <string>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Change memory limit
+ * Sets new limit of memory storage could take, in megabytes. Storage shrinks to the
+ * smaller limit gradually, in background of the following commands.
+ *
+ * Command must write result to the output, which could be:
+ * - "OK" to indicate success
+ * - "SERVER_ERROR ..." if storage can't be resized
+ */
+class CacheMemlimit : public Command {
+public:
+    CacheMemlimit(uint64_t megabytes) : _megabytes(megabytes) {}
+    ~CacheMemlimit() {}
+
+    inline const uint64_t megabytes() const { return _megabytes; }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    const uint64_t _megabytes;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_CACHE_MEMLIMIT_H
@@ -1,6 +1,7 @@
 #ifndef AFINA_EXECUTE_GET_H
 #define AFINA_EXECUTE_GET_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -18,13 +19,15 @@ namespace Execute {
  * the items have been transmitted, the server sends the string
  *
  * Each item sent by the server looks like this:
- * VALUE <key> <bytes>\r\n
+ * VALUE <key> <flags> <bytes> [<cas unique>]\r\n
  * <data>\r\n
  * VALUE ....
  * END
  *
- * Where <key> is the key for the value, <bytes> is the number of bytes in the
- * value and <data> is the value text
+ * Where <key> is the key for the value, <flags> are the client flags given when
+ * value was stored, <bytes> is the number of bytes in the value and <data> is
+ * the value text. <cas unique> is the version of the item, it is sent by "gets"
+ * only and could be passed to "cas" command later
  *
  * If some of the keys appearing in a retrieval request are not sent back
  * by the server in the item list this means that the server does not
@@ -34,15 +37,19 @@ namespace Execute {
  */
 class Get : public Command {
 public:
-    Get(const std::vector<std::string> &keys) : _keys(keys) {}
+    Get(const std::vector<std::string> &keys, bool cas = false) : _keys(keys), _cas(cas) {}
     ~Get() {}
 
     inline const std::vector<std::string> &keys() const { return _keys; }
+    inline bool cas() const { return _cas; }
 
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
 
 private:
     std::vector<std::string> _keys;
+
+    // Whether item versions are reported
+    bool _cas;
 };
 
 } // namespace Execute
@@ -2,6 +2,7 @@
 #define AFINA_EXECUTE_INSERT_COMMAND_H
 
 #include <cstdint>
+#include <ctime>
 #include <string>
 
 #include "Command.h"
@@ -23,6 +24,13 @@ public:
     inline const int32_t expire() const { return _expire; }
 
 protected:
+    /**
+     * Converts memcached <exptime> into unix time item expires at: 0 stays 0 (never expires),
+     * values up to 30 days are offsets from now, bigger ones are unix time already. Negative
+     * values give time in the past, so that item expires immediately
+     */
+    time_t Deadline() const;
+
     const std::string _key;
     const uint32_t _flags;
     const int32_t _expire;
@@ -18,6 +18,8 @@ namespace Execute {
  * - "STORED", to indicate success.
  * - "NOT_STORED" to indicate the data was not stored, but not because of an
  * error. This normally means that the condition for the command wasn't met.
+ * For set that is storage rejecting the item: it is too big, there is no memory
+ * left for it or it can't be logged.
  */
 class Set : public InsertCommand {
 public:
@@ -0,0 +1,68 @@
+#include <afina/allocator/Arena.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <sys/mman.h>
+
+#include <afina/allocator/Error.h>
+
+namespace Afina {
+namespace Allocator {
+
+const std::size_t Arena::default_slab_size;
+
+// See Arena.h
+Arena::Arena(std::size_t size, std::size_t slab_size)
+    : _slab_size(slab_size), _capacity(std::max<std::size_t>(size / slab_size, 1)), _next(0) {
+    // Extra slab leaves room to align the beginning
+    _region_size = (_capacity + 1) * _slab_size;
+    _region = mmap(nullptr, _region_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (_region == MAP_FAILED) {
+        throw AllocError(AllocErrorType::NoMemory,
+                         "Failed to reserve " + std::to_string(_region_size) + " bytes: " + std::strerror(errno));
+    }
+    uintptr_t begin = (reinterpret_cast<uintptr_t>(_region) + _slab_size - 1) & ~uintptr_t(_slab_size - 1);
+    _begin = reinterpret_cast<char *>(begin);
+}
+
+// See Arena.h
+Arena::~Arena() { munmap(_region, _region_size); }
+
+// See Arena.h
+void *Arena::Map() {
+    std::lock_guard<std::mutex> lock(_lock);
+    if (!_free.empty()) {
+        void *slab = _free.back();
+        _free.pop_back();
+        return slab;
+    }
+    if (_next == _capacity) {
+        return nullptr;
+    }
+    return _begin + _slab_size * _next++;
+}
+
+// See Arena.h
+void Arena::Unmap(void *slab) {
+    std::lock_guard<std::mutex> lock(_lock);
+    _free.push_back(slab);
+}
+
+// See Arena.h
+bool Arena::Available() {
+    std::lock_guard<std::mutex> lock(_lock);
+    return !_free.empty() || _next != _capacity;
+}
+
+// See Arena.h
+std::size_t Arena::Used() {
+    std::lock_guard<std::mutex> lock(_lock);
+    return _next - _free.size();
+}
+
+} // namespace Allocator
+} // namespace Afina
@@ -0,0 +1,452 @@
+#include <afina/allocator/ConcurrentSlabAllocator.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include <afina/allocator/Arena.h>
+#include <afina/allocator/Error.h>
+
+namespace Afina {
+namespace Allocator {
+
+const std::size_t ConcurrentSlabAllocator::magazine_size;
+const std::size_t ConcurrentSlabAllocator::depot_limit;
+
+thread_local std::vector<std::unique_ptr<ConcurrentSlabAllocator::ThreadCache>> ConcurrentSlabAllocator::_caches;
+
+// Free objects of a single class, magazines themselves are reused for any class
+struct ConcurrentSlabAllocator::Magazine {
+    Magazine() : next(nullptr), count(0) {}
+
+    // Next magazine in the stack
+    std::atomic<Magazine *> next;
+
+    std::size_t count;
+    void *objects[magazine_size];
+};
+
+struct ConcurrentSlabAllocator::Core {
+    Core(std::shared_ptr<Arena> arena, std::size_t min_size, double factor)
+        : pools(std::move(arena), min_size, factor), depots(new Depot[pools.Classes()]), generation(0), refills(0),
+          drains(0), moved(0), moving(0), relocated(0), evicted(0) {
+        Publish();
+    }
+
+    ~Core() {
+        for (Magazine *magazine : magazines) {
+            delete magazine;
+        }
+    }
+
+    /**
+     * Treiber stack of magazines. Head keeps pointer in the lower 48 bits and tag in the upper
+     * 16 ones, tag changes on every push and pop. Magazines are never freed while allocator lives,
+     * so a thread that reads next of the head already taken by another one reads valid memory, and
+     * if that magazine is pushed back meanwhile, tag makes compare and exchange fail instead of
+     * linking a stale next (ABA)
+     */
+    class Stack {
+    public:
+        Stack() : _head(0) {}
+
+        void Push(Magazine *magazine) {
+            std::uint64_t head = _head.load(std::memory_order_relaxed);
+            do {
+                magazine->next.store(Pointer(head), std::memory_order_relaxed);
+            } while (!_head.compare_exchange_weak(head, Pack(magazine, head), std::memory_order_release,
+                                                  std::memory_order_relaxed));
+        }
+
+        // Returns nullptr if stack is empty
+        Magazine *Pop() {
+            std::uint64_t head = _head.load(std::memory_order_acquire);
+            while (Magazine *magazine = Pointer(head)) {
+                Magazine *next = magazine->next.load(std::memory_order_relaxed);
+                if (_head.compare_exchange_weak(head, Pack(next, head), std::memory_order_acquire,
+                                                std::memory_order_acquire)) {
+                    return magazine;
+                }
+            }
+            return nullptr;
+        }
+
+        // Bits of the head taken by the tag
+        static const int tag_shift = 48;
+
+    private:
+        static Magazine *Pointer(std::uint64_t head) {
+            return reinterpret_cast<Magazine *>(head & ((std::uint64_t(1) << tag_shift) - 1));
+        }
+
+        // New head pointing to the magazine with tag of the old one incremented
+        static std::uint64_t Pack(Magazine *magazine, std::uint64_t head) {
+            return reinterpret_cast<std::uintptr_t>(magazine) | (((head >> tag_shift) + 1) << tag_shift);
+        }
+
+        std::atomic<std::uint64_t> _head;
+    };
+
+    // Full magazines of a single class
+    struct Depot {
+        Depot() : count(0), pooled(false), starved(0), refills(0) {}
+
+        Stack full;
+
+        // Magazines in the stack, could be ahead of the stack a bit
+        std::atomic<std::size_t> count;
+
+        // Mempool had free objects of the class or could take a slab for them when it was last looked at
+        std::atomic<bool> pooled;
+
+        // See ClassUsage
+        std::atomic<std::uint64_t> starved;
+        std::atomic<std::uint64_t> refills;
+    };
+
+    // Returns an empty magazine
+    Magazine *Empty() {
+        Magazine *magazine = empty.Pop();
+        if (magazine != nullptr) {
+            return magazine;
+        }
+
+        magazine = new Magazine();
+        if (reinterpret_cast<std::uintptr_t>(magazine) >> Stack::tag_shift != 0) {
+            delete magazine;
+            throw AllocError(AllocErrorType::NoMemory, "Magazine address doesn't fit into 48 bits");
+        }
+        std::lock_guard<std::mutex> guard(lock);
+        magazines.push_back(magazine);
+        return magazine;
+    }
+
+    // Gives full magazine to the depot, drains it into the mempool if depot has enough of them already
+    void GiveFull(Magazine *magazine, std::size_t index) {
+        Depot &depot = depots[index];
+        if (depot.count.fetch_add(1, std::memory_order_relaxed) < depot_limit) {
+            depot.full.Push(magazine);
+            return;
+        }
+        depot.count.fetch_sub(1, std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> guard(lock);
+        Drain(magazine, index);
+        Publish();
+    }
+
+    // Fills half of the empty magazine from the mempool, returns false if there are no objects left
+    bool Refill(Magazine *magazine, std::size_t index) {
+        std::lock_guard<std::mutex> guard(lock);
+        std::size_t size = pools.ClassObjectSize(index);
+        if (!pools.Available(size)) {
+            Reclaim();
+        }
+        while (magazine->count < magazine_size / 2) {
+            void *object = pools.Allocate(size);
+            if (object == nullptr) {
+                break;
+            }
+            magazine->objects[magazine->count++] = object;
+        }
+        Publish();
+        if (magazine->count == 0) {
+            return false;
+        }
+        refills++;
+        return true;
+    }
+
+    // Objects of the magazine go back to the mempool and magazine to the empty ones, must be called under lock
+    void Drain(Magazine *magazine, std::size_t index) {
+        std::size_t size = pools.ClassObjectSize(index);
+        for (std::size_t i = 0; i < magazine->count; i++) {
+            pools.Free(magazine->objects[i], size);
+        }
+        drains++;
+        magazine->count = 0;
+        empty.Push(magazine);
+    }
+
+    // Drains all the depots, so that slabs they keep busy could go to the class that has run out of them.
+    // Must be called under lock
+    void Reclaim() {
+        for (std::size_t i = 0; i < pools.Classes(); i++) {
+            while (Magazine *magazine = depots[i].full.Pop()) {
+                depots[i].count.fetch_sub(1, std::memory_order_relaxed);
+                Drain(magazine, i);
+            }
+        }
+    }
+
+    // Records which classes mempools could serve now, so that Available doesn't need the lock. Must be
+    // called under lock whenever mempools change
+    void Publish() {
+        for (std::size_t i = 0; i < pools.Classes(); i++) {
+            depots[i].pooled.store(pools.Available(pools.ClassObjectSize(i)), std::memory_order_relaxed);
+        }
+    }
+
+    // Guards mempools and the list of magazines
+    std::mutex lock;
+
+    // Sizes of classes are set on construction and could be read without the lock
+    SlabAllocator pools;
+
+    // All the magazines created, they are freed along with the allocator only
+    std::vector<Magazine *> magazines;
+
+    // One depot per class
+    std::unique_ptr<Depot[]> depots;
+
+    // Empty magazines of any class
+    Stack empty;
+
+    // Threads give all their magazines back once they see it changed
+    std::atomic<std::uint64_t> generation;
+
+    // Batches taken from mempools and given back to them, slabs moved, being moved and objects moved out
+    // of them and dropped, guarded by lock
+    std::uint64_t refills;
+    std::uint64_t drains;
+    std::uint64_t moved;
+    std::uint64_t moving;
+    std::uint64_t relocated;
+    std::uint64_t evicted;
+};
+
+// Magazines of a single thread, loaded one takes objects first
+struct ConcurrentSlabAllocator::ThreadCache {
+    explicit ThreadCache(std::shared_ptr<Core> core)
+        : core(std::move(core)), loaded(this->core->pools.Classes(), nullptr),
+          previous(this->core->pools.Classes(), nullptr),
+          generation(this->core->generation.load(std::memory_order_relaxed)) {}
+
+    ~ThreadCache() { Flush(); }
+
+    // Gives all the magazines back
+    void Flush() {
+        for (std::size_t i = 0; i < loaded.size(); i++) {
+            GiveBack(loaded[i], i);
+            GiveBack(previous[i], i);
+            loaded[i] = previous[i] = nullptr;
+        }
+        generation = core->generation.load(std::memory_order_relaxed);
+    }
+
+    // Flushes magazines if allocator asked for that since the last time, called on slow paths only
+    void Check() {
+        if (generation != core->generation.load(std::memory_order_relaxed)) {
+            Flush();
+        }
+    }
+
+    void GiveBack(Magazine *magazine, std::size_t index) {
+        if (magazine == nullptr) {
+            return;
+        }
+        if (magazine->count == 0) {
+            core->empty.Push(magazine);
+        } else {
+            core->GiveFull(magazine, index);
+        }
+    }
+
+    std::shared_ptr<Core> core;
+    std::vector<Magazine *> loaded;
+    std::vector<Magazine *> previous;
+
+    // Core generation magazines were flushed at
+    std::uint64_t generation;
+};
+
+// See ConcurrentSlabAllocator.h
+ConcurrentSlabAllocator::ConcurrentSlabAllocator(std::shared_ptr<Arena> arena, std::size_t min_size, double factor)
+    : _core(std::make_shared<Core>(std::move(arena), min_size, factor)) {
+    static_assert(sizeof(void *) == sizeof(std::uint64_t), "Tagged heads need 64 bit pointers");
+}
+
+// See ConcurrentSlabAllocator.h
+ConcurrentSlabAllocator::~ConcurrentSlabAllocator() {
+    auto it = std::find_if(_caches.begin(), _caches.end(),
+                           [this](const std::unique_ptr<ThreadCache> &cache) { return cache->core == _core; });
+    if (it != _caches.end()) {
+        _caches.erase(it);
+    }
+}
+
+// See ConcurrentSlabAllocator.h
+void *ConcurrentSlabAllocator::Allocate(std::size_t size) {
+    std::size_t index = _core->pools.ClassOf(size);
+    ThreadCache &cache = Cache();
+    Magazine *&loaded = cache.loaded[index];
+    if (loaded != nullptr && loaded->count != 0) {
+        return loaded->objects[--loaded->count];
+    }
+
+    cache.Check();
+    Magazine *&previous = cache.previous[index];
+    Core::Depot &depot = _core->depots[index];
+    if (previous != nullptr && previous->count != 0) {
+        std::swap(loaded, previous);
+    } else if (Magazine *full = depot.full.Pop()) {
+        depot.count.fetch_sub(1, std::memory_order_relaxed);
+        depot.refills.fetch_add(1, std::memory_order_relaxed);
+        if (previous != nullptr) {
+            _core->empty.Push(previous);
+        }
+        previous = loaded;
+        loaded = full;
+    } else {
+        if (loaded == nullptr) {
+            loaded = _core->Empty();
+        }
+        if (!_core->Refill(loaded, index)) {
+            depot.starved.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        depot.refills.fetch_add(1, std::memory_order_relaxed);
+    }
+    return loaded->objects[--loaded->count];
+}
+
+// See ConcurrentSlabAllocator.h
+void ConcurrentSlabAllocator::Free(void *object, std::size_t size) {
+    std::size_t index = _core->pools.ClassOf(size);
+    ThreadCache &cache = Cache();
+    Magazine *&loaded = cache.loaded[index];
+    if (loaded != nullptr && loaded->count < magazine_size) {
+        loaded->objects[loaded->count++] = object;
+        return;
+    }
+
+    cache.Check();
+    Magazine *&previous = cache.previous[index];
+    if (loaded == nullptr) {
+        loaded = _core->Empty();
+    } else if (previous != nullptr && previous->count < magazine_size) {
+        std::swap(loaded, previous);
+    } else {
+        if (previous != nullptr) {
+            _core->GiveFull(previous, index);
+        }
+        previous = loaded;
+        loaded = _core->Empty();
+    }
+    loaded->objects[loaded->count++] = object;
+}
+
+// See ConcurrentSlabAllocator.h
+bool ConcurrentSlabAllocator::Available(std::size_t size) {
+    std::size_t index = _core->pools.ClassOf(size);
+    ThreadCache &cache = Cache();
+    if ((cache.loaded[index] != nullptr && cache.loaded[index]->count != 0) ||
+        (cache.previous[index] != nullptr && cache.previous[index]->count != 0) ||
+        _core->depots[index].count.load(std::memory_order_relaxed) != 0) {
+        return true;
+    }
+
+    // Depots of other classes are drained into mempools only once allocation really fails
+    return _core->depots[index].pooled.load(std::memory_order_relaxed);
+}
+
+// See ConcurrentSlabAllocator.h
+std::size_t ConcurrentSlabAllocator::ClassSize(std::size_t size) const { return _core->pools.ClassSize(size); }
+
+// See ConcurrentSlabAllocator.h
+std::size_t ConcurrentSlabAllocator::MaxSize() const { return _core->pools.MaxSize(); }
+
+// See ConcurrentSlabAllocator.h
+std::size_t ConcurrentSlabAllocator::Reserved() {
+    std::lock_guard<std::mutex> guard(_core->lock);
+    return _core->pools.Reserved();
+}
+
+// See ConcurrentSlabAllocator.h
+std::size_t ConcurrentSlabAllocator::SlabSize() const { return _core->pools.SlabSize(); }
+
+// See ConcurrentSlabAllocator.h
+std::vector<ConcurrentSlabAllocator::ClassUsage> ConcurrentSlabAllocator::Usage() {
+    std::vector<ClassUsage> usage(_core->pools.Classes());
+    std::lock_guard<std::mutex> guard(_core->lock);
+    for (std::size_t i = 0; i < usage.size(); i++) {
+        usage[i].size = _core->pools.ClassObjectSize(i);
+        usage[i].slabs = _core->pools.ClassSlabs(i);
+        usage[i].starved = _core->depots[i].starved.load(std::memory_order_relaxed);
+        usage[i].refills = _core->depots[i].refills.load(std::memory_order_relaxed);
+    }
+    return usage;
+}
+
+// See ConcurrentSlabAllocator.h
+void *ConcurrentSlabAllocator::BeginMove(std::size_t size) {
+    std::size_t index = _core->pools.ClassOf(size);
+    std::lock_guard<std::mutex> guard(_core->lock);
+    void *slab = _core->pools.DrainColdest(index);
+    _core->Publish();
+    if (slab != nullptr) {
+        _core->moving++;
+        _core->generation.fetch_add(1, std::memory_order_relaxed);
+    }
+    return slab;
+}
+
+// See ConcurrentSlabAllocator.h
+bool ConcurrentSlabAllocator::FinishMove(std::size_t size, void *slab) {
+    std::size_t index = _core->pools.ClassOf(size);
+    Cache().Flush();
+
+    std::lock_guard<std::mutex> guard(_core->lock);
+    _core->Reclaim();
+    _core->Publish();
+    if (_core->pools.Draining(index, slab)) {
+        return false;
+    }
+    _core->moving--;
+    _core->moved++;
+    return true;
+}
+
+// See ConcurrentSlabAllocator.h
+void ConcurrentSlabAllocator::CountMoved(std::size_t relocated, std::size_t evicted) {
+    std::lock_guard<std::mutex> guard(_core->lock);
+    _core->relocated += relocated;
+    _core->evicted += evicted;
+}
+
+// See ConcurrentSlabAllocator.h
+void ConcurrentSlabAllocator::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    std::size_t depot = 0;
+    for (std::size_t i = 0; i < _core->pools.Classes(); i++) {
+        depot += _core->depots[i].count.load(std::memory_order_relaxed);
+    }
+
+    std::lock_guard<std::mutex> guard(_core->lock);
+    _core->pools.Stats(stats);
+    for (std::size_t i = 0; i < _core->pools.Classes(); i++) {
+        stats.emplace_back("slab_class_" + std::to_string(_core->pools.ClassObjectSize(i)) + "_starved",
+                           std::to_string(_core->depots[i].starved.load(std::memory_order_relaxed)));
+    }
+    stats.emplace_back("slab_depot_magazines", std::to_string(depot));
+    stats.emplace_back("slab_refills", std::to_string(_core->refills));
+    stats.emplace_back("slab_drains", std::to_string(_core->drains));
+    stats.emplace_back("slab_moves", std::to_string(_core->moved));
+    stats.emplace_back("slab_moves_pending", std::to_string(_core->moving));
+    stats.emplace_back("slab_move_relocated", std::to_string(_core->relocated));
+    stats.emplace_back("slab_move_evicted", std::to_string(_core->evicted));
+}
+
+// See ConcurrentSlabAllocator.h
+ConcurrentSlabAllocator::ThreadCache &ConcurrentSlabAllocator::Cache() {
+    for (auto &cache : _caches) {
+        if (cache->core == _core) {
+            return *cache;
+        }
+    }
+    _caches.emplace_back(new ThreadCache(_core));
+    return *_caches.back();
+}
+
+} // namespace Allocator
+} // namespace Afina
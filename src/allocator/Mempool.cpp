@@ -0,0 +1,179 @@
+#include <afina/allocator/Mempool.h>
+
+#include <afina/allocator/SlabCache.h>
+
+namespace Afina {
+namespace Allocator {
+
+// Slab header, objects follow it
+struct Mempool::Slab {
+    Mempool *pool;
+    Slab *prev;
+    Slab *next;
+
+    // Freed objects, each one keeps pointer to the next
+    void *free;
+
+    // Objects that have never been allocated start here
+    char *tail;
+    char *end;
+
+    // Pool tick of the last allocation from the slab
+    std::uint64_t stamp;
+
+    std::uint32_t used;
+
+    // Slab is being emptied, nothing is allocated from it, see Drain
+    bool draining;
+};
+
+namespace {
+
+// Objects start right after the slab header, aligned to 16
+const std::size_t header_size = 64;
+
+} // namespace
+
+// See Mempool.h
+Mempool::Mempool(SlabCache &cache, std::size_t object_size)
+    : _cache(cache), _object_size(object_size), _per_slab((cache.SlabSize() - header_size) / object_size),
+      _partial(nullptr), _full(nullptr), _draining(nullptr), _slabs(0), _used(0), _ticks(0) {
+    static_assert(sizeof(Slab) <= header_size, "Slab header doesn't fit");
+}
+
+// See Mempool.h
+Mempool::~Mempool() {
+    for (Slab *list : {_partial, _full, _draining}) {
+        while (list != nullptr) {
+            Slab *next = list->next;
+            _cache.Put(list);
+            list = next;
+        }
+    }
+}
+
+// See Mempool.h
+void *Mempool::Alloc() {
+    if (_partial == nullptr) {
+        Slab *slab = static_cast<Slab *>(_cache.Get());
+        if (slab == nullptr) {
+            return nullptr;
+        }
+        slab->pool = this;
+        slab->free = nullptr;
+        slab->tail = reinterpret_cast<char *>(slab) + header_size;
+        slab->end = slab->tail + _per_slab * _object_size;
+        slab->used = 0;
+        slab->draining = false;
+        Link(_partial, slab);
+        _slabs++;
+    }
+
+    Slab *slab = _partial;
+    void *object;
+    if (slab->free != nullptr) {
+        object = slab->free;
+        slab->free = *static_cast<void **>(object);
+    } else {
+        object = slab->tail;
+        slab->tail += _object_size;
+    }
+    _used++;
+    slab->stamp = ++_ticks;
+    if (++slab->used == _per_slab) {
+        Unlink(_partial, slab);
+        Link(_full, slab);
+    }
+    return object;
+}
+
+// See Mempool.h
+void Mempool::Free(void *object) {
+    Slab *slab = reinterpret_cast<Slab *>(reinterpret_cast<uintptr_t>(object) & ~uintptr_t(_cache.SlabSize() - 1));
+    *static_cast<void **>(object) = slab->free;
+    slab->free = object;
+    _used--;
+    if (slab->draining) {
+        if (--slab->used == 0) {
+            Unlink(_draining, slab);
+            _cache.Put(slab);
+            _slabs--;
+        }
+        return;
+    }
+    if (slab->used-- == _per_slab) {
+        Unlink(_full, slab);
+        Link(_partial, slab);
+    }
+    if (slab->used == 0) {
+        Unlink(_partial, slab);
+        _cache.Put(slab);
+        _slabs--;
+    }
+}
+
+// See Mempool.h
+void *Mempool::Coldest() const {
+    Slab *coldest = nullptr;
+    std::size_t slabs = 0;
+    for (Slab *list : {_partial, _full}) {
+        for (Slab *slab = list; slab != nullptr; slab = slab->next) {
+            if (coldest == nullptr || slab->stamp < coldest->stamp) {
+                coldest = slab;
+            }
+            slabs++;
+        }
+    }
+    return slabs > 1 ? coldest : nullptr;
+}
+
+// See Mempool.h
+void Mempool::Drain(void *slab) {
+    Slab *drained = static_cast<Slab *>(slab);
+    Unlink(drained->used == _per_slab ? _full : _partial, drained);
+    drained->draining = true;
+    Link(_draining, drained);
+}
+
+// See Mempool.h
+bool Mempool::Draining(void *slab) const {
+    for (Slab *drained = _draining; drained != nullptr; drained = drained->next) {
+        if (drained == slab) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// See Mempool.h
+bool Mempool::Available() const { return _partial != nullptr || _cache.Available(); }
+
+// See Mempool.h
+Mempool *Mempool::Of(void *object, std::size_t slab_size) {
+    return reinterpret_cast<Slab *>(reinterpret_cast<uintptr_t>(object) & ~uintptr_t(slab_size - 1))->pool;
+}
+
+// See Mempool.h
+void Mempool::Link(Slab *&list, Slab *slab) {
+    slab->prev = nullptr;
+    slab->next = list;
+    if (list != nullptr) {
+        list->prev = slab;
+    }
+    list = slab;
+}
+
+// See Mempool.h
+void Mempool::Unlink(Slab *&list, Slab *slab) {
+    if (slab->prev != nullptr) {
+        slab->prev->next = slab->next;
+    } else {
+        list = slab->next;
+    }
+    if (slab->next != nullptr) {
+        slab->next->prev = slab->prev;
+    }
+}
+
+} // namespace Allocator
+} // namespace Afina
@@ -0,0 +1,72 @@
+#include <afina/allocator/Region.h>
+
+#include <utility>
+
+#include <afina/allocator/Arena.h>
+
+namespace Afina {
+namespace Allocator {
+
+// Objects are aligned to that
+static const std::size_t alignment = 16;
+
+// Space object of the given size takes, empty objects take some too so that each has its own address
+static std::size_t Footprint(std::size_t size) {
+    return size == 0 ? alignment : (size + alignment - 1) & ~(alignment - 1);
+}
+
+// See Region.h
+Region::Region(std::shared_ptr<Arena> arena)
+    : _arena(std::move(arena)), _slab_size(_arena->SlabSize()), _top(nullptr), _end(nullptr), _used(0) {}
+
+// See Region.h
+Region::~Region() {
+    for (char *slab : _slabs) {
+        _arena->Unmap(slab);
+    }
+}
+
+// See Region.h
+void *Region::Allocate(std::size_t size) {
+    size = Footprint(size);
+    if (static_cast<std::size_t>(_end - _top) < size) {
+        char *slab = static_cast<char *>(_arena->Map());
+        if (slab == nullptr) {
+            return nullptr;
+        }
+        _slabs.push_back(slab);
+        _top = slab;
+        _end = slab + _slab_size;
+    }
+
+    void *object = _top;
+    _top += size;
+    _used += size;
+    return object;
+}
+
+// See Region.h
+void Region::Free(void *object, std::size_t size) {
+    size = Footprint(size);
+    if (static_cast<char *>(object) + size == _top) {
+        _top -= size;
+        _used -= size;
+    }
+}
+
+// See Region.h
+void Region::Reset() {
+    if (_slabs.empty()) {
+        return;
+    }
+    for (std::size_t i = 1; i < _slabs.size(); i++) {
+        _arena->Unmap(_slabs[i]);
+    }
+    _slabs.resize(1);
+    _top = _slabs.front();
+    _end = _top + _slab_size;
+    _used = 0;
+}
+
+} // namespace Allocator
+} // namespace Afina
@@ -1,40 +1,374 @@
 #include <afina/allocator/Simple.h>
 
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+#include <afina/allocator/Error.h>
 #include <afina/allocator/Pointer.h>
 
 namespace Afina {
 namespace Allocator {
 
-Simple::Simple(void *base, size_t size) : _base(base), _base_len(size) {}
-
-/**
- * TODO: semantics
- * @param N size_t
- */
-Pointer Simple::alloc(size_t N) { return Pointer(); }
-
-/**
- * TODO: semantics
- * @param p Pointer
- * @param N size_t
- */
-void Simple::realloc(Pointer &p, size_t N) {}
-
-/**
- * TODO: semantics
- * @param p Pointer
- */
-void Simple::free(Pointer &p) {}
-
-/**
- * TODO: semantics
- */
-void Simple::defrag() {}
-
-/**
- * TODO: semantics
- */
-std::string Simple::dump() const { return ""; }
+const std::size_t Simple::exact_lists;
+const std::size_t Simple::list_count;
+const std::size_t Simple::best_fit_scan;
+
+namespace {
+
+// Blocks start at and have sizes of multiples of the alignment, so low bits of the size carry flags
+const std::size_t alignment = 16;
+const std::size_t flags_mask = alignment - 1;
+const std::size_t used_flag = 1;
+const std::size_t prev_used_flag = 2;
+
+// Used block: size and owner slot, followed by the content
+const std::size_t header_size = 16;
+
+// Free block: size, links of the free list, copy of the size in the last word
+const std::size_t min_block = 32;
+
+} // namespace
+
+struct Simple::Block {
+    std::size_t tag;
+    union {
+        void **handle;
+        Block *next;
+    };
+    Block *prev;
+
+    std::size_t size() const { return tag & ~flags_mask; }
+    char *data() { return reinterpret_cast<char *>(this) + header_size; }
+    Block *after(std::size_t offset) { return reinterpret_cast<Block *>(reinterpret_cast<char *>(this) + offset); }
+
+    // Free block copies its size to the last word, so the next one could find it
+    void set_footer() {
+        std::size_t size = this->size();
+        std::memcpy(reinterpret_cast<char *>(this) + size - sizeof(size), &size, sizeof(size));
+    }
+};
+
+Simple::Simple(void *base, size_t size) : _base(base), _base_len(size), _free_slots(nullptr) {
+    uintptr_t begin = (reinterpret_cast<uintptr_t>(base) + flags_mask) & ~uintptr_t(flags_mask);
+    uintptr_t end = (reinterpret_cast<uintptr_t>(base) + size) & ~uintptr_t(flags_mask);
+    _begin = reinterpret_cast<char *>(begin);
+    _end = reinterpret_cast<char *>(std::max(begin, end));
+    _heap_end = _begin;
+    _table = _end;
+    std::fill(_lists, _lists + list_count, nullptr);
+    std::fill(_list_map, _list_map + list_count / 64, 0);
+}
+
+// See Simple.h
+Pointer Simple::alloc(size_t N) {
+    if (N == 0) {
+        return Pointer();
+    }
+    std::size_t size = BlockSize(N);
+    void **slot = size != 0 ? TakeSlot() : nullptr;
+    if (slot == nullptr) {
+        throw AllocError(AllocErrorType::NoMemory, "No space for " + std::to_string(N) + " bytes");
+    }
+
+    Block *block = TakeBlock(size);
+    if (block == nullptr) {
+        *slot = _free_slots;
+        _free_slots = slot;
+        throw AllocError(AllocErrorType::NoMemory, "No space for " + std::to_string(N) + " bytes");
+    }
+    block->handle = slot;
+    *slot = block->data();
+    return Pointer(slot);
+}
+
+// See Simple.h
+void Simple::realloc(Pointer &p, size_t N) {
+    if (p._slot == nullptr) {
+        p = alloc(N);
+        return;
+    }
+    if (N == 0) {
+        free(p);
+        return;
+    }
+
+    Block *block = BlockOf(p);
+    std::size_t size = BlockSize(N);
+    if (size == 0) {
+        throw AllocError(AllocErrorType::NoMemory, "No space for " + std::to_string(N) + " bytes");
+    }
+
+    std::size_t total = block->size();
+    if (size > total) {
+        Block *next = block->after(total);
+        if (reinterpret_cast<char *>(next) == _heap_end &&
+            std::size_t(_table - reinterpret_cast<char *>(block)) >= size) {
+            // Last block grows into the wilderness
+            _heap_end = reinterpret_cast<char *>(block) + size;
+            block->tag = size | (block->tag & flags_mask);
+            return;
+        }
+
+        if (reinterpret_cast<char *>(next) != _heap_end && (next->tag & used_flag) == 0 &&
+            total + next->size() >= size) {
+            // Next block is free, extra part of it goes back to the free lists below
+            Unlink(next);
+            total += next->size();
+            block->tag = total | (block->tag & flags_mask);
+            block->after(total)->tag |= prev_used_flag;
+        } else {
+            Block *moved = TakeBlock(size);
+            if (moved == nullptr) {
+                throw AllocError(AllocErrorType::NoMemory, "No space for " + std::to_string(N) + " bytes");
+            }
+            std::memcpy(moved->data(), block->data(), total - header_size);
+            moved->handle = p._slot;
+            *p._slot = moved->data();
+            ReleaseBlock(block);
+            return;
+        }
+    }
+
+    if (total - size >= min_block) {
+        block->tag = size | (block->tag & flags_mask);
+        Block *tail = block->after(size);
+        tail->tag = (total - size) | used_flag | prev_used_flag;
+        ReleaseBlock(tail);
+    }
+}
+
+// See Simple.h
+void Simple::free(Pointer &p) {
+    if (p._slot == nullptr) {
+        return;
+    }
+    ReleaseBlock(BlockOf(p));
+    *p._slot = _free_slots;
+    _free_slots = p._slot;
+    p._slot = nullptr;
+}
+
+// See Simple.h
+void Simple::defrag() {
+    char *to = _begin;
+    for (char *from = _begin; from != _heap_end;) {
+        std::size_t size = reinterpret_cast<Block *>(from)->size();
+        if (reinterpret_cast<Block *>(from)->tag & used_flag) {
+            if (to != from) {
+                std::memmove(to, from, size);
+            }
+            Block *block = reinterpret_cast<Block *>(to);
+            block->tag = size | used_flag | prev_used_flag;
+            *block->handle = block->data();
+            to += size;
+        }
+        from += size;
+    }
+
+    // All free blocks have joined the wilderness
+    _heap_end = to;
+    std::fill(_lists, _lists + list_count, nullptr);
+    std::fill(_list_map, _list_map + list_count / 64, 0);
+}
+
+// See Simple.h
+std::string Simple::dump() const {
+    std::ostringstream out;
+    for (char *position = _begin; position != _heap_end;) {
+        const Block *block = reinterpret_cast<const Block *>(position);
+        out << position - _begin << ' ' << block->size() << ((block->tag & used_flag) ? " used" : " free") << '\n';
+        position += block->size();
+    }
+    out << _heap_end - _begin << ' ' << _table - _heap_end << " wilderness\n";
+
+    std::size_t free_slots = 0;
+    for (void **slot = _free_slots; slot != nullptr; slot = static_cast<void **>(*slot)) {
+        free_slots++;
+    }
+    out << _table - _begin << ' ' << _end - _table << " table of " << (_end - _table) / sizeof(void *)
+        << " slots, " << free_slots << " free\n";
+    return out.str();
+}
+
+// See Simple.h
+std::size_t Simple::BlockSize(std::size_t N) const {
+    if (N > std::size_t(_end - _begin)) {
+        return 0;
+    }
+    return std::max(min_block, (N + header_size + flags_mask) & ~flags_mask);
+}
+
+// See Simple.h
+void **Simple::TakeSlot() {
+    if (_free_slots == nullptr) {
+        if (std::size_t(_table - _heap_end) < alignment) {
+            return nullptr;
+        }
+        // Table grows by a few slots at once to keep blocks aligned
+        _table -= alignment;
+        for (std::size_t i = alignment / sizeof(void *); i != 0; i--) {
+            void **slot = reinterpret_cast<void **>(_table) + i - 1;
+            *slot = _free_slots;
+            _free_slots = slot;
+        }
+    }
+
+    void **slot = _free_slots;
+    _free_slots = static_cast<void **>(*slot);
+    *slot = nullptr;
+    return slot;
+}
+
+// See Simple.h
+Simple::Block *Simple::TakeBlock(std::size_t size) {
+    std::size_t list = ListOf(size);
+    Block *found = nullptr;
+    if (list < exact_lists) {
+        found = _lists[list];
+    } else {
+        // Best fit within the range, long lists are looked at only partially
+        std::size_t candidates = 0;
+        for (Block *block = _lists[list]; block != nullptr && candidates < best_fit_scan; block = block->next) {
+            candidates++;
+            if (block->size() >= size && (found == nullptr || block->size() < found->size())) {
+                found = block;
+                if (block->size() == size) {
+                    break;
+                }
+            }
+        }
+    }
+
+    // Any block of a bigger list fits, the first one is taken
+    for (std::size_t i = list + 1; found == nullptr && i < list_count;) {
+        uint64_t word = _list_map[i / 64] >> (i % 64);
+        if (word != 0) {
+            found = _lists[i + __builtin_ctzll(word)];
+        } else {
+            i = (i / 64 + 1) * 64;
+        }
+    }
+
+    if (found != nullptr) {
+        Unlink(found);
+        UseBlock(found, size);
+        return found;
+    }
+
+    if (std::size_t(_table - _heap_end) < size) {
+        return nullptr;
+    }
+    // Block before the wilderness is always used, free one would have joined it
+    Block *block = reinterpret_cast<Block *>(_heap_end);
+    block->tag = size | used_flag | prev_used_flag;
+    _heap_end += size;
+    return block;
+}
+
+// See Simple.h
+void Simple::UseBlock(Block *block, std::size_t size) {
+    std::size_t total = block->size();
+    std::size_t prev_used = block->tag & prev_used_flag;
+    if (total - size >= min_block) {
+        // Block after the tail already knows the previous one is free
+        block->tag = size | used_flag | prev_used;
+        Block *tail = block->after(size);
+        tail->tag = (total - size) | prev_used_flag;
+        tail->set_footer();
+        Link(tail);
+    } else {
+        // Free block never touches the wilderness, so there is a block after it
+        block->tag = total | used_flag | prev_used;
+        block->after(total)->tag |= prev_used_flag;
+    }
+}
+
+// See Simple.h
+void Simple::ReleaseBlock(Block *block) {
+    std::size_t size = block->size();
+    if ((block->tag & prev_used_flag) == 0) {
+        std::size_t prev_size;
+        std::memcpy(&prev_size, reinterpret_cast<char *>(block) - sizeof(prev_size), sizeof(prev_size));
+        block = reinterpret_cast<Block *>(reinterpret_cast<char *>(block) - prev_size);
+        Unlink(block);
+        size += prev_size;
+    }
+
+    Block *next = block->after(size);
+    if (reinterpret_cast<char *>(next) == _heap_end) {
+        _heap_end = reinterpret_cast<char *>(block);
+        return;
+    }
+    if ((next->tag & used_flag) == 0) {
+        Unlink(next);
+        size += next->size();
+    }
+
+    // Neighbours of a free block are used ones
+    block->tag = size | prev_used_flag;
+    block->set_footer();
+    Link(block);
+    block->after(size)->tag &= ~prev_used_flag;
+}
+
+// See Simple.h
+Simple::Block *Simple::BlockOf(const Pointer &p) const {
+    uintptr_t slot = reinterpret_cast<uintptr_t>(p._slot);
+    uintptr_t table = reinterpret_cast<uintptr_t>(_table), begin = reinterpret_cast<uintptr_t>(_begin);
+    if (slot >= table && slot < reinterpret_cast<uintptr_t>(_end) && (slot - table) % sizeof(void *) == 0) {
+        // Free slot holds address of another slot or nullptr, neither of them is a block of the heap
+        uintptr_t data = reinterpret_cast<uintptr_t>(*p._slot);
+        if (data >= begin + header_size && data < reinterpret_cast<uintptr_t>(_heap_end) &&
+            (data - begin) % alignment == header_size % alignment) {
+            Block *block = reinterpret_cast<Block *>(data - header_size);
+            if ((block->tag & used_flag) != 0 && block->handle == p._slot) {
+                return block;
+            }
+        }
+    }
+    throw AllocError(AllocErrorType::InvalidFree, "Pointer doesn't refer to a block of the allocator");
+}
+
+// See Simple.h
+std::size_t Simple::ListOf(std::size_t size) {
+    uint64_t units = size / alignment;
+    if (units < exact_lists) {
+        return units;
+    }
+    // Every power of two range is split in quarters, the first one starts right after the exact lists:
+    // 32 units is 2^5
+    std::size_t log = 63 - __builtin_clzll(units);
+    return exact_lists + (log - 5) * 4 + ((units >> (log - 2)) & 3);
+}
+
+// See Simple.h
+void Simple::Link(Block *block) {
+    std::size_t list = ListOf(block->size());
+    block->next = _lists[list];
+    block->prev = nullptr;
+    if (block->next != nullptr) {
+        block->next->prev = block;
+    }
+    _lists[list] = block;
+    _list_map[list / 64] |= uint64_t(1) << (list % 64);
+}
+
+// See Simple.h
+void Simple::Unlink(Block *block) {
+    std::size_t list = ListOf(block->size());
+    if (block->prev != nullptr) {
+        block->prev->next = block->next;
+    } else {
+        _lists[list] = block->next;
+    }
+    if (block->next != nullptr) {
+        block->next->prev = block->prev;
+    }
+    if (_lists[list] == nullptr) {
+        _list_map[list / 64] &= ~(uint64_t(1) << (list % 64));
+    }
+}
 
 } // namespace Allocator
 } // namespace Afina
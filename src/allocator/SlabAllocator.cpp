@@ -0,0 +1,66 @@
+#include <afina/allocator/SlabAllocator.h>
+
+#include <algorithm>
+
+#include <afina/allocator/Arena.h>
+
+namespace Afina {
+namespace Allocator {
+
+const std::size_t SlabAllocator::default_min_size;
+constexpr double SlabAllocator::default_factor;
+
+// See SlabAllocator.h
+SlabAllocator::SlabAllocator(std::shared_ptr<Arena> arena, std::size_t min_size, double factor)
+    : _cache(std::move(arena)) {
+    std::size_t max_size = _cache.SlabSize() / 4 / 16 * 16;
+    for (double size = min_size; size < max_size; size *= factor) {
+        std::size_t rounded = (static_cast<std::size_t>(size) + 15) / 16 * 16;
+        if (_pools.empty() || rounded > _pools.back()->ObjectSize()) {
+            _pools.emplace_back(new Mempool(_cache, rounded));
+        }
+    }
+    _pools.emplace_back(new Mempool(_cache, max_size));
+}
+
+// See SlabAllocator.h
+void *SlabAllocator::Allocate(std::size_t size) { return _pools[ClassOf(size)]->Alloc(); }
+
+// See SlabAllocator.h
+void SlabAllocator::Free(void *object, std::size_t size) { _pools[ClassOf(size)]->Free(object); }
+
+// See SlabAllocator.h
+bool SlabAllocator::Available(std::size_t size) const { return _pools[ClassOf(size)]->Available(); }
+
+// See SlabAllocator.h
+void *SlabAllocator::DrainColdest(std::size_t index) {
+    void *slab = _pools[index]->Coldest();
+    if (slab != nullptr) {
+        _pools[index]->Drain(slab);
+    }
+    return slab;
+}
+
+// See SlabAllocator.h
+void SlabAllocator::Stats(std::vector<std::pair<std::string, std::string>> &stats) const {
+    stats.emplace_back("slabs", std::to_string(_cache.Slabs()));
+    stats.emplace_back("slabs_spare", std::to_string(_cache.Spare()));
+    for (auto &pool : _pools) {
+        const std::string prefix = "slab_class_" + std::to_string(pool->ObjectSize());
+        stats.emplace_back(prefix + "_slabs", std::to_string(pool->Slabs()));
+        stats.emplace_back(prefix + "_used", std::to_string(pool->Used()));
+        stats.emplace_back(prefix + "_free", std::to_string(pool->Slabs() * pool->ObjectsPerSlab() - pool->Used()));
+    }
+}
+
+// See SlabAllocator.h
+std::size_t SlabAllocator::ClassOf(std::size_t size) const {
+    auto pool = std::lower_bound(_pools.begin(), _pools.end(), size,
+                                 [](const std::unique_ptr<Mempool> &pool, std::size_t size) {
+                                     return pool->ObjectSize() < size;
+                                 });
+    return pool - _pools.begin();
+}
+
+} // namespace Allocator
+} // namespace Afina
@@ -0,0 +1,49 @@
+#include <afina/allocator/SlabCache.h>
+
+#include <afina/allocator/Arena.h>
+
+namespace Afina {
+namespace Allocator {
+
+const std::size_t SlabCache::max_spare;
+
+// See SlabCache.h
+SlabCache::SlabCache(std::shared_ptr<Arena> arena)
+    : _arena(std::move(arena)), _slab_size(_arena->SlabSize()), _slabs(0) {}
+
+// See SlabCache.h
+SlabCache::~SlabCache() {
+    for (void *slab : _spare) {
+        _arena->Unmap(slab);
+    }
+}
+
+// See SlabCache.h
+void *SlabCache::Get() {
+    if (!_spare.empty()) {
+        void *slab = _spare.back();
+        _spare.pop_back();
+        return slab;
+    }
+    void *slab = _arena->Map();
+    if (slab != nullptr) {
+        _slabs++;
+    }
+    return slab;
+}
+
+// See SlabCache.h
+void SlabCache::Put(void *slab) {
+    if (_spare.size() < max_spare) {
+        _spare.push_back(slab);
+        return;
+    }
+    _arena->Unmap(slab);
+    _slabs--;
+}
+
+// See SlabCache.h
+bool SlabCache::Available() const { return !_spare.empty() || _arena->Available(); }
+
+} // namespace Allocator
+} // namespace Afina
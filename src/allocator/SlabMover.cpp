@@ -0,0 +1,115 @@
+#include <afina/allocator/SlabMover.h>
+
+#include <chrono>
+#include <utility>
+
+namespace Afina {
+namespace Allocator {
+
+const uint32_t SlabMover::min_age;
+
+// See SlabMover.h
+SlabMover::SlabMover(std::shared_ptr<ConcurrentSlabAllocator> allocator, Client &client, uint32_t interval)
+    : _allocator(std::move(allocator)), _client(client), _interval(interval), _slab(nullptr), _slab_class(0),
+      _running(false) {}
+
+// See SlabMover.h
+SlabMover::~SlabMover() { Stop(); }
+
+// See SlabMover.h
+void SlabMover::Start() {
+    _running = true;
+    _thread = std::thread(&SlabMover::OnRun, this);
+}
+
+// See SlabMover.h
+void SlabMover::Stop() {
+    if (_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            _running = false;
+        }
+        _stop_requested.notify_all();
+        _thread.join();
+    }
+}
+
+// See SlabMover.h
+bool SlabMover::Step() {
+    std::vector<ConcurrentSlabAllocator::ClassUsage> usage = _allocator->Usage();
+    if (_last.empty()) {
+        // The first pass only takes counters to compare with
+        _last = usage;
+        _ages.assign(usage.size(), 0);
+        return false;
+    }
+
+    // Class that was starved the most since the previous pass
+    std::size_t starved = usage.size();
+    uint64_t pressure = 0;
+    for (std::size_t i = 0; i < usage.size(); i++) {
+        _ages[i] = usage[i].refills == _last[i].refills ? _ages[i] + 1 : 0;
+        if (usage[i].starved - _last[i].starved > pressure) {
+            pressure = usage[i].starved - _last[i].starved;
+            starved = i;
+        }
+    }
+
+    bool restart = false;
+    if (_slab == nullptr && starved != usage.size()) {
+        std::size_t donor = Donor(usage, starved);
+        if (donor != usage.size()) {
+            _slab = _allocator->BeginMove(usage[donor].size);
+            _slab_class = usage[donor].size;
+            restart = true;
+        }
+    }
+    _last = std::move(usage);
+    if (_slab == nullptr) {
+        return false;
+    }
+
+    std::size_t relocated = 0, evicted = 0;
+    bool vacated =
+        _client.Vacate(static_cast<const char *>(_slab), _allocator->SlabSize(), restart, relocated, evicted);
+    _allocator->CountMoved(relocated, evicted);
+    if (!vacated || !_allocator->FinishMove(_slab_class, _slab)) {
+        return false;
+    }
+    _slab = nullptr;
+    return true;
+}
+
+// See SlabMover.h
+std::size_t SlabMover::Donor(const std::vector<ConcurrentSlabAllocator::ClassUsage> &usage,
+                             std::size_t starved) const {
+    // Oldest class that wasn't starved itself and has a slab to spare, a tie goes to the one with more slabs
+    std::size_t donor = usage.size();
+    for (std::size_t i = 0; i < usage.size(); i++) {
+        if (i == starved || usage[i].slabs < 2 || usage[i].starved != _last[i].starved || _ages[i] < min_age) {
+            continue;
+        }
+        if (donor == usage.size() || _ages[i] > _ages[donor] ||
+            (_ages[i] == _ages[donor] && usage[i].slabs > usage[donor].slabs)) {
+            donor = i;
+        }
+    }
+    return donor;
+}
+
+// See SlabMover.h
+void SlabMover::OnRun() {
+    std::unique_lock<std::mutex> lock(_lock);
+    while (_running) {
+        if (_stop_requested.wait_for(lock, std::chrono::milliseconds(_interval), [this] { return !_running; })) {
+            break;
+        }
+
+        lock.unlock();
+        Step();
+        lock.lock();
+    }
+}
+
+} // namespace Allocator
+} // namespace Afina
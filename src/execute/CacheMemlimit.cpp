@@ -0,0 +1,20 @@
+#include <afina/Storage.h>
+#include <afina/execute/CacheMemlimit.h>
+
+#include <iostream>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: "cache_memlimit" changes memory limit of the running server
+void CacheMemlimit::Execute(Storage &storage, const std::string &/*args*/, std::string &out) {
+    std::cout << "CacheMemlimit(" << _megabytes << ")" << std::endl;
+    if (storage.SetMemoryLimit(_megabytes << 20)) {
+        out = "OK";
+    } else {
+        out = "SERVER_ERROR storage can't be resized";
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
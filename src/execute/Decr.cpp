@@ -0,0 +1,33 @@
+#include <afina/Storage.h>
+#include <afina/execute/Decr.h>
+
+#include <iostream>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: "decr" decreases the counter by the given amount, counter is updated inside of the storage
+void Decr::Execute(Storage &storage, const std::string &/*args*/, std::string &out) {
+    std::cout << "Decr(" << _key << ", " << _delta << ")" << std::endl;
+    uint64_t value;
+    switch (storage.Decrement(_key, _delta, value)) {
+    case Storage::CounterResult::Updated:
+        out = std::to_string(value);
+        break;
+    case Storage::CounterResult::NotFound:
+        out = "NOT_FOUND";
+        break;
+    case Storage::CounterResult::NotNumber:
+        out = "CLIENT_ERROR cannot increment or decrement non-numeric value";
+        break;
+    case Storage::CounterResult::NoMemory:
+        out = "SERVER_ERROR out of memory";
+        break;
+    case Storage::CounterResult::NotLogged:
+        out = "SERVER_ERROR operation log failed";
+        break;
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -4,6 +4,8 @@
 #include <iostream>
 #include <iterator>
 #include <sstream>
+#include <utility>
+#include <vector>
 
 namespace Afina {
 namespace Execute {
@@ -12,7 +14,7 @@ namespace Execute {
 
 Each item sent by the server looks like this:
 
-VALUE <key> <flags> <bytes>\r\n
+VALUE <key> <flags> <bytes> [<cas unique>]\r\n
 <data block>\r\n
 
 After all the items have been transmitted, the server sends the string
@@ -26,18 +28,36 @@ void Get::Execute(Storage &storage, const std::string &args, std::string &out) {
     copy(_keys.begin(), _keys.end(), std::ostream_iterator<std::string>(keyStream, " "));
     std::cout << "Get(" << keyStream.str() << ")" << std::endl;
 
-    std::stringstream outStream;
+    // Values go straight from the storage into the response. Storage visits keys in any order, items must
+    // be sent in the order of keys, so blocks are put in place afterwards unless they already are
+    out.clear();
+    std::vector<std::pair<std::size_t, std::size_t>> blocks(_keys.size(), {0, 0});
+    std::size_t last = 0;
+    bool ordered = true;
+    auto visit = [&](std::size_t index, const char *value, std::size_t size, uint32_t flags, uint64_t cas) {
+        std::size_t start = out.size();
+        out.append("VALUE ").append(_keys[index]);
+        out.append(" ").append(std::to_string(flags));
+        out.append(" ").append(std::to_string(size));
+        if (_cas) {
+            out.append(" ").append(std::to_string(cas));
+        }
+        out.append("\r\n").append(value, size).append("\r\n");
+        blocks[index] = {start, out.size() - start};
+        ordered = ordered && index >= last;
+        last = index;
+    };
+    storage.MultiGet(_keys.data(), _keys.size(), visit);
 
-    std::string value;
-    for (auto &key : _keys) {
-        if (!storage.Get(key, value))
-            continue;
-        outStream << "VALUE " << key << " 0 " << value.size() << "\r\n";
-        outStream << value << "\r\n";
+    if (!ordered) {
+        std::string found;
+        found.swap(out);
+        out.reserve(found.size() + 3);
+        for (auto &block : blocks) {
+            out.append(found, block.first, block.second);
+        }
     }
-    outStream << "END"; // networking layer should add the last \r\n
-
-    out = outStream.str();
+    out.append("END"); // networking layer should add the last \r\n
 }
 
 } // namespace Execute
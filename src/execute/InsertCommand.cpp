@@ -0,0 +1,26 @@
+#include <afina/execute/InsertCommand.h>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: the actual value sent may either be Unix time or a number of seconds
+// starting from current time. In the latter case, this number of seconds may not exceed
+// 60*60*24*30 (number of seconds in 30 days)
+static const int32_t max_relative_expire = 60 * 60 * 24 * 30;
+
+// See InsertCommand.h
+time_t InsertCommand::Deadline() const {
+    if (_expire == 0) {
+        return 0;
+    }
+    if (_expire > max_relative_expire) {
+        return _expire;
+    }
+
+    time_t deadline = std::time(nullptr) + _expire;
+    // Keep "expired" distinct from "never expires"
+    return deadline != 0 ? deadline : -1;
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -11,6 +11,9 @@
 
 #include <afina/Storage.h>
 #include <afina/Version.h>
+#include <afina/allocator/Arena.h>
+#include <afina/allocator/ConcurrentSlabAllocator.h>
+#include <afina/allocator/SlabMover.h>
 #include <afina/logging/Service.h>
 #include <afina/network/Server.h>
 
@@ -20,6 +23,9 @@
 #include "network/st_blocking/ServerImpl.h"
 #include "network/st_nonblocking/ServerImpl.h"
 
+#include "storage/PersistentStorage.h"
+#include "storage/RcuLRU.h"
+#include "storage/ShardedLRU.h"
 #include "storage/SimpleLRU.h"
 #include "storage/ThreadSafeSimpleLRU.h"
 
@@ -50,14 +56,114 @@ public:
             storage_type = options["storage"].as<std::string>();
         }
 
-        if (storage_type == "st_lru") {
-            storage = std::make_shared<Afina::Backend::SimpleLRU>();
-        } else if (storage_type == "mt_lru") {
-            storage = std::make_shared<Afina::Backend::ThreadSafeSimplLRU>();
+        // Storage type is <threading>_<eviction policy>, for example mt_sharded_clock
+        std::size_t split = storage_type.rfind('_');
+        if (split == std::string::npos) {
+            throw std::runtime_error("Unknown storage type");
+        }
+        std::string threading = storage_type.substr(0, split);
+        auto policy = Afina::Backend::EvictionPolicy::Parse(storage_type.substr(split + 1));
+        bool admission = options.count("admission") > 0;
+
+        // Values of that many bytes and more are kept compressed, 0 turns compression off
+        uint32_t compress_threshold = 0;
+        if (options.count("compress-threshold") > 0) {
+            compress_threshold = options["compress-threshold"].as<uint32_t>();
+        }
+
+        // Items of all the caches take memory from slabs of a single arena, if there is one. Allocator
+        // over it keeps per thread magazines, so network workers don't contend on its size classes
+        std::shared_ptr<Afina::Allocator::ConcurrentSlabAllocator> slabs;
+        if (options.count("slab-arena") > 0 && options["slab-arena"].as<uint64_t>() != 0) {
+            slabs = std::make_shared<Afina::Allocator::ConcurrentSlabAllocator>(
+                std::make_shared<Afina::Allocator::Arena>(options["slab-arena"].as<uint64_t>()));
+        }
+
+        // Memory limit bounds keys and values as well, without it every cache holds default 1024 bytes of them
+        uint64_t memory_limit = 0;
+        if (options.count("memory-limit") > 0) {
+            memory_limit = options["memory-limit"].as<uint64_t>();
+        }
+
+        // Owner of items slab mover moves out of slabs, only thread safe storages could be one
+        Afina::Allocator::SlabMover::Client *slab_client = nullptr;
+        if (threading == "st") {
+            auto lru = std::make_shared<Afina::Backend::SimpleLRU>(memory_limit != 0 ? memory_limit : 1024,
+                                                                   &Afina::Backend::SimpleLRU::SystemClock, policy,
+                                                                   admission, compress_threshold, slabs);
+            lru->SetMemoryLimit(memory_limit);
+            storage = lru;
+        } else if (threading == "mt") {
+            auto lru = std::make_shared<Afina::Backend::ThreadSafeSimplLRU>(memory_limit != 0 ? memory_limit : 1024,
+                                                                            policy, admission, compress_threshold,
+                                                                            slabs);
+            lru->SetMemoryLimit(memory_limit);
+            storage = lru;
+            slab_client = lru.get();
+        } else if (threading == "mt_sharded") {
+            uint32_t shards = std::thread::hardware_concurrency();
+            if (options.count("shards") > 0) {
+                shards = options["shards"].as<uint32_t>();
+            }
+            if (shards == 0) {
+                shards = 1;
+            }
+            // Each shard gets the same default budget as a standalone SimpleLRU
+            auto lru = std::make_shared<Afina::Backend::ShardedLRU>(memory_limit != 0 ? memory_limit : 1024 * shards,
+                                                                    shards, policy, admission, compress_threshold,
+                                                                    slabs);
+            lru->SetMemoryLimit(memory_limit);
+            storage = lru;
+            slab_client = lru.get();
+        } else if (threading == "mt_rcu") {
+            // Readers never write shared memory there, so only CLOCK fits and admission isn't supported.
+            // Memory limit bounds keys and values only
+            if (policy != Afina::Backend::EvictionPolicy::Kind::CLOCK || admission || compress_threshold != 0 ||
+                slabs != nullptr) {
+                throw std::runtime_error(
+                    "mt_rcu storage supports only clock policy without admission, compression and slab arena");
+            }
+            // Not make_shared: RcuLRU brings its own aligned operator new
+            storage.reset(new Afina::Backend::RcuLRU(memory_limit != 0 ? memory_limit : 1024));
         } else {
             throw std::runtime_error("Unknown storage type");
         }
 
+        // Slab mover gives slabs of classes that aren't used anymore to the ones that lack memory
+        if (options.count("slab-rebalance") > 0 && options["slab-rebalance"].as<uint32_t>() != 0) {
+            if (slabs == nullptr || slab_client == nullptr) {
+                throw std::runtime_error("Slab rebalancing needs --slab-arena and mt_* storage");
+            }
+            slabMover.reset(new Afina::Allocator::SlabMover(slabs, *slab_client,
+                                                            options["slab-rebalance"].as<uint32_t>() * 1000));
+        }
+
+        // Snapshot prewarms cache on start and is written back on stop, background snapshots scan the storage
+        // concurrently with requests, so they need thread safe storage. Operation log keeps changes made since
+        // the last snapshot, it is compacted by snapshots, so there is no log without them
+        if (options.count("snapshot") > 0) {
+            uint32_t interval = 0;
+            if (options.count("snapshot-interval") > 0) {
+                interval = options["snapshot-interval"].as<uint32_t>();
+            }
+            if (interval != 0 && threading == "st") {
+                throw std::runtime_error("Background snapshots need mt_* storage");
+            }
+
+            std::unique_ptr<Afina::Backend::OperationLog> log;
+            if (options.count("wal") > 0) {
+                uint32_t window = 0;
+                if (options.count("wal-window") > 0) {
+                    window = options["wal-window"].as<uint32_t>();
+                }
+                log.reset(new Afina::Backend::OperationLog(options["wal"].as<std::string>(), window));
+            }
+            storage = std::make_shared<Afina::Backend::PersistentStorage>(
+                storage, options["snapshot"].as<std::string>(), interval, std::move(log));
+        } else if (options.count("wal") > 0) {
+            throw std::runtime_error("Operation log needs --snapshot");
+        }
+
         // Step 2: Configure network
         std::string network_type = "st_block";
         if (options.count("network") > 0) {
@@ -85,6 +191,9 @@ public:
 
         log->warn("Start storage");
         storage->Start();
+        if (slabMover != nullptr) {
+            slabMover->Start();
+        }
 
         // TODO: configure network service
         const uint16_t port = 8080;
@@ -99,6 +208,9 @@ public:
         server->Stop();
         server->Join();
 
+        if (slabMover != nullptr) {
+            slabMover->Stop();
+        }
         storage->Stop();
         logService->Stop();
     }
@@ -108,6 +220,7 @@ private:
     std::shared_ptr<Afina::Logging::Service> logService;
 
     std::shared_ptr<Afina::Storage> storage;
+    std::unique_ptr<Afina::Allocator::SlabMover> slabMover;
     std::shared_ptr<Afina::Network::Server> server;
 };
 
@@ -128,6 +241,24 @@ int main(int argc, char **argv) {
         // TODO: use custom cxxopts::value to print options possible values in help message
         // and simplify validation below
         options.add_options()("s,storage", "Type of storage service to use", cxxopts::value<std::string>());
+        options.add_options()("shards", "Number of shards for mt_sharded_* storages", cxxopts::value<uint32_t>());
+        options.add_options()("memory-limit", "Bytes of memory storage could take, including all the overhead",
+                              cxxopts::value<uint64_t>());
+        options.add_options()("admission", "Admit new items into storage by W-TinyLFU policy");
+        options.add_options()("compress-threshold", "Compress values of that many bytes and more, 0 means never",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("slab-arena", "Bytes of the slab arena items are allocated from, 0 means malloc",
+                              cxxopts::value<uint64_t>());
+        options.add_options()("slab-rebalance", "Seconds between passes of the slab mover, 0 means never",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("snapshot", "File to load storage from on start and to save it to on stop",
+                              cxxopts::value<std::string>());
+        options.add_options()("snapshot-interval", "Seconds between background snapshots, 0 means on stop only",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("wal", "Path of the operation log replayed over the snapshot after a crash",
+                              cxxopts::value<std::string>());
+        options.add_options()("wal-window", "Milliseconds changes could stay not durable, 0 means none",
+                              cxxopts::value<uint32_t>());
         options.add_options()("n,network", "Type of network service to use", cxxopts::value<std::string>());
         options.add_options()("h,help", "Print usage info");
         options.parse(argc, argv);
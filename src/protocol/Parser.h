@@ -61,8 +61,24 @@ private:
      * - s: state for PUT and GET commands
      * - sp: for PUT commands only
      * - sg: for GET commands only
+     * - si: for INCR/DECR commands only
+     * - sm: for CACHE_MEMLIMIT command only
      */
-    enum State : uint16_t { sCR, sLF, sName, spKey, spFlags, spExprTimeStart, spExprTime, spBytes, sgKey };
+    enum State : uint16_t {
+        sCR,
+        sLF,
+        sName,
+        spKey,
+        spFlags,
+        spExprTimeStart,
+        spExprTime,
+        spBytes,
+        spCas,
+        sgKey,
+        siKey,
+        siDelta,
+        smLimit
+    };
 
     // Current parser state
     State state;
@@ -88,6 +104,17 @@ private:
     // it's followed by an empty data block).
     uint32_t bytes;
 
+    // <cas unique> is a unique 64-bit value of an existing entry. Clients should use the value returned from
+    // the "gets" command when issuing "cas" updates.
+    uint64_t cas;
+
+    // <value> of incr/decr is the amount by which the client wants to increase/decrease the item. It is a decimal
+    // representation of a 64-bit unsigned integer.
+    uint64_t delta;
+
+    // <megabytes> of cache_memlimit is the new memory limit
+    uint64_t limit;
+
     bool negative;
     std::string curKey;
     bool parse_complete;
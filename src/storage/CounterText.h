@@ -0,0 +1,46 @@
+#ifndef AFINA_STORAGE_COUNTER_TEXT_H
+#define AFINA_STORAGE_COUNTER_TEXT_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Afina {
+namespace Backend {
+
+// Counters of incr/decr are kept as decimal text, so that get returns them as is. That is the
+// maximum length of such text
+static const std::size_t counter_digits = 20;
+
+/**
+ * Parses counter from the value bytes, returns false if they aren't decimal representation
+ * of 64-bit unsigned integer
+ */
+inline bool ParseCounter(const char *digits, std::size_t size, uint64_t &counter) {
+    if (size == 0 || size > counter_digits) return false;
+    counter = 0;
+    for (std::size_t i = 0; i < size; i++) {
+        if (digits[i] < '0' || digits[i] > '9') return false;
+        uint64_t next = counter * 10 + (digits[i] - '0');
+        if (next / 10 != counter) return false; // Doesn't fit 64 bits
+        counter = next;
+    }
+    return true;
+}
+
+/**
+ * Writes decimal text of the counter so that it ends right before the given position, returns
+ * number of bytes written, at most counter_digits
+ */
+inline std::size_t FormatCounter(uint64_t counter, char *end) {
+    std::size_t size = 0;
+    do {
+        *(end - ++size) = '0' + counter % 10;
+        counter /= 10;
+    } while (counter != 0);
+    return size;
+}
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_COUNTER_TEXT_H
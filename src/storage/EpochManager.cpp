@@ -0,0 +1,105 @@
+#include "EpochManager.h"
+
+#include <mutex>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+const std::size_t EpochManager::max_threads;
+
+namespace {
+
+// Slot numbers given to threads, shared by all managers
+std::mutex thread_lock;
+std::vector<std::size_t> free_threads;
+std::size_t next_thread = 0;
+
+// Takes slot number on the first use in a thread and gives it back on thread exit
+struct ThreadSlot {
+    ThreadSlot() {
+        std::lock_guard<std::mutex> lock(thread_lock);
+        if (!free_threads.empty()) {
+            number = free_threads.back();
+            free_threads.pop_back();
+        } else if (next_thread < EpochManager::max_threads) {
+            number = next_thread++;
+        } else {
+            number = EpochManager::max_threads;
+        }
+    }
+
+    ~ThreadSlot() {
+        if (number != EpochManager::max_threads) {
+            std::lock_guard<std::mutex> lock(thread_lock);
+            free_threads.push_back(number);
+        }
+    }
+
+    std::size_t number;
+};
+
+} // namespace
+
+// See EpochManager.h
+std::size_t EpochManager::ThisThread() {
+    static thread_local ThreadSlot slot;
+    return slot.number;
+}
+
+// See EpochManager.h
+EpochManager::EpochManager() : _epoch(1), _overflow(0) {
+    for (auto &slot : _slots) {
+        slot.epoch.store(0, std::memory_order_relaxed);
+    }
+}
+
+// See EpochManager.h
+EpochManager::Guard::Guard(EpochManager &manager) : _manager(manager), _thread(ThisThread()) {
+    if (_thread != max_threads) {
+        _manager._slots[_thread].epoch.store(_manager._epoch.load(std::memory_order_acquire),
+                                             std::memory_order_relaxed);
+    } else {
+        _manager._overflow.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Pairs with the fence in Collect: either writer sees the announcement, or everything it unlinked
+    // before is visible to the reader, so the reader can't reach what is going to be freed
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+// See EpochManager.h
+EpochManager::Guard::~Guard() {
+    if (_thread != max_threads) {
+        _manager._slots[_thread].epoch.store(0, std::memory_order_release);
+    } else {
+        _manager._overflow.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+// See EpochManager.h
+uint64_t EpochManager::Collect() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t current = _epoch.load(std::memory_order_relaxed);
+    if (_overflow.load(std::memory_order_acquire) != 0) {
+        return 0;
+    }
+
+    uint64_t oldest = current;
+    for (auto &slot : _slots) {
+        uint64_t epoch = slot.epoch.load(std::memory_order_acquire);
+        if (epoch != 0 && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+
+    // Readers are either in the current epoch or in the previous one, once all of them have
+    // caught up epoch moves on
+    if (oldest == current) {
+        _epoch.store(current + 1, std::memory_order_release);
+    }
+    return oldest;
+}
+
+} // namespace Backend
+} // namespace Afina
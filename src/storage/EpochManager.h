@@ -0,0 +1,91 @@
+#ifndef AFINA_STORAGE_EPOCH_MANAGER_H
+#define AFINA_STORAGE_EPOCH_MANAGER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Epoch based reclamation
+ * Lets readers traverse shared structures without locks while writers unlink
+ * and later free parts of them. Reader wraps traversal into a Guard, which
+ * announces the global epoch in the reader's own slot. Writer tags everything
+ * it unlinks with Current() epoch and frees it once Collect() reports that no
+ * reader could have seen it, that is all readers active now have entered after
+ * the object was unlinked.
+ *
+ * Each thread gets a slot of its own on the first Guard, slots are aligned to
+ * the cache line so readers never write shared memory. Owner allocated on the
+ * heap must keep that alignment, see RcuLRU::operator new. Threads beyond
+ * max_threads share an overflow counter, while any of them is inside of a Guard
+ * nothing could be freed.
+ *
+ * Guard is cheap and must not be nested. Collect must be called by one thread
+ * at a time, usually under the writers lock.
+ */
+class EpochManager {
+public:
+    static const std::size_t max_threads = 256;
+
+    /**
+     * Scope of a reader, pointers loaded inside of it stay valid until it ends
+     */
+    class Guard {
+    public:
+        explicit Guard(EpochManager &manager);
+        ~Guard();
+
+        // Slot of the current thread, max_threads if thread has none
+        std::size_t Thread() const { return _thread; }
+
+    private:
+        Guard(const Guard &) = delete;
+        Guard &operator=(const Guard &) = delete;
+
+        EpochManager &_manager;
+        std::size_t _thread;
+    };
+
+    EpochManager();
+
+    // Epoch objects unlinked now are to be tagged with
+    uint64_t Current() const { return _epoch.load(std::memory_order_acquire); }
+
+    /**
+     * Advances global epoch if every active reader has observed the current one and
+     * returns the oldest epoch a reader could still be in. Objects tagged with epochs
+     * before it are unreachable for readers and could be freed
+     */
+    uint64_t Collect();
+
+    /**
+     * Returns slot of the calling thread, max_threads if all the slots are taken. Slot
+     * numbers are reused once threads exit
+     */
+    static std::size_t ThisThread();
+
+private:
+    EpochManager(const EpochManager &) = delete;
+    EpochManager &operator=(const EpochManager &) = delete;
+
+    // Epoch announced by a reader, 0 if it isn't inside of a Guard
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> epoch;
+    };
+
+    // Global epoch takes a cache line of its own as well
+    alignas(64) std::atomic<uint64_t> _epoch;
+
+    Slot _slots[max_threads];
+
+    // Number of readers without slot inside of a Guard
+    std::atomic<std::size_t> _overflow;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_EPOCH_MANAGER_H
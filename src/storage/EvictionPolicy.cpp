@@ -0,0 +1,211 @@
+#include "EvictionPolicy.h"
+
+#include <stdexcept>
+
+namespace Afina {
+namespace Backend {
+
+const uint32_t EvictionPolicy::nil;
+const uint8_t SlruPolicy::probation;
+const uint8_t SlruPolicy::protect;
+
+// See EvictionPolicy.h
+std::unique_ptr<EvictionPolicy> EvictionPolicy::Create(Kind kind) {
+    switch (kind) {
+    case Kind::CLOCK:
+        return std::unique_ptr<EvictionPolicy>(new ClockPolicy());
+    case Kind::SLRU:
+        return std::unique_ptr<EvictionPolicy>(new SlruPolicy());
+    default:
+        return std::unique_ptr<EvictionPolicy>(new LruPolicy());
+    }
+}
+
+// See EvictionPolicy.h
+EvictionPolicy::Kind EvictionPolicy::Parse(const std::string &name) {
+    if (name == "lru") {
+        return Kind::LRU;
+    } else if (name == "clock") {
+        return Kind::CLOCK;
+    } else if (name == "slru") {
+        return Kind::SLRU;
+    }
+    throw std::invalid_argument("Unknown eviction policy: " + name);
+}
+
+// See EvictionPolicy.h
+void LruPolicy::Insert(uint32_t number) {
+    if (number >= _links.size()) {
+        _links.resize(number + 1);
+    }
+
+    Links &links = _links[number];
+    links.prev = nil;
+    links.next = _head;
+    if (_head != nil) {
+        _links[_head].prev = number;
+    } else {
+        _tail = number; // There are not elements in the list.
+    }
+    _head = number;
+}
+
+// See EvictionPolicy.h
+void LruPolicy::Touch(uint32_t number) {
+    if (number == _head) return; // This node in head already
+    Erase(number);
+    Insert(number);
+}
+
+// See EvictionPolicy.h
+void LruPolicy::Erase(uint32_t number) {
+    Links &links = _links[number];
+    if (links.next != nil) {
+        _links[links.next].prev = links.prev; // It is not the last node.
+    } else {
+        _tail = links.prev; // It is the last node.
+    }
+
+    if (links.prev != nil) {
+        _links[links.prev].next = links.next; // It is not first node.
+    } else {
+        _head = links.next; // It is first node.
+    }
+}
+
+// See EvictionPolicy.h
+void ClockPolicy::Insert(uint32_t number) {
+    if (number >= _positions.size()) {
+        _positions.resize(number + 1, nil);
+    }
+    _positions[number] = _ring.size();
+    _ring.push_back({number, false});
+}
+
+// See EvictionPolicy.h
+void ClockPolicy::Touch(uint32_t number) {
+    Entry &entry = _ring[_positions[number]];
+    if (!entry.referenced) {
+        entry.referenced = true;
+    }
+}
+
+// See EvictionPolicy.h
+void ClockPolicy::Erase(uint32_t number) {
+    uint32_t position = _positions[number];
+    _ring[position] = _ring.back();
+    _positions[_ring[position].number] = position;
+    _ring.pop_back();
+    _positions[number] = nil;
+}
+
+// See EvictionPolicy.h
+uint32_t ClockPolicy::Victim() {
+    // At most two turns: the first one may only clear reference bits
+    for (;;) {
+        if (_hand >= _ring.size()) {
+            _hand = 0;
+        }
+
+        Entry &entry = _ring[_hand];
+        if (!entry.referenced) {
+            return entry.number;
+        }
+        entry.referenced = false;
+        _hand++;
+    }
+}
+
+// See EvictionPolicy.h
+SlruPolicy::SlruPolicy() {
+    for (auto &list : _lists) {
+        list.head = list.tail = nil;
+        list.size = 0;
+    }
+}
+
+// See EvictionPolicy.h
+void SlruPolicy::Insert(uint32_t number) {
+    if (number >= _entries.size()) {
+        _entries.resize(number + 1);
+    }
+    _entries[number].referenced = 0;
+    Link(number, probation);
+}
+
+// See EvictionPolicy.h
+void SlruPolicy::Touch(uint32_t number) {
+    if (!_entries[number].referenced) {
+        _entries[number].referenced = 1;
+    }
+}
+
+// See EvictionPolicy.h
+void SlruPolicy::Erase(uint32_t number) { Unlink(number); }
+
+// See EvictionPolicy.h
+uint32_t SlruPolicy::Victim() {
+    for (;;) {
+        // Keep protected segment within 80% of nodes
+        List &protect_list = _lists[protect];
+        while (protect_list.size * 5 > (protect_list.size + _lists[probation].size) * 4) {
+            uint32_t number = protect_list.tail;
+            Entry &entry = _entries[number];
+            Unlink(number);
+            if (entry.referenced) {
+                entry.referenced = 0;
+                Link(number, protect);
+            } else {
+                Link(number, probation);
+            }
+        }
+
+        uint32_t number = _lists[probation].tail;
+        Entry &entry = _entries[number];
+        if (!entry.referenced) {
+            return number;
+        }
+
+        // Second hit while on probation
+        entry.referenced = 0;
+        Unlink(number);
+        Link(number, protect);
+    }
+}
+
+// See EvictionPolicy.h
+void SlruPolicy::Link(uint32_t number, uint8_t segment) {
+    Entry &entry = _entries[number];
+    List &list = _lists[segment];
+    entry.segment = segment;
+    entry.prev = nil;
+    entry.next = list.head;
+    if (list.head != nil) {
+        _entries[list.head].prev = number;
+    } else {
+        list.tail = number;
+    }
+    list.head = number;
+    list.size++;
+}
+
+// See EvictionPolicy.h
+void SlruPolicy::Unlink(uint32_t number) {
+    Entry &entry = _entries[number];
+    List &list = _lists[entry.segment];
+    if (entry.next != nil) {
+        _entries[entry.next].prev = entry.prev;
+    } else {
+        list.tail = entry.prev;
+    }
+
+    if (entry.prev != nil) {
+        _entries[entry.prev].next = entry.next;
+    } else {
+        list.head = entry.next;
+    }
+    list.size--;
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,170 @@
+#ifndef AFINA_STORAGE_EVICTION_POLICY_H
+#define AFINA_STORAGE_EVICTION_POLICY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Eviction policy
+ * Decides which node leaves the cache when there is no space. Policy tracks
+ * nodes by their numbers (positions in the cache node table) and keeps its
+ * own per number state, so cache nodes don't depend on the policy in use.
+ *
+ * That is NOT thread safe implementation!!
+ */
+class EvictionPolicy {
+public:
+    enum class Kind {
+        // Strict LRU: every hit moves node to the head of the list
+        LRU,
+        // CLOCK: hit sets reference bit, hand gives referenced nodes a second chance
+        CLOCK,
+        // Segmented LRU: hit sets a flag, node is promoted to protected segment
+        // once it reaches the tail of probation segment with the flag set
+        SLRU
+    };
+
+    /**
+     * Creates policy of the given kind
+     */
+    static std::unique_ptr<EvictionPolicy> Create(Kind kind);
+
+    /**
+     * Parses policy name as used in command line: "lru", "clock" or "slru".
+     * Throws std::invalid_argument for unknown names
+     */
+    static Kind Parse(const std::string &name);
+
+    virtual ~EvictionPolicy() {}
+
+    // Node with the given number entered the cache
+    virtual void Insert(uint32_t number) = 0;
+
+    // Node with the given number was accessed
+    virtual void Touch(uint32_t number) = 0;
+
+    // Node with the given number left the cache
+    virtual void Erase(uint32_t number) = 0;
+
+    // Chooses node to be evicted next, there must be at least one node. Node stays tracked until Erase
+    virtual uint32_t Victim() = 0;
+
+    // Number of bytes policy keeps its per node state in
+    virtual std::size_t MemoryUsage() const = 0;
+
+protected:
+    // Number used instead of missing node
+    static const uint32_t nil = UINT32_MAX;
+};
+
+/**
+ * # Strict LRU
+ * Nodes are kept in a doubly linked list ordered by last access
+ */
+class LruPolicy : public EvictionPolicy {
+public:
+    LruPolicy() : _head(nil), _tail(nil) {}
+
+    void Insert(uint32_t number) override;
+    void Touch(uint32_t number) override;
+    void Erase(uint32_t number) override;
+    uint32_t Victim() override { return _tail; }
+    std::size_t MemoryUsage() const override { return _links.capacity() * sizeof(Links); }
+
+private:
+    struct Links {
+        // Fresher neighbour
+        uint32_t prev;
+        // Older neighbour
+        uint32_t next;
+    };
+
+    std::vector<Links> _links;
+    uint32_t _head;
+    uint32_t _tail;
+};
+
+/**
+ * # CLOCK
+ * Nodes are visited by a hand going round a ring. Hit only sets the reference
+ * bit, and doesn't even write it if bit is set already, so reads of hot nodes
+ * don't dirty shared memory. Ring holds tracked nodes only: erased node's place
+ * is taken by the last one, so the hand never walks over numbers of deleted nodes
+ */
+class ClockPolicy : public EvictionPolicy {
+public:
+    ClockPolicy() : _hand(0) {}
+
+    void Insert(uint32_t number) override;
+    void Touch(uint32_t number) override;
+    void Erase(uint32_t number) override;
+    uint32_t Victim() override;
+    std::size_t MemoryUsage() const override {
+        return _ring.capacity() * sizeof(Entry) + _positions.capacity() * sizeof(uint32_t);
+    }
+
+private:
+    struct Entry {
+        uint32_t number;
+        bool referenced;
+    };
+
+    std::vector<Entry> _ring;
+
+    // Position of the node in the ring by its number, nil if node isn't tracked
+    std::vector<uint32_t> _positions;
+    std::size_t _hand;
+};
+
+/**
+ * # Segmented LRU
+ * New nodes enter probation segment, nodes hit while there are promoted to the
+ * protected segment, which holds at most 80% of nodes. Hit only sets a flag, all
+ * the list work is done lazily when victim is chosen: flagged probation tail
+ * gets promoted, flagged protected tail gets another round in protected segment
+ * and unflagged one is demoted to probation
+ */
+class SlruPolicy : public EvictionPolicy {
+public:
+    SlruPolicy();
+
+    void Insert(uint32_t number) override;
+    void Touch(uint32_t number) override;
+    void Erase(uint32_t number) override;
+    uint32_t Victim() override;
+    std::size_t MemoryUsage() const override { return _entries.capacity() * sizeof(Entry); }
+
+private:
+    static const uint8_t probation = 0;
+    static const uint8_t protect = 1;
+
+    struct Entry {
+        uint32_t prev;
+        uint32_t next;
+        uint8_t segment;
+        uint8_t referenced;
+    };
+
+    struct List {
+        uint32_t head;
+        uint32_t tail;
+        std::size_t size;
+    };
+
+    void Link(uint32_t number, uint8_t segment);
+    void Unlink(uint32_t number);
+
+    std::vector<Entry> _entries;
+    List _lists[2];
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_EVICTION_POLICY_H
@@ -0,0 +1,84 @@
+#include "FrequencySketch.h"
+
+#include <algorithm>
+
+namespace Afina {
+namespace Backend {
+
+const uint32_t FrequencySketch::rows;
+
+// Odd multipliers giving independent positions per row
+static const uint64_t row_seeds[] = {0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL, 0x9ae16a3b2f90404fULL,
+                                     0xcbf29ce484222325ULL};
+
+// See FrequencySketch.h
+FrequencySketch::FrequencySketch(std::size_t capacity) : _table(1, 0), _mask(0), _additions(0), _sample_size(10) {
+    EnsureCapacity(capacity);
+}
+
+// See FrequencySketch.h
+void FrequencySketch::Increment(uint32_t hash) {
+    bool added = false;
+    for (uint32_t row = 0; row < rows; row++) {
+        uint64_t &word = _table[Index(hash, row)];
+        uint32_t shift = Shift(hash, row);
+        if (((word >> shift) & 0xf) != 0xf) {
+            word += uint64_t(1) << shift;
+            added = true;
+        }
+    }
+
+    if (added && ++_additions >= _sample_size) {
+        Age();
+    }
+}
+
+// See FrequencySketch.h
+uint32_t FrequencySketch::Frequency(uint32_t hash) const {
+    uint32_t frequency = 0xf;
+    for (uint32_t row = 0; row < rows; row++) {
+        uint32_t counter = (_table[Index(hash, row)] >> Shift(hash, row)) & 0xf;
+        frequency = std::min(frequency, counter);
+    }
+    return frequency;
+}
+
+// See FrequencySketch.h
+void FrequencySketch::EnsureCapacity(std::size_t capacity) {
+    std::size_t width = 16;
+    while (width < capacity) {
+        width *= 2;
+    }
+    if (width <= _table.size()) {
+        return;
+    }
+
+    // Position of a counter in the wider table has the same low bits as before, so every word
+    // of the old table is copied to all the positions its counters could move to and estimates
+    // stay the same
+    std::vector<uint64_t> table(width);
+    for (std::size_t i = 0; i < width; i++) {
+        table[i] = _table[i & _mask];
+    }
+    _table.swap(table);
+    _mask = width - 1;
+    _sample_size = 10 * width;
+}
+
+// See FrequencySketch.h
+std::size_t FrequencySketch::Index(uint32_t hash, uint32_t row) const {
+    uint64_t h = (hash + row_seeds[row]) * row_seeds[row];
+    h += h >> 32;
+    return h & _mask;
+}
+
+// See FrequencySketch.h
+void FrequencySketch::Age() {
+    for (uint64_t &word : _table) {
+        word = (word >> 1) & 0x7777777777777777ULL;
+    }
+    _additions /= 2;
+}
+
+} // namespace Backend
+} // namespace Afina
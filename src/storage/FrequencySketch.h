@@ -0,0 +1,77 @@
+#ifndef AFINA_STORAGE_FREQUENCY_SKETCH_H
+#define AFINA_STORAGE_FREQUENCY_SKETCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Count-min sketch of access frequencies
+ * Estimates how often a key was seen recently using fixed amount of memory:
+ * 4 rows of 4-bit counters packed 16 per word, estimate is the minimum over
+ * rows, so it is never below the real count but could be above it because of
+ * collisions. Counters saturate at 15, that is enough to tell hot keys from
+ * one-off ones.
+ *
+ * Sketch ages: once the number of increments reaches ten times its width all
+ * counters are halved, so keys that used to be popular long ago lose their
+ * advantage over the currently popular ones.
+ *
+ * That is NOT thread safe implementation!!
+ */
+class FrequencySketch {
+public:
+    /**
+     * @param capacity expected number of distinct keys worth tracking, sketch width
+     * is rounded up to power of 2
+     */
+    FrequencySketch(std::size_t capacity = 16);
+
+    // Counts one more access to the key with the given hash
+    void Increment(uint32_t hash);
+
+    // Returns estimated number of recent accesses to the key with the given hash, 0..15
+    uint32_t Frequency(uint32_t hash) const;
+
+    /**
+     * Makes sketch wide enough for the given number of keys, collected frequencies are kept
+     */
+    void EnsureCapacity(std::size_t capacity);
+
+    // Number of keys sketch is sized for
+    std::size_t Capacity() const { return _table.size(); }
+
+    // Number of increments since the last aging
+    std::size_t Size() const { return _additions; }
+
+    // Number of bytes used by counters
+    std::size_t MemoryUsage() const { return _table.capacity() * sizeof(uint64_t); }
+
+private:
+    static const uint32_t rows = 4;
+
+    // Position of counter for the hash in the given row: word and bit shift inside of it
+    std::size_t Index(uint32_t hash, uint32_t row) const;
+    static uint32_t Shift(uint32_t hash, uint32_t row) { return (((hash & 3) << 2) + row) << 2; }
+
+    // Halves all counters
+    void Age();
+
+    // Each word holds 16 counters, each key owns one counter of a word per row
+    std::vector<uint64_t> _table;
+
+    // _table.size() - 1
+    std::size_t _mask;
+
+    // Increments since the last aging and number of them that triggers aging
+    std::size_t _additions;
+    std::size_t _sample_size;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_FREQUENCY_SKETCH_H
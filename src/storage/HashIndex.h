@@ -0,0 +1,251 @@
+#ifndef AFINA_STORAGE_HASH_INDEX_H
+#define AFINA_STORAGE_HASH_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * 64-bit MurmurHash2 (MurmurHash64A by Austin Appleby, public domain) over the
+ * given bytes. Used everywhere in storage so that shard selection and index
+ * buckets could be derived from the same value: shards take high bits, index
+ * takes low bits.
+ */
+inline uint64_t HashBytes(const char *data, size_t size) {
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+
+    uint64_t h = 0x9747b28c ^ (size * m);
+
+    const char *end = data + (size & ~size_t(7));
+    for (; data != end; data += 8) {
+        uint64_t k;
+        std::memcpy(&k, data, sizeof(k));
+
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+
+        h ^= k;
+        h *= m;
+    }
+
+    switch (size & 7) {
+    case 7:
+        h ^= uint64_t(static_cast<unsigned char>(data[6])) << 48;
+        // fall through
+    case 6:
+        h ^= uint64_t(static_cast<unsigned char>(data[5])) << 40;
+        // fall through
+    case 5:
+        h ^= uint64_t(static_cast<unsigned char>(data[4])) << 32;
+        // fall through
+    case 4:
+        h ^= uint64_t(static_cast<unsigned char>(data[3])) << 24;
+        // fall through
+    case 3:
+        h ^= uint64_t(static_cast<unsigned char>(data[2])) << 16;
+        // fall through
+    case 2:
+        h ^= uint64_t(static_cast<unsigned char>(data[1])) << 8;
+        // fall through
+    case 1:
+        h ^= uint64_t(static_cast<unsigned char>(data[0]));
+        h *= m;
+    };
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+/**
+ * # Open addressing hash index
+ * Maps precomputed key hashes onto values of type T (usually node pointers or
+ * node numbers). Index doesn't know anything about keys: lookup takes a hash
+ * and a predicate that checks whether stored value is the one caller looks for,
+ * so caller is free to compare keys given as pointer+length without building
+ * std::string.
+ *
+ * Slots live in a single flat array and are probed linearly, each slot keeps
+ * 32 bits of the hash, so most of mismatches are rejected without touching the
+ * value. Growing doesn't need keys either: slots are redistributed by stored hash.
+ * Removal uses backward shift, so there are no tombstones and probe sequences
+ * stay short under delete heavy workloads.
+ *
+ * That is NOT thread safe implementation!!
+ */
+template <typename T> class HashIndex {
+public:
+    HashIndex(size_t capacity = 16) : _size(0) { Allocate(capacity); }
+
+    /**
+     * Returns pointer to the value stored for the hash that satisfies given
+     * predicate, or nullptr if there is no such value. Pointer stays valid until
+     * next Insert or Erase.
+     *
+     * @param hash of the key to look for
+     * @param eq predicate, called as eq(const T &) and must return true for the value being looked for
+     */
+    template <typename Eq> T *Find(uint64_t hash, Eq eq) {
+        size_t i = Lookup(hash, eq);
+        return i != npos ? &_slots[i].value : nullptr;
+    }
+
+    /**
+     * Hints CPU to bring slot the lookup for the given hash starts from into cache, so that
+     * lookups of a batch of keys could wait for memory in parallel
+     *
+     * @param hash of the key to be looked for soon
+     */
+    void Prefetch(uint64_t hash) const { __builtin_prefetch(&_slots[Tag(hash) & _mask]); }
+
+    /**
+     * Adds new value for the given hash. Caller must ensure that value for the same key
+     * isn't present in the index yet
+     *
+     * @param hash of the key value is stored for
+     * @param value to be stored
+     */
+    void Insert(uint64_t hash, const T &value) {
+        if ((_size + 1) * 8 > _slots.size() * 7) {
+            Grow();
+        }
+
+        const uint32_t tag = Tag(hash);
+        size_t i = tag & _mask;
+        while (_slots[i].tag != 0) {
+            i = (i + 1) & _mask;
+        }
+
+        _slots[i].tag = tag;
+        _slots[i].value = value;
+        _size++;
+    }
+
+    /**
+     * Removes value stored for the given hash that satisfies given predicate.
+     * Returns false if there is no such value
+     *
+     * @param hash of the key to remove
+     * @param eq predicate, see Find
+     */
+    template <typename Eq> bool Erase(uint64_t hash, Eq eq) {
+        size_t i = Lookup(hash, eq);
+        if (i == npos) {
+            return false;
+        }
+
+        for (size_t j = i;;) {
+            j = (j + 1) & _mask;
+            if (_slots[j].tag == 0) {
+                break;
+            }
+
+            // Slot j could be moved back only if i is on its probe path, that is
+            // between its ideal position and j
+            size_t ideal = _slots[j].tag & _mask;
+            if (((j - ideal) & _mask) >= ((j - i) & _mask)) {
+                _slots[i] = _slots[j];
+                i = j;
+            }
+        }
+
+        _slots[i].tag = 0;
+        _size--;
+        return true;
+    }
+
+    // Drops all values, keeps current capacity
+    void Clear() {
+        for (auto &slot : _slots) {
+            slot.tag = 0;
+        }
+        _size = 0;
+    }
+
+    // Number of values stored
+    size_t Size() const { return _size; }
+
+    // Number of slots allocated
+    size_t Capacity() const { return _slots.size(); }
+
+    // Number of bytes used by the slots array
+    size_t MemoryUsage() const { return _slots.size() * sizeof(Slot); }
+
+private:
+    struct Slot {
+        T value;
+        // 32 bits of the hash, 0 marks an empty slot
+        uint32_t tag;
+    };
+
+    static const size_t npos = ~size_t(0);
+
+    // Returns position of the slot with value satisfying predicate or npos
+    template <typename Eq> size_t Lookup(uint64_t hash, Eq eq) const {
+        const uint32_t tag = Tag(hash);
+        for (size_t i = tag & _mask;; i = (i + 1) & _mask) {
+            const Slot &slot = _slots[i];
+            if (slot.tag == 0) {
+                return npos;
+            }
+            if (slot.tag == tag && eq(slot.value)) {
+                return i;
+            }
+        }
+    }
+
+    // Hash bits stored in the slot, never zero
+    static uint32_t Tag(uint64_t hash) {
+        uint32_t tag = static_cast<uint32_t>(hash);
+        return tag != 0 ? tag : 1;
+    }
+
+    void Allocate(size_t capacity) {
+        size_t slots = 16;
+        while (slots < capacity) {
+            slots *= 2;
+        }
+
+        _slots.assign(slots, Slot());
+        _mask = slots - 1;
+    }
+
+    void Grow() {
+        std::vector<Slot> old;
+        old.swap(_slots);
+        Allocate(old.size() * 2);
+
+        for (auto &slot : old) {
+            if (slot.tag == 0) {
+                continue;
+            }
+
+            size_t i = slot.tag & _mask;
+            while (_slots[i].tag != 0) {
+                i = (i + 1) & _mask;
+            }
+            _slots[i] = slot;
+        }
+    }
+
+    // Slots array, size is always power of 2
+    std::vector<Slot> _slots;
+
+    // _slots.size() - 1
+    size_t _mask;
+
+    // Number of non empty slots
+    size_t _size;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_HASH_INDEX_H
@@ -0,0 +1,210 @@
+#include "LzBlock.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace Afina {
+namespace Backend {
+
+static const uint32_t hash_log = 12;
+static const std::size_t min_match = 4;
+static const std::size_t max_offset = 65535;
+
+// Block always ends with literals: last match starts 12 bytes before the end at the latest
+// and ends 5 bytes before it, as the format requires
+static const std::size_t match_start_limit = 12;
+static const std::size_t last_literals = 5;
+
+// Compressor looks for matches less often the longer it can't find one
+static const std::size_t skip_trigger = 6;
+
+static uint32_t Read32(const uint8_t *p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint32_t Hash32(uint32_t sequence) { return (sequence * 2654435761U) >> (32 - hash_log); }
+
+// Writes length that doesn't fit into the token as a run of 255 and the remainder
+static uint8_t *WriteLength(uint8_t *op, std::size_t length) {
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = uint8_t(length);
+    return op;
+}
+
+// Writes literals followed by the match, match_length 0 means literals close the block.
+// Returns nullptr if there is no room
+static uint8_t *WriteSequence(uint8_t *op, uint8_t *oend, const uint8_t *literals, std::size_t literal_length,
+                              std::size_t offset, std::size_t match_length) {
+    std::size_t needed = 1 + literal_length / 255 + 1 + literal_length + 2 + match_length / 255 + 1;
+    uint8_t *token = op;
+    if (std::size_t(oend - op) < needed) {
+        return nullptr;
+    }
+
+    op++;
+    if (literal_length >= 15) {
+        *token = 15 << 4;
+        op = WriteLength(op, literal_length - 15);
+    } else {
+        *token = uint8_t(literal_length << 4);
+    }
+    std::memcpy(op, literals, literal_length);
+    op += literal_length;
+    if (match_length == 0) {
+        return op;
+    }
+
+    *op++ = uint8_t(offset & 0xff);
+    *op++ = uint8_t(offset >> 8);
+    match_length -= min_match;
+    if (match_length >= 15) {
+        *token |= 15;
+        op = WriteLength(op, match_length - 15);
+    } else {
+        *token |= uint8_t(match_length);
+    }
+    return op;
+}
+
+// Reads length continued after the token, returns false if block ends in the middle of it
+static bool ReadLength(const uint8_t *&ip, const uint8_t *iend, std::size_t &length) {
+    uint8_t byte;
+    do {
+        if (ip == iend) {
+            return false;
+        }
+        byte = *ip++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+// See LzBlock.h
+std::size_t LzBlock::CompressBound(std::size_t size) { return size + size / 255 + 16; }
+
+// See LzBlock.h
+std::size_t LzBlock::Compress(const void *src, std::size_t src_size, void *dst, std::size_t dst_capacity) {
+    const uint8_t *const base = static_cast<const uint8_t *>(src);
+    const uint8_t *const end = base + src_size;
+    const uint8_t *ip = base;
+    const uint8_t *anchor = base;
+    uint8_t *op = static_cast<uint8_t *>(dst);
+    uint8_t *const oend = op + dst_capacity;
+    uint32_t table[1 << hash_log];
+
+    if (src_size > UINT32_MAX) {
+        return 0;
+    }
+
+    if (src_size > match_start_limit) {
+        const uint8_t *const match_start_end = end - match_start_limit;
+        const uint8_t *const match_end_limit = end - last_literals;
+        std::size_t attempts = 1 << skip_trigger;
+
+        // Stale or zero entries are harmless: candidate is checked byte by byte
+        std::memset(table, 0, sizeof(table));
+        ip++;
+        while (ip < match_start_end) {
+            uint32_t sequence = Read32(ip);
+            uint32_t h = Hash32(sequence);
+            const uint8_t *ref = base + table[h];
+            table[h] = uint32_t(ip - base);
+
+            if (ref >= ip || std::size_t(ip - ref) > max_offset || Read32(ref) != sequence) {
+                ip += attempts++ >> skip_trigger;
+                continue;
+            }
+            attempts = 1 << skip_trigger;
+
+            // Extend match backwards over literals and forwards up to the limit
+            while (ip > anchor && ref > base && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+            std::size_t length = min_match;
+            while (ip + length < match_end_limit && ip[length] == ref[length]) {
+                length++;
+            }
+
+            op = WriteSequence(op, oend, anchor, ip - anchor, ip - ref, length);
+            if (op == nullptr) {
+                return 0;
+            }
+            ip += length;
+            anchor = ip;
+            if (ip < match_start_end) {
+                table[Hash32(Read32(ip - 2))] = uint32_t(ip - 2 - base);
+            }
+        }
+    }
+
+    op = WriteSequence(op, oend, anchor, end - anchor, 0, 0);
+    if (op == nullptr) {
+        return 0;
+    }
+    return op - static_cast<uint8_t *>(dst);
+}
+
+// See LzBlock.h
+long LzBlock::Decompress(const void *src, std::size_t src_size, void *dst, std::size_t dst_size) {
+    const uint8_t *ip = static_cast<const uint8_t *>(src);
+    const uint8_t *const iend = ip + src_size;
+    uint8_t *const begin = static_cast<uint8_t *>(dst);
+    uint8_t *op = begin;
+    uint8_t *const oend = op + dst_size;
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+        std::size_t literal_length = token >> 4;
+        std::size_t match_length = token & 15;
+
+        if (literal_length == 15 && !ReadLength(ip, iend, literal_length)) {
+            return -1;
+        }
+        if (literal_length > std::size_t(iend - ip) || literal_length > std::size_t(oend - op)) {
+            return -1;
+        }
+        std::memcpy(op, ip, literal_length);
+        op += literal_length;
+        ip += literal_length;
+        if (ip == iend) {
+            break;
+        }
+
+        if (iend - ip < 2) {
+            return -1;
+        }
+        std::size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > std::size_t(op - begin)) {
+            return -1;
+        }
+        if (match_length == 15 && !ReadLength(ip, iend, match_length)) {
+            return -1;
+        }
+        match_length += min_match;
+        if (match_length > std::size_t(oend - op)) {
+            return -1;
+        }
+
+        // Overlapping match repeats the last offset bytes
+        const uint8_t *match = op - offset;
+        if (offset >= match_length) {
+            std::memcpy(op, match, match_length);
+            op += match_length;
+        } else {
+            while (match_length-- != 0) {
+                *op++ = *match++;
+            }
+        }
+    }
+    return op - begin;
+}
+
+} // namespace Backend
+} // namespace Afina
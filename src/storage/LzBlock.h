@@ -0,0 +1,46 @@
+#ifndef AFINA_STORAGE_LZ_BLOCK_H
+#define AFINA_STORAGE_LZ_BLOCK_H
+
+#include <cstddef>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # LZ77 block codec for in-memory values
+ * Compressed stream follows LZ4 block format, so blocks could be checked with any
+ * LZ4 block decoder. Only single blocks are supported: there is no frame, no
+ * checksum and no dictionary, caller keeps the raw size next to the block.
+ *
+ * Compressor is greedy with a single 4096-entry hash table on the stack and skips
+ * ahead faster over data that doesn't compress. Decompressor checks every length
+ * and offset and never reads or writes out of the given buffers, so damaged block
+ * is reported instead of crashing.
+ *
+ * Functions keep no state and are safe to call from many threads at once.
+ */
+class LzBlock {
+public:
+    /**
+     * Maximum size of compressed block for input of the given size, input that
+     * doesn't compress grows a bit
+     */
+    static std::size_t CompressBound(std::size_t size);
+
+    /**
+     * Compresses src_size bytes from src into dst. Returns size of compressed block
+     * or 0 if it doesn't fit into dst_capacity bytes. Input must be smaller than 4GB
+     */
+    static std::size_t Compress(const void *src, std::size_t src_size, void *dst, std::size_t dst_capacity);
+
+    /**
+     * Decompresses block of src_size bytes into dst. Returns number of bytes written
+     * or -1 if block is malformed or would decompress into more than dst_size bytes
+     */
+    static long Decompress(const void *src, std::size_t src_size, void *dst, std::size_t dst_size);
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_LZ_BLOCK_H
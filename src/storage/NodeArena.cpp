@@ -0,0 +1,120 @@
+#include "NodeArena.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace Afina {
+namespace Backend {
+
+const std::size_t NodeArena::granularity;
+const std::size_t NodeArena::max_small;
+const std::size_t NodeArena::chunk_size;
+const std::size_t NodeArena::malloc_overhead;
+
+// See NodeArena.h
+NodeArena::NodeArena(std::shared_ptr<Allocator::ConcurrentSlabAllocator> slabs)
+    : _free_lists(max_small / granularity, nullptr), _chunk_pos(nullptr), _chunk_end(nullptr), _reserved(0),
+      _slabs(std::move(slabs)) {}
+
+// See NodeArena.h
+NodeArena::~NodeArena() {
+    for (char *chunk : _chunks) {
+        std::free(chunk);
+    }
+}
+
+// See NodeArena.h
+std::size_t NodeArena::BlockSize(std::size_t size) const {
+    if (_slabs != nullptr) {
+        return size > _slabs->MaxSize() ? size : _slabs->ClassSize(size);
+    }
+    if (size > max_small) {
+        return size;
+    }
+    return (size + granularity - 1) / granularity * granularity;
+}
+
+// See NodeArena.h
+std::size_t NodeArena::Footprint(std::size_t size) const {
+    size = BlockSize(size);
+    return size > MaxBlock() ? size + malloc_overhead : size;
+}
+
+// See NodeArena.h
+void *NodeArena::Allocate(std::size_t size) {
+    size = BlockSize(size);
+    if (_slabs != nullptr && size <= _slabs->MaxSize()) {
+        void *block = _slabs->Allocate(size);
+        if (block != nullptr) {
+            _reserved += size;
+        }
+        return block;
+    }
+    if (size > MaxBlock()) {
+        void *block = std::malloc(size);
+        if (block == nullptr) {
+            throw std::bad_alloc();
+        }
+        _reserved += size + malloc_overhead;
+        return block;
+    }
+
+    // Reuse freed block of the same class
+    void *&free_list = _free_lists[size / granularity - 1];
+    if (free_list != nullptr) {
+        void *block = free_list;
+        free_list = *static_cast<void **>(block);
+        return block;
+    }
+
+    // Carve a new one out of the current chunk, rest of the chunk is lost if block doesn't fit
+    if (_chunk_pos == nullptr || std::size_t(_chunk_end - _chunk_pos) < size) {
+        char *chunk = static_cast<char *>(std::malloc(chunk_size));
+        if (chunk == nullptr) {
+            throw std::bad_alloc();
+        }
+        _chunks.push_back(chunk);
+        _chunk_pos = chunk;
+        _chunk_end = chunk + chunk_size;
+        _reserved += chunk_size + malloc_overhead;
+    }
+
+    void *block = _chunk_pos;
+    _chunk_pos += size;
+    return block;
+}
+
+// See NodeArena.h
+void NodeArena::Release(void *block, std::size_t size) {
+    size = BlockSize(size);
+    if (_slabs != nullptr && size <= _slabs->MaxSize()) {
+        _slabs->Free(block, size);
+        _reserved -= size;
+        return;
+    }
+    if (size > MaxBlock()) {
+        std::free(block);
+        _reserved -= size + malloc_overhead;
+        return;
+    }
+
+    void *&free_list = _free_lists[size / granularity - 1];
+    *static_cast<void **>(block) = free_list;
+    free_list = block;
+}
+
+// See NodeArena.h
+bool NodeArena::Available(std::size_t size) {
+    size = BlockSize(size);
+    return _slabs == nullptr || size > _slabs->MaxSize() || _slabs->Available(size);
+}
+
+// See NodeArena.h
+void NodeArena::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    if (_slabs != nullptr) {
+        _slabs->Stats(stats);
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,111 @@
+#ifndef AFINA_STORAGE_NODE_ARENA_H
+#define AFINA_STORAGE_NODE_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <afina/allocator/ConcurrentSlabAllocator.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Arena for storage nodes
+ * Small blocks are carved out of big chunks and rounded up to size classes of
+ * 16 bytes, freed blocks are kept in per class free lists and reused by the next
+ * allocation of the same class. Blocks don't have any header, so caller must pass
+ * size of the block back on release. Blocks bigger than the largest class go to
+ * malloc directly.
+ *
+ * Chunks are returned to the system only when arena is destroyed.
+ *
+ * Arena could take blocks from a slab allocator shared with other arenas instead: block
+ * sizes are then geometric size classes of SlabAllocator, up to a quarter of a slab, and
+ * slabs a class doesn't need anymore are given to other classes. Blocks bigger than that
+ * still go to malloc.
+ *
+ * That is NOT thread safe implementation!!
+ */
+class NodeArena {
+public:
+    // Takes memory from the given slab allocator if there is one, from malloc otherwise
+    explicit NodeArena(std::shared_ptr<Allocator::ConcurrentSlabAllocator> slabs = nullptr);
+    ~NodeArena();
+
+    /**
+     * Returns number of bytes block allocated for the given size actually has,
+     * caller is free to use all of them
+     */
+    std::size_t BlockSize(std::size_t size) const;
+
+    /**
+     * Returns number of bytes of process memory block allocated for the given size costs:
+     * BlockSize plus header malloc keeps in front of blocks that don't fit arena classes
+     */
+    std::size_t Footprint(std::size_t size) const;
+
+    /**
+     * Allocates block of BlockSize(size) bytes. Returns nullptr if shared slabs are out
+     * of blocks of that size, throws std::bad_alloc if malloc has no memory left
+     */
+    void *Allocate(std::size_t size);
+
+    /**
+     * True if block of the given size could likely be allocated now, other arenas could take
+     * it first. Only slabs of the shared allocator run out, malloc is assumed to be always there
+     */
+    bool Available(std::size_t size);
+
+    /**
+     * Returns block back to the arena, size must have the same BlockSize as the one
+     * block was allocated for
+     */
+    void Release(void *block, std::size_t size);
+
+    /**
+     * Number of bytes taken from the system, including malloc headers. Slabs are shared, so only
+     * blocks this arena has taken from them are counted
+     */
+    std::size_t Reserved() const { return _reserved; }
+
+    // Appends occupancy of slabs to the list if arena takes memory from them, see ConcurrentSlabAllocator::Stats
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats);
+
+private:
+    NodeArena(const NodeArena &) = delete;
+    NodeArena &operator=(const NodeArena &) = delete;
+
+    // Largest block served by size classes, bigger ones go to malloc
+    std::size_t MaxBlock() const { return _slabs != nullptr ? _slabs->MaxSize() : max_small; }
+
+    static const std::size_t granularity = 16;
+    static const std::size_t max_small = 1024;
+    static const std::size_t chunk_size = 1 << 20;
+
+    // Estimate of memory malloc spends on bookkeeping of a single block
+    static const std::size_t malloc_overhead = 2 * sizeof(std::size_t);
+
+    // Heads of free lists, one per size class. Free block keeps pointer to the next one in
+    // its first bytes
+    std::vector<void *> _free_lists;
+
+    // All chunks allocated so far
+    std::vector<char *> _chunks;
+
+    // Not yet used part of the last chunk
+    char *_chunk_pos;
+    char *_chunk_end;
+
+    std::size_t _reserved;
+
+    // Slab allocator shared with other arenas, null if blocks come from malloc
+    std::shared_ptr<Allocator::ConcurrentSlabAllocator> _slabs;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_NODE_ARENA_H
@@ -0,0 +1,387 @@
+#include "OperationLog.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "HashIndex.h"
+
+namespace Afina {
+namespace Backend {
+
+const std::size_t OperationLog::max_group_bytes;
+
+namespace {
+
+const char log_magic[8] = {'A', 'F', 'N', 'W', 'A', 'L', 0, 1};
+
+const char record_put = 1;
+const char record_delete = 2;
+
+struct SegmentHeader {
+    char magic[8];
+    uint64_t generation;
+};
+
+struct RecordHeader {
+    uint32_t checksum;
+    uint32_t key_size;
+    uint32_t value_size;
+    uint32_t flags;
+    uint32_t expire;
+    char type;
+    char padding[3];
+};
+
+// Checksum of the record past the checksum field itself
+uint32_t Checksum(const char *record, std::size_t size) {
+    return static_cast<uint32_t>(HashBytes(record + sizeof(uint32_t), size - sizeof(uint32_t)));
+}
+
+bool WriteAll(int fd, const char *data, std::size_t size) {
+    while (size != 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+bool ReadFile(const std::string &path, std::string &content) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    char buffer[64 * 1024];
+    ssize_t read_size;
+    while ((read_size = read(fd, buffer, sizeof(buffer))) != 0) {
+        if (read_size < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            close(fd);
+            return false;
+        }
+        content.append(buffer, read_size);
+    }
+    close(fd);
+    return true;
+}
+
+// Makes creation and removal of files in the directory durable
+void SyncDirectory(const std::string &path) {
+    std::string copy = path;
+    int dir = open(dirname(&copy[0]), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir >= 0) {
+        fsync(dir);
+        close(dir);
+    }
+}
+
+} // namespace
+
+// See OperationLog.h
+OperationLog::OperationLog(const std::string &path, uint32_t window)
+    : _path(path), _window(window), _fd(-1), _last_generation(0), _running(false), _failed(false), _rotate_to(0),
+      _generation(0), _logged(0), _durable(0), _bytes(0), _commits(0), _max_group(0), _replayed(0), _damaged(0) {}
+
+// See OperationLog.h
+OperationLog::~OperationLog() { Stop(); }
+
+// See OperationLog.h
+std::size_t OperationLog::Replay(Storage &storage, uint64_t generation) {
+    std::size_t applied = 0;
+    for (uint64_t segment : ListSegments()) {
+        _last_generation = std::max(_last_generation, segment);
+        if (segment < generation) {
+            // Changes are in the snapshot already
+            unlink(SegmentPath(segment).c_str());
+            continue;
+        }
+
+        std::string content;
+        if (!ReadFile(SegmentPath(segment), content)) {
+            throw std::runtime_error("Failed to read " + SegmentPath(segment) + ": " + std::strerror(errno));
+        }
+        const SegmentHeader *header = reinterpret_cast<const SegmentHeader *>(content.data());
+        if (content.size() < sizeof(SegmentHeader) || std::memcmp(header->magic, log_magic, sizeof(log_magic)) != 0 ||
+            header->generation != segment) {
+            _damaged++;
+            continue;
+        }
+
+        std::size_t position = sizeof(SegmentHeader);
+        while (position != content.size()) {
+            RecordHeader record;
+            if (content.size() - position < sizeof(record)) {
+                _damaged++;
+                break;
+            }
+            std::memcpy(&record, content.data() + position, sizeof(record));
+            std::size_t size = sizeof(record) + std::size_t(record.key_size) + record.value_size;
+            if (content.size() - position < size ||
+                Checksum(content.data() + position, size) != record.checksum) {
+                _damaged++;
+                break;
+            }
+
+            std::string key(content.data() + position + sizeof(record), record.key_size);
+            if (record.type == record_put) {
+                storage.Put(key, std::string(content.data() + position + sizeof(record) + record.key_size,
+                                             record.value_size),
+                            record.flags, record.expire);
+            } else {
+                storage.Delete(key);
+            }
+            position += size;
+            applied++;
+        }
+    }
+    _replayed += applied;
+    return applied;
+}
+
+// See OperationLog.h
+void OperationLog::Start(uint64_t generation) {
+    if (!OpenSegment(std::max(generation, _last_generation + 1))) {
+        throw std::runtime_error("Failed to create " + SegmentPath(std::max(generation, _last_generation + 1)) +
+                                 ": " + std::strerror(errno));
+    }
+    _running = true;
+    _thread = std::thread(&OperationLog::OnRun, this);
+}
+
+// See OperationLog.h
+void OperationLog::Stop() {
+    if (_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            _running = false;
+        }
+        _wakeup.notify_all();
+        _thread.join();
+    }
+    if (_fd >= 0) {
+        close(_fd);
+        _fd = -1;
+    }
+}
+
+// See OperationLog.h
+uint64_t OperationLog::Put(const std::string &key, const char *value, std::size_t size, uint32_t flags,
+                           time_t expire) {
+    return Append(record_put, key, value, size, flags, expire);
+}
+
+// See OperationLog.h
+uint64_t OperationLog::Delete(const std::string &key) { return Append(record_delete, key, "", 0, 0, 0); }
+
+// See OperationLog.h
+bool OperationLog::Commit(uint64_t record) {
+    std::unique_lock<std::mutex> lock(_lock);
+    if (_window.count() == 0) {
+        _committed.wait(lock, [this, record] { return _durable >= record || _failed; });
+    }
+    return record != 0 && !_failed;
+}
+
+// See OperationLog.h
+bool OperationLog::Failed() {
+    std::lock_guard<std::mutex> lock(_lock);
+    return _failed;
+}
+
+// See OperationLog.h
+uint64_t OperationLog::Rotate() {
+    std::unique_lock<std::mutex> lock(_lock);
+    if (_failed || !_running) {
+        return 0;
+    }
+    uint64_t generation = _generation + 1;
+    _rotate_to = generation;
+    _wakeup.notify_all();
+    _committed.wait(lock, [this] { return _rotate_to == 0 || _failed; });
+    return _failed ? 0 : generation;
+}
+
+// See OperationLog.h
+void OperationLog::Compact(uint64_t generation) {
+    bool removed = false;
+    for (uint64_t segment : ListSegments()) {
+        if (segment < generation) {
+            unlink(SegmentPath(segment).c_str());
+            removed = true;
+        }
+    }
+    if (removed) {
+        SyncDirectory(_path);
+    }
+}
+
+// See OperationLog.h
+void OperationLog::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    std::lock_guard<std::mutex> lock(_lock);
+    stats.emplace_back("wal_generation", std::to_string(_generation));
+    stats.emplace_back("wal_records", std::to_string(_logged));
+    stats.emplace_back("wal_bytes", std::to_string(_bytes));
+    stats.emplace_back("wal_pending_bytes", std::to_string(_pending.size()));
+    stats.emplace_back("wal_commits", std::to_string(_commits));
+    stats.emplace_back("wal_max_group", std::to_string(_max_group));
+    stats.emplace_back("wal_failed", _failed ? "1" : "0");
+    stats.emplace_back("wal_replayed", std::to_string(_replayed));
+    stats.emplace_back("wal_damaged", std::to_string(_damaged));
+}
+
+// See OperationLog.h
+void OperationLog::OnRun() {
+    std::unique_lock<std::mutex> lock(_lock);
+    while (true) {
+        _wakeup.wait(lock, [this] { return !_running || !_pending.empty() || _rotate_to != 0; });
+
+        // Wait for the group to grow unless somebody needs it durable right away
+        if (_window.count() != 0 && _running && _rotate_to == 0) {
+            _wakeup.wait_until(lock, _pending_since + _window, [this] {
+                return !_running || _rotate_to != 0 || _pending.size() >= max_group_bytes;
+            });
+        }
+        if (_pending.empty() && _rotate_to == 0) {
+            if (!_running) {
+                break;
+            }
+            continue;
+        }
+
+        std::string group;
+        group.swap(_pending);
+        uint64_t last = _logged;
+        uint64_t rotate_to = _rotate_to;
+        uint64_t records = last - _durable;
+        lock.unlock();
+
+        // Records logged meanwhile make the next group
+        bool done = !_failed && WriteAll(_fd, group.data(), group.size()) && fdatasync(_fd) == 0;
+        if (done && rotate_to != 0) {
+            close(_fd);
+            _fd = -1;
+            done = OpenSegment(rotate_to);
+        }
+
+        lock.lock();
+        if (done) {
+            _durable = last;
+            _bytes += group.size();
+            _commits++;
+            _max_group = std::max(_max_group, records);
+        } else {
+            _failed = true;
+        }
+        if (rotate_to != 0) {
+            // Rotation requested while the group was being written waits for the next one
+            _rotate_to = 0;
+        }
+        _committed.notify_all();
+    }
+}
+
+// See OperationLog.h
+uint64_t OperationLog::Append(char type, const std::string &key, const char *value, std::size_t size,
+                              uint32_t flags, time_t expire) {
+    RecordHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.key_size = key.size();
+    header.value_size = size;
+    header.flags = flags;
+    header.expire = expire;
+    header.type = type;
+
+    // Record is encoded before the lock is taken
+    std::string record;
+    record.reserve(sizeof(header) + key.size() + size);
+    record.append(reinterpret_cast<const char *>(&header), sizeof(header));
+    record.append(key);
+    record.append(value, size);
+    header.checksum = Checksum(record.data(), record.size());
+    std::memcpy(&record[0], &header.checksum, sizeof(header.checksum));
+
+    std::lock_guard<std::mutex> lock(_lock);
+    if (_failed || !_running) {
+        return 0;
+    }
+    bool was_empty = _pending.empty();
+    if (was_empty) {
+        _pending_since = std::chrono::steady_clock::now();
+    }
+    _pending.append(record);
+    if (was_empty || _pending.size() >= max_group_bytes) {
+        _wakeup.notify_all();
+    }
+    return ++_logged;
+}
+
+// See OperationLog.h
+bool OperationLog::OpenSegment(uint64_t generation) {
+    std::string path = SegmentPath(generation);
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    SegmentHeader header;
+    std::memcpy(header.magic, log_magic, sizeof(header.magic));
+    header.generation = generation;
+    if (!WriteAll(fd, reinterpret_cast<const char *>(&header), sizeof(header)) || fsync(fd) != 0) {
+        close(fd);
+        unlink(path.c_str());
+        return false;
+    }
+    SyncDirectory(path);
+
+    std::lock_guard<std::mutex> lock(_lock);
+    _fd = fd;
+    _generation = generation;
+    return true;
+}
+
+// See OperationLog.h
+std::vector<uint64_t> OperationLog::ListSegments() {
+    std::string directory = _path, name = _path;
+    directory = dirname(&directory[0]);
+    name = std::string(basename(&name[0])) + ".";
+
+    std::vector<uint64_t> segments;
+    DIR *dir = opendir(directory.c_str());
+    if (dir == nullptr) {
+        throw std::runtime_error("Failed to read " + directory + ": " + std::strerror(errno));
+    }
+    while (struct dirent *entry = readdir(dir)) {
+        const char *suffix = entry->d_name + name.size();
+        if (std::strncmp(entry->d_name, name.c_str(), name.size()) != 0 || *suffix == '\0' ||
+            std::strspn(suffix, "0123456789") != std::strlen(suffix)) {
+            continue;
+        }
+        segments.push_back(std::strtoull(suffix, nullptr, 10));
+    }
+    closedir(dir);
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+// See OperationLog.h
+std::string OperationLog::SegmentPath(uint64_t generation) const { return _path + "." + std::to_string(generation); }
+
+} // namespace Backend
+} // namespace Afina
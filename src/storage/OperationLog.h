@@ -0,0 +1,168 @@
+#ifndef AFINA_STORAGE_OPERATION_LOG_H
+#define AFINA_STORAGE_OPERATION_LOG_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Write ahead log
+ * Append only log of changes made to the storage, so that items changed after the last snapshot
+ * survive a crash. Every record is the state association has got after the change: either a value
+ * with flags and expiration time or a deletion. Records are idempotent, replaying a record over the
+ * storage that already has it changes nothing, so log could be replayed over a snapshot written while
+ * the storage kept changing. Records of the same key must be logged in the order changes were made.
+ *
+ * Log is split into segments, files named <path>.<generation>. Snapshot remembers the generation that
+ * was current when it started, see Rotate, and once it is written all older segments are removed.
+ * Records go to disk in a dedicated thread: it takes everything logged while the previous write was in
+ * progress and makes it durable by a single fdatasync, that is group commit. Within durability window
+ * writer waits to gather a bigger group and callers don't wait for the disk at all, so changes of the
+ * last window could be lost in a crash. Window of 0 makes Commit wait until the record is durable.
+ *
+ * Segment starts with 8 bytes magic "AFNWAL" + 0 + format version and uint64 generation, followed by
+ * records: uint32 checksum of the rest of the record, uint32 key size, uint32 value size, uint32 flags,
+ * uint32 expire, uint8 type, 3 bytes of padding, key and value bytes. Replay of a segment stops at the
+ * first record cut short or damaged, those are writes crash has interrupted.
+ */
+class OperationLog {
+public:
+    /**
+     * @param path of the log, segments are named after it
+     * @param window milliseconds records could wait to be written in a bigger group, 0 means every record
+     * is durable once Commit returns
+     */
+    OperationLog(const std::string &path, uint32_t window);
+
+    ~OperationLog();
+
+    /**
+     * Puts changes from segments of the given generation and newer ones into the storage, removes older
+     * segments. Must be called before Start.
+     *
+     * Throws std::runtime_error if log directory can't be read
+     *
+     * @param storage to apply records to
+     * @param generation of the snapshot storage is loaded from, 0 if there is none
+     * @return number of records applied
+     */
+    std::size_t Replay(Storage &storage, uint64_t generation);
+
+    /**
+     * Starts a new segment after all the existing ones and the writer thread.
+     *
+     * Throws std::runtime_error if segment can't be created
+     *
+     * @param generation of the snapshot storage is loaded from, new segment is never older
+     */
+    void Start(uint64_t generation);
+
+    // Writes all records logged so far and stops the writer thread
+    void Stop();
+
+    /**
+     * Logs association of the key with the value, returns number of the record to commit or 0 if log
+     * has failed
+     */
+    uint64_t Put(const std::string &key, const char *value, std::size_t size, uint32_t flags, time_t expire);
+
+    // Logs deletion of the key, see Put
+    uint64_t Delete(const std::string &key);
+
+    /**
+     * Waits until the record is durable if there is no durability window, returns false if log has failed
+     * to write it
+     */
+    bool Commit(uint64_t record);
+
+    // True once log has failed to write, records are never logged after that
+    bool Failed();
+
+    /**
+     * Makes records logged from now on go to a new segment and waits until the current one is durable.
+     * Snapshot written afterwards reflects every change logged before and must be replayed with the new
+     * segment only. Returns generation of the new segment, 0 if log has failed
+     */
+    uint64_t Rotate();
+
+    // Removes segments older than the given generation, called once snapshot of that generation is durable
+    void Compact(uint64_t generation);
+
+    // Appends wal_* counters to the list, see Storage::Stats
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats);
+
+    // Size of the group writer makes durable right away without waiting for the window to pass
+    static const std::size_t max_group_bytes = 4 << 20;
+
+private:
+    OperationLog(const OperationLog &) = delete;
+    OperationLog &operator=(const OperationLog &) = delete;
+
+    // Writer thread body
+    void OnRun();
+
+    // Appends encoded record to the pending group, returns its number
+    uint64_t Append(char type, const std::string &key, const char *value, std::size_t size, uint32_t flags,
+                    time_t expire);
+
+    // Creates segment of the given generation and makes it current, returns false on failure
+    bool OpenSegment(uint64_t generation);
+
+    // Generations of all the segments there are, in ascending order
+    std::vector<uint64_t> ListSegments();
+
+    // Name of the segment of the given generation
+    std::string SegmentPath(uint64_t generation) const;
+
+    const std::string _path;
+    const std::chrono::milliseconds _window;
+
+    // Current segment, written by the writer thread only
+    int _fd;
+
+    // Newest generation found by Replay
+    uint64_t _last_generation;
+
+    std::thread _thread;
+    std::mutex _lock;
+    std::condition_variable _wakeup;
+    std::condition_variable _committed;
+    bool _running;
+    bool _failed;
+
+    // Records waiting for the writer and the time the first one of them was logged at
+    std::string _pending;
+    std::chrono::steady_clock::time_point _pending_since;
+
+    // Generation current segment is about to be switched to, 0 if there is no rotation in progress
+    uint64_t _rotate_to;
+    uint64_t _generation;
+
+    // Numbers of the last record logged and the last durable one
+    uint64_t _logged;
+    uint64_t _durable;
+
+    // Counters reported by Stats
+    uint64_t _bytes;
+    uint64_t _commits;
+    uint64_t _max_group;
+    uint64_t _replayed;
+    uint64_t _damaged;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_OPERATION_LOG_H
@@ -0,0 +1,321 @@
+#include "PersistentStorage.h"
+
+#include <chrono>
+#include <ctime>
+#include <stdexcept>
+
+#include "HashIndex.h"
+
+namespace Afina {
+namespace Backend {
+
+const std::size_t PersistentStorage::snapshot_batch;
+const std::size_t PersistentStorage::key_locks;
+
+// See PersistentStorage.h
+PersistentStorage::PersistentStorage(std::shared_ptr<Afina::Storage> storage, const std::string &path,
+                                     uint32_t interval, std::unique_ptr<OperationLog> log)
+    : _storage(std::move(storage)), _path(path), _interval(interval), _log(std::move(log)), _running(false),
+      _in_progress(false),
+      _snapshots(0), _failures(0), _last_time(0), _last_duration_ms(0), _loaded_items(0), _load_failures(0),
+      _load_duration_ms(0) {}
+
+// See PersistentStorage.h
+PersistentStorage::~PersistentStorage() { StopThread(); }
+
+// See PersistentStorage.h
+void PersistentStorage::Start() {
+    _storage->Start();
+
+    // Cache without snapshot is still a working cache, damaged file only makes it colder
+    auto start = std::chrono::steady_clock::now();
+    uint64_t generation = 0;
+    try {
+        _loaded_items = LoadSnapshot(*_storage, _path, &generation);
+    } catch (std::runtime_error &) {
+        _load_failures++;
+    }
+
+    // Log can't be written if it can't be read, so its failures stop the start
+    if (_log != nullptr) {
+        _log->Replay(*_storage, generation);
+        _log->Start(generation);
+    }
+    _load_duration_ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    if (_interval != 0) {
+        _running = true;
+        _thread = std::thread(&PersistentStorage::OnRun, this);
+    }
+}
+
+// See PersistentStorage.h
+void PersistentStorage::Stop() {
+    StopThread();
+    Snapshot();
+    if (_log != nullptr) {
+        _log->Stop();
+    }
+    _storage->Stop();
+}
+
+// See PersistentStorage.h
+bool PersistentStorage::Put(const std::string &key, const std::string &value, uint32_t flags, time_t expire) {
+    if (_log == nullptr) {
+        return _storage->Put(key, value, flags, expire);
+    }
+    uint64_t record;
+    {
+        std::lock_guard<std::mutex> lock(KeyLock(key));
+        if (_log->Failed() || !_storage->Put(key, value, flags, expire)) {
+            return false;
+        }
+        record = _log->Put(key, value.data(), value.size(), flags, expire);
+    }
+    return _log->Commit(record);
+}
+
+// See PersistentStorage.h
+bool PersistentStorage::PutExternal(const std::string &key, const char *value, std::size_t size, uint32_t flags,
+                                    time_t expire, const std::shared_ptr<const void> &owner) {
+    if (_log == nullptr) {
+        return _storage->PutExternal(key, value, size, flags, expire, owner);
+    }
+    return Put(key, std::string(value, size), flags, expire);
+}
+
+// See PersistentStorage.h
+bool PersistentStorage::PutIfAbsent(const std::string &key, const std::string &value, uint32_t flags,
+                                    time_t expire) {
+    if (_log == nullptr) {
+        return _storage->PutIfAbsent(key, value, flags, expire);
+    }
+    uint64_t record;
+    {
+        std::lock_guard<std::mutex> lock(KeyLock(key));
+        if (_log->Failed() || !_storage->PutIfAbsent(key, value, flags, expire)) {
+            return false;
+        }
+        record = _log->Put(key, value.data(), value.size(), flags, expire);
+    }
+    return _log->Commit(record);
+}
+
+// See PersistentStorage.h
+bool PersistentStorage::Set(const std::string &key, const std::string &value, uint32_t flags, time_t expire) {
+    if (_log == nullptr) {
+        return _storage->Set(key, value, flags, expire);
+    }
+    uint64_t record;
+    {
+        std::lock_guard<std::mutex> lock(KeyLock(key));
+        if (_log->Failed() || !_storage->Set(key, value, flags, expire)) {
+            return false;
+        }
+        record = _log->Put(key, value.data(), value.size(), flags, expire);
+    }
+    return _log->Commit(record);
+}
+
+// See PersistentStorage.h
+Storage::CasResult PersistentStorage::CompareAndSet(const std::string &key, const std::string &value, uint64_t cas,
+                                                    uint32_t flags, time_t expire) {
+    if (_log == nullptr) {
+        return _storage->CompareAndSet(key, value, cas, flags, expire);
+    }
+    uint64_t record;
+    {
+        std::lock_guard<std::mutex> lock(KeyLock(key));
+        if (_log->Failed()) {
+            return CasResult::NotStored;
+        }
+        CasResult result = _storage->CompareAndSet(key, value, cas, flags, expire);
+        if (result != CasResult::Stored) {
+            return result;
+        }
+        record = _log->Put(key, value.data(), value.size(), flags, expire);
+    }
+    return _log->Commit(record) ? CasResult::Stored : CasResult::NotStored;
+}
+
+// See PersistentStorage.h
+bool PersistentStorage::Append(const std::string &key, const std::string &value) {
+    if (_log == nullptr) {
+        return _storage->Append(key, value);
+    }
+    uint64_t record;
+    {
+        std::lock_guard<std::mutex> lock(KeyLock(key));
+        if (_log->Failed() || !_storage->Append(key, value)) {
+            return false;
+        }
+        record = LogCurrent(key);
+    }
+    return _log->Commit(record);
+}
+
+// See PersistentStorage.h
+bool PersistentStorage::Prepend(const std::string &key, const std::string &value) {
+    if (_log == nullptr) {
+        return _storage->Prepend(key, value);
+    }
+    uint64_t record;
+    {
+        std::lock_guard<std::mutex> lock(KeyLock(key));
+        if (_log->Failed() || !_storage->Prepend(key, value)) {
+            return false;
+        }
+        record = LogCurrent(key);
+    }
+    return _log->Commit(record);
+}
+
+// See PersistentStorage.h
+Storage::CounterResult PersistentStorage::Increment(const std::string &key, uint64_t delta, uint64_t &value) {
+    if (_log == nullptr) {
+        return _storage->Increment(key, delta, value);
+    }
+    uint64_t record;
+    {
+        std::lock_guard<std::mutex> lock(KeyLock(key));
+        if (_log->Failed()) {
+            return CounterResult::NotLogged;
+        }
+        CounterResult result = _storage->Increment(key, delta, value);
+        if (result != CounterResult::Updated) {
+            return result;
+        }
+        record = LogCurrent(key);
+    }
+    return _log->Commit(record) ? CounterResult::Updated : CounterResult::NotLogged;
+}
+
+// See PersistentStorage.h
+Storage::CounterResult PersistentStorage::Decrement(const std::string &key, uint64_t delta, uint64_t &value) {
+    if (_log == nullptr) {
+        return _storage->Decrement(key, delta, value);
+    }
+    uint64_t record;
+    {
+        std::lock_guard<std::mutex> lock(KeyLock(key));
+        if (_log->Failed()) {
+            return CounterResult::NotLogged;
+        }
+        CounterResult result = _storage->Decrement(key, delta, value);
+        if (result != CounterResult::Updated) {
+            return result;
+        }
+        record = LogCurrent(key);
+    }
+    return _log->Commit(record) ? CounterResult::Updated : CounterResult::NotLogged;
+}
+
+// See PersistentStorage.h
+bool PersistentStorage::Delete(const std::string &key) {
+    if (_log == nullptr) {
+        return _storage->Delete(key);
+    }
+    uint64_t record;
+    {
+        std::lock_guard<std::mutex> lock(KeyLock(key));
+        if (_log->Failed() || !_storage->Delete(key)) {
+            return false;
+        }
+        record = _log->Delete(key);
+    }
+    return _log->Commit(record);
+}
+
+// See PersistentStorage.h
+void PersistentStorage::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    _storage->Stats(stats);
+    stats.emplace_back("snapshot_in_progress", _in_progress ? "1" : "0");
+    stats.emplace_back("snapshot_items", std::to_string(_progress.items.load(std::memory_order_relaxed)));
+    stats.emplace_back("snapshot_bytes", std::to_string(_progress.bytes.load(std::memory_order_relaxed)));
+    stats.emplace_back("snapshot_max_pause_us",
+                       std::to_string(_progress.max_pause_us.load(std::memory_order_relaxed)));
+    stats.emplace_back("snapshot_count", std::to_string(_snapshots));
+    stats.emplace_back("snapshot_failures", std::to_string(_failures));
+    stats.emplace_back("snapshot_last_time", std::to_string(_last_time));
+    stats.emplace_back("snapshot_last_duration_ms", std::to_string(_last_duration_ms));
+    stats.emplace_back("snapshot_loaded_items", std::to_string(_loaded_items));
+    stats.emplace_back("snapshot_load_failures", std::to_string(_load_failures));
+    stats.emplace_back("snapshot_load_duration_ms", std::to_string(_load_duration_ms));
+    if (_log != nullptr) {
+        _log->Stats(stats);
+    }
+}
+
+// See PersistentStorage.h
+bool PersistentStorage::Snapshot() {
+    _in_progress = true;
+    auto start = std::chrono::steady_clock::now();
+    bool done = true;
+    try {
+        // Changes logged from now on are replayed over this snapshot, older ones are in it already
+        uint64_t generation = 0;
+        if (_log != nullptr && (generation = _log->Rotate()) == 0) {
+            throw std::runtime_error("Operation log has failed");
+        }
+        WriteSnapshot(*_storage, _path, snapshot_batch, _progress, generation);
+        if (_log != nullptr) {
+            _log->Compact(generation);
+        }
+        _snapshots++;
+        _last_time = std::time(nullptr);
+        _last_duration_ms =
+            std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    } catch (std::runtime_error &) {
+        _failures++;
+        done = false;
+    }
+    _in_progress = false;
+    return done;
+}
+
+// See PersistentStorage.h
+void PersistentStorage::StopThread() {
+    if (_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            _running = false;
+        }
+        _stop_requested.notify_all();
+        _thread.join();
+    }
+}
+
+// See PersistentStorage.h
+std::mutex &PersistentStorage::KeyLock(const std::string &key) {
+    return _key_locks[HashBytes(key.data(), key.size()) % key_locks];
+}
+
+// See PersistentStorage.h
+uint64_t PersistentStorage::LogCurrent(const std::string &key) {
+    std::string value;
+    uint32_t flags;
+    time_t expire;
+    if (_storage->Get(key, value, &flags, nullptr, &expire)) {
+        return _log->Put(key, value.data(), value.size(), flags, expire);
+    }
+    // Changed item has been evicted already
+    return _log->Delete(key);
+}
+
+// See PersistentStorage.h
+void PersistentStorage::OnRun() {
+    std::unique_lock<std::mutex> lock(_lock);
+    while (_running) {
+        if (_stop_requested.wait_for(lock, std::chrono::seconds(_interval), [this] { return !_running; })) {
+            break;
+        }
+
+        lock.unlock();
+        Snapshot();
+        lock.lock();
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,169 @@
+#ifndef AFINA_STORAGE_PERSISTENT_STORAGE_H
+#define AFINA_STORAGE_PERSISTENT_STORAGE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <afina/Storage.h>
+
+#include "OperationLog.h"
+#include "Snapshot.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Storage that survives restarts
+ * Wraps any storage: Start fills it from the snapshot file, Stop writes the snapshot back. In between
+ * snapshots could be written periodically by a background thread. Snapshot walks the storage with Scan
+ * while it keeps serving requests, storage is blocked only for one Scan batch at a time, and there is
+ * no fork. Items changed while snapshot is being written may get into it in either version.
+ *
+ * Optional operation log makes changes survive a crash as well: every change is logged once it is made
+ * and replayed on top of the snapshot on Start, snapshot removes the part of the log it covers. Changes
+ * of the same key are made and logged under one of the key_locks, so the log has them in the order they
+ * were made. Change is reported as failed if it couldn't be logged, see OperationLog::Commit.
+ *
+ * Periodic snapshots need thread safe storage.
+ */
+class PersistentStorage : public Afina::Storage {
+public:
+    /**
+     * @param storage to be wrapped
+     * @param path of the snapshot file
+     * @param interval seconds between background snapshots, 0 means snapshot is written on Stop only
+     * @param log of changes made since the snapshot, null if changes made after the last snapshot are lost
+     */
+    PersistentStorage(std::shared_ptr<Afina::Storage> storage, const std::string &path, uint32_t interval = 0,
+                      std::unique_ptr<OperationLog> log = nullptr);
+
+    ~PersistentStorage();
+
+    // Implements Afina::Storage interface, loads snapshot and starts background snapshots
+    void Start() override;
+
+    // Implements Afina::Storage interface, stops background snapshots and writes the final one
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, uint32_t flags = 0, time_t expire = 0) override;
+
+    // Implements Afina::Storage interface, value is copied if change is logged
+    bool PutExternal(const std::string &key, const char *value, std::size_t size, uint32_t flags, time_t expire,
+                     const std::shared_ptr<const void> &owner) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, uint32_t flags = 0, time_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, uint32_t flags = 0, time_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    CasResult CompareAndSet(const std::string &key, const std::string &value, uint64_t cas, uint32_t flags = 0,
+                            time_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    CounterResult Increment(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    CounterResult Decrement(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value, uint32_t *flags = nullptr, uint64_t *cas = nullptr,
+             time_t *expire = nullptr) override {
+        return _storage->Get(key, value, flags, cas, expire);
+    }
+
+    // Implements Afina::Storage interface
+    bool GetRef(const std::string &key, ValueRef &value, uint32_t *flags = nullptr, uint64_t *cas = nullptr) override {
+        return _storage->GetRef(key, value, flags, cas);
+    }
+
+    // Implements Afina::Storage interface
+    void MultiGet(const std::string *keys, std::size_t count, const GetVisitor &visitor) override {
+        _storage->MultiGet(keys, count, visitor);
+    }
+
+    // Implements Afina::Storage interface, adds snapshot_* and wal_* counters to the ones of the wrapped storage
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+    // Implements Afina::Storage interface
+    std::size_t Scan(std::size_t cursor, std::size_t count, const ScanVisitor &visitor) override {
+        return _storage->Scan(cursor, count, visitor);
+    }
+
+    // Implements Afina::Storage interface
+    bool SetMemoryLimit(std::size_t limit) override { return _storage->SetMemoryLimit(limit); }
+
+    /**
+     * Writes snapshot right away and removes operation log it covers, returns false if it has failed.
+     * Must not be called concurrently with another snapshot, that is while background snapshots are on
+     */
+    bool Snapshot();
+
+    // Number of positions snapshot asks Scan for at once
+    static const std::size_t snapshot_batch = 1024;
+
+    // Number of locks changes of the keys are spread over when they are logged
+    static const std::size_t key_locks = 64;
+
+private:
+    PersistentStorage(const PersistentStorage &) = delete;
+    PersistentStorage &operator=(const PersistentStorage &) = delete;
+
+    // Background thread body
+    void OnRun();
+
+    // Stops background snapshots if they are on
+    void StopThread();
+
+    // Lock changes of the key are made and logged under
+    std::mutex &KeyLock(const std::string &key);
+
+    // Logs the state key has after the change, returns number of the record, see OperationLog::Put
+    uint64_t LogCurrent(const std::string &key);
+
+    std::shared_ptr<Afina::Storage> _storage;
+    const std::string _path;
+    const uint32_t _interval;
+    std::unique_ptr<OperationLog> _log;
+    std::mutex _key_locks[key_locks];
+
+    // Background snapshots
+    std::thread _thread;
+    std::mutex _lock;
+    std::condition_variable _stop_requested;
+    bool _running;
+
+    // Counters reported by Stats
+    std::atomic<bool> _in_progress;
+    SnapshotProgress _progress;
+    std::atomic<uint64_t> _snapshots;
+    std::atomic<uint64_t> _failures;
+    std::atomic<uint64_t> _last_time;
+    std::atomic<uint64_t> _last_duration_ms;
+    std::atomic<uint64_t> _loaded_items;
+    std::atomic<uint64_t> _load_failures;
+    std::atomic<uint64_t> _load_duration_ms;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_PERSISTENT_STORAGE_H
@@ -0,0 +1,567 @@
+#include "RcuLRU.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "CounterText.h"
+#include "HashIndex.h"
+
+namespace Afina {
+namespace Backend {
+
+const std::size_t RcuLRU::reclaim_batch;
+
+// Number of buckets in the initial index
+static const std::size_t initial_buckets = 16;
+
+// See RcuLRU.h
+RcuLRU::RcuLRU(size_t max_size, SimpleLRU::Clock clock)
+    : _max_size(max_size), _clock(clock), _table(NewTable(initial_buckets)), _hand(0), _storage_size(0),
+      _last_cas(0), _reclaim_at(reclaim_batch), _evictions(0), _expired(0) {
+    for (auto &counters : _counters) {
+        counters.hits.store(0, std::memory_order_relaxed);
+        counters.misses.store(0, std::memory_order_relaxed);
+    }
+}
+
+// See RcuLRU.h
+void *RcuLRU::operator new(std::size_t size) {
+    void *p = nullptr;
+    if (posix_memalign(&p, alignof(RcuLRU), size) != 0) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+// See RcuLRU.h
+void RcuLRU::operator delete(void *p) noexcept { std::free(p); }
+
+// See RcuLRU.h
+RcuLRU::~RcuLRU() {
+    // No reader could be around anymore, everything is freed right away
+    Table *table = _table.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i <= table->mask; i++) {
+        ::operator delete(table->buckets()[i].load(std::memory_order_relaxed));
+    }
+    ::operator delete(table);
+
+    for (Node *node : _ring) {
+        ::operator delete(node);
+    }
+    for (auto &retired : _retired_nodes) {
+        ::operator delete(retired.object);
+    }
+    for (auto &retired : _retired_buckets) {
+        ::operator delete(retired.object);
+    }
+    for (auto &retired : _retired_tables) {
+        ::operator delete(retired.object);
+    }
+}
+
+// See RcuLRU.h
+bool RcuLRU::Put(const std::string &key, const std::string &value, uint32_t flags, time_t expire) {
+    return Store(key, value, flags, expire, true, true);
+}
+
+// See RcuLRU.h
+bool RcuLRU::PutIfAbsent(const std::string &key, const std::string &value, uint32_t flags, time_t expire) {
+    return Store(key, value, flags, expire, true, false);
+}
+
+// See RcuLRU.h
+bool RcuLRU::Set(const std::string &key, const std::string &value, uint32_t flags, time_t expire) {
+    return Store(key, value, flags, expire, false, true);
+}
+
+// See RcuLRU.h
+Storage::CasResult RcuLRU::CompareAndSet(const std::string &key, const std::string &value, uint64_t cas,
+                                         uint32_t flags, time_t expire) {
+    std::lock_guard<std::mutex> lock(_write_lock);
+    time_t now = _clock();
+    uint64_t hash = HashBytes(key.data(), key.size());
+    Node *old = FindNode(key, hash, now);
+    if (old == nullptr) return CasResult::NotFound;                     // There is not such a key.
+    if (old->cas != cas) return CasResult::Exists;                      // Value has been changed already.
+    if (!Fits(key.size(), value.size())) return CasResult::NotStored; // This pair does not fit in the cache.
+
+    Node *node = NewNode(key, hash, value.size(), flags, expire);
+    std::memcpy(node->value(), value.data(), value.size());
+    PutNode(node, old, now);
+    Reclaim();
+    return CasResult::Stored;
+}
+
+// See RcuLRU.h
+bool RcuLRU::Append(const std::string &key, const std::string &value) { return Concat(key, value, false); }
+
+// See RcuLRU.h
+bool RcuLRU::Prepend(const std::string &key, const std::string &value) { return Concat(key, value, true); }
+
+// See RcuLRU.h
+Storage::CounterResult RcuLRU::Increment(const std::string &key, uint64_t delta, uint64_t &value) {
+    return UpdateCounter(key, delta, false, value);
+}
+
+// See RcuLRU.h
+Storage::CounterResult RcuLRU::Decrement(const std::string &key, uint64_t delta, uint64_t &value) {
+    return UpdateCounter(key, delta, true, value);
+}
+
+// See RcuLRU.h
+bool RcuLRU::Delete(const std::string &key) {
+    std::lock_guard<std::mutex> lock(_write_lock);
+    Node *node = FindNode(key, HashBytes(key.data(), key.size()), _clock());
+    if (node == nullptr) return false; // There is not such a key.
+    RemoveNode(node);
+    Reclaim();
+    return true;
+}
+
+// See RcuLRU.h
+bool RcuLRU::Get(const std::string &key, std::string &value, uint32_t *flags, uint64_t *cas, time_t *expire) {
+    time_t now = _clock();
+    uint64_t hash = HashBytes(key.data(), key.size());
+
+    EpochManager::Guard guard(_epoch);
+    Node *node = Lookup(key.data(), key.size(), hash);
+    if (node == nullptr || IsExpired(node->expire, now)) {
+        Count(guard.Thread(), false);
+        return false;
+    }
+    Count(guard.Thread(), true);
+    value.assign(node->value(), node->value_size);
+    if (flags != nullptr) {
+        *flags = node->flags;
+    }
+    if (cas != nullptr) {
+        *cas = node->cas;
+    }
+    if (expire != nullptr) {
+        *expire = node->expire;
+    }
+    Touch(node);
+    return true;
+}
+
+// See RcuLRU.h
+bool RcuLRU::GetRef(const std::string &key, ValueRef &value, uint32_t *flags, uint64_t *cas) {
+    time_t now = _clock();
+    uint64_t hash = HashBytes(key.data(), key.size());
+
+    EpochManager::Guard guard(_epoch);
+    Node *node = Lookup(key.data(), key.size(), hash);
+    if (node == nullptr || IsExpired(node->expire, now)) {
+        Count(guard.Thread(), false);
+        return false;
+    }
+    Count(guard.Thread(), true);
+
+    // Node can't be freed while guard is held, once pinned it outlives the guard
+    node->refs.fetch_add(1, std::memory_order_relaxed);
+    value = ValueRef(node->value(), node->value_size, &node->refs);
+    if (flags != nullptr) {
+        *flags = node->flags;
+    }
+    if (cas != nullptr) {
+        *cas = node->cas;
+    }
+    Touch(node);
+    return true;
+}
+
+// See RcuLRU.h
+void RcuLRU::MultiGet(const std::string *keys, std::size_t count, const GetVisitor &visitor) {
+    time_t now = _clock();
+
+    EpochManager::Guard guard(_epoch);
+    for (std::size_t i = 0; i < count; i++) {
+        Node *node = Lookup(keys[i].data(), keys[i].size(), HashBytes(keys[i].data(), keys[i].size()));
+        if (node == nullptr || IsExpired(node->expire, now)) {
+            Count(guard.Thread(), false);
+            continue;
+        }
+        Count(guard.Thread(), true);
+        visitor(i, node->value(), node->value_size, node->flags, node->cas);
+        Touch(node);
+    }
+}
+
+// See RcuLRU.h
+void RcuLRU::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    uint64_t hits = 0, misses = 0;
+    for (auto &counters : _counters) {
+        hits += counters.hits.load(std::memory_order_relaxed);
+        misses += counters.misses.load(std::memory_order_relaxed);
+    }
+
+    std::lock_guard<std::mutex> lock(_write_lock);
+    stats.emplace_back("curr_items", std::to_string(_ring.size()));
+    stats.emplace_back("bytes", std::to_string(_storage_size));
+    stats.emplace_back("limit_maxbytes", std::to_string(_max_size));
+    stats.emplace_back("evictions", std::to_string(_evictions));
+    stats.emplace_back("expired", std::to_string(_expired));
+    stats.emplace_back("get_hits", std::to_string(hits));
+    stats.emplace_back("get_misses", std::to_string(misses));
+    stats.emplace_back("retired_items", std::to_string(_retired_nodes.size()));
+    stats.emplace_back("epoch", std::to_string(_epoch.Current()));
+}
+
+// See RcuLRU.h
+std::size_t RcuLRU::Scan(std::size_t cursor, std::size_t count, const ScanVisitor &visitor) {
+    time_t now = _clock();
+
+    // Bucket of the smaller table is split into the same bucket and the one size positions
+    // further, so buckets before the cursor are still done once table grows
+    EpochManager::Guard guard(_epoch);
+    Table *table = _table.load(std::memory_order_acquire);
+    std::size_t end = std::min(table->mask + 1, cursor + std::max<std::size_t>(count, 1));
+    for (; cursor < end; cursor++) {
+        Bucket *bucket = table->buckets()[cursor].load(std::memory_order_acquire);
+        if (bucket == nullptr) {
+            continue;
+        }
+        for (uint64_t i = 0; i < bucket->size; i++) {
+            Node *node = bucket->entries()[i].node;
+            if (!IsExpired(node->expire, now)) {
+                visitor(node->key(), node->key_size, node->value(), node->value_size, node->flags, node->expire);
+            }
+        }
+    }
+    return cursor <= table->mask ? cursor : 0;
+}
+
+// See RcuLRU.h
+RcuLRU::Node *RcuLRU::Lookup(const char *key, std::size_t key_size, uint64_t hash) const {
+    // Acquire pairs with release stores of writer: contents of the table, of the bucket
+    // and of the nodes it points to are visible as they were published
+    Table *table = _table.load(std::memory_order_acquire);
+    Bucket *bucket = table->buckets()[hash & table->mask].load(std::memory_order_acquire);
+    if (bucket == nullptr) {
+        return nullptr;
+    }
+
+    Entry *entries = bucket->entries();
+    for (uint64_t i = 0; i < bucket->size; i++) {
+        Node *node = entries[i].node;
+        if (entries[i].hash == hash && node->key_size == key_size && std::memcmp(node->key(), key, key_size) == 0) {
+            return node;
+        }
+    }
+    return nullptr;
+}
+
+// See RcuLRU.h
+void RcuLRU::Count(std::size_t thread, bool hit) {
+    Counters &counters = _counters[thread];
+    std::atomic<uint64_t> &counter = hit ? counters.hits : counters.misses;
+    if (thread != EpochManager::max_threads) {
+        // Only the owner thread writes its slot, plain increment is enough
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    } else {
+        counter.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// See RcuLRU.h
+RcuLRU::Node *RcuLRU::FindNode(const std::string &key, uint64_t hash, time_t now) {
+    Node *node = Lookup(key.data(), key.size(), hash);
+    if (node != nullptr && IsExpired(node->expire, now)) {
+        RemoveNode(node);
+        _expired++;
+        return nullptr;
+    }
+    return node;
+}
+
+// See RcuLRU.h
+RcuLRU::Node *RcuLRU::NewNode(const std::string &key, uint64_t hash, std::size_t value_size, uint32_t flags,
+                              time_t expire) {
+    void *memory = ::operator new(sizeof(Node) + key.size() + value_size);
+    Node *node = new (memory) Node();
+    node->hash = hash;
+    node->cas = ++_last_cas;
+    node->flags = flags;
+    node->expire = static_cast<uint32_t>(expire);
+    node->value_size = static_cast<uint32_t>(value_size);
+    node->key_size = static_cast<uint16_t>(key.size());
+    node->referenced.store(false, std::memory_order_relaxed);
+    node->refs.store(0, std::memory_order_relaxed);
+    std::memcpy(node->key(), key.data(), key.size());
+    return node;
+}
+
+// See RcuLRU.h
+void RcuLRU::PutNode(Node *node, Node *old, time_t now) {
+    std::size_t size = node->key_size + node->value_size;
+    std::size_t old_size = old != nullptr ? old->key_size + old->value_size : 0;
+    if (size > old_size) {
+        FreeSpace(size - old_size, now, old);
+    }
+
+    Table *table = _table.load(std::memory_order_relaxed);
+    std::atomic<Bucket *> &slot = table->buckets()[node->hash & table->mask];
+    Bucket *bucket = slot.load(std::memory_order_relaxed);
+    slot.store(CopyBucket(bucket, old, node), std::memory_order_release);
+    if (bucket != nullptr) {
+        _retired_buckets.push_back({bucket, _epoch.Current()});
+    }
+
+    _storage_size += size - old_size;
+    if (old != nullptr) {
+        // Update counts as an access, new version keeps position of the old one in the clock
+        node->ring = old->ring;
+        node->referenced.store(true, std::memory_order_relaxed);
+        _ring[node->ring] = node;
+        _retired_nodes.push_back({old, _epoch.Current()});
+    } else {
+        node->ring = static_cast<uint32_t>(_ring.size());
+        _ring.push_back(node);
+        if (_ring.size() > table->mask + 1) {
+            Grow();
+        }
+    }
+}
+
+// See RcuLRU.h
+bool RcuLRU::Store(const std::string &key, const std::string &value, uint32_t flags, time_t expire, bool insert,
+                   bool update) {
+    std::lock_guard<std::mutex> lock(_write_lock);
+    time_t now = _clock();
+    uint64_t hash = HashBytes(key.data(), key.size());
+    Node *old = FindNode(key, hash, now);
+    if (old != nullptr ? !update : !insert) return false; // Key is there or not, contrary to the request.
+    if (!Fits(key.size(), value.size())) return false;    // This pair does not fit in the cache.
+
+    Node *node = NewNode(key, hash, value.size(), flags, expire);
+    std::memcpy(node->value(), value.data(), value.size());
+    PutNode(node, old, now);
+    Reclaim();
+    return true;
+}
+
+// See RcuLRU.h
+bool RcuLRU::Concat(const std::string &key, const std::string &value, bool prepend) {
+    std::lock_guard<std::mutex> lock(_write_lock);
+    time_t now = _clock();
+    uint64_t hash = HashBytes(key.data(), key.size());
+    Node *old = FindNode(key, hash, now);
+    if (old == nullptr) return false; // There is not such a key.
+    std::size_t size = old->value_size;
+    if (!Fits(key.size(), size + value.size())) return false; // This pair does not fit in the cache.
+
+    // Readers may be looking at the old value, new one is always a copy
+    Node *node = NewNode(key, hash, size + value.size(), old->flags, old->expire);
+    if (prepend) {
+        std::memcpy(node->value(), value.data(), value.size());
+        std::memcpy(node->value() + value.size(), old->value(), size);
+    } else {
+        std::memcpy(node->value(), old->value(), size);
+        std::memcpy(node->value() + size, value.data(), value.size());
+    }
+    PutNode(node, old, now);
+    Reclaim();
+    return true;
+}
+
+// See RcuLRU.h
+Storage::CounterResult RcuLRU::UpdateCounter(const std::string &key, uint64_t delta, bool decrement,
+                                             uint64_t &value) {
+    std::lock_guard<std::mutex> lock(_write_lock);
+    time_t now = _clock();
+    uint64_t hash = HashBytes(key.data(), key.size());
+    Node *old = FindNode(key, hash, now);
+    if (old == nullptr) return CounterResult::NotFound; // There is not such a key.
+
+    uint64_t counter;
+    if (!ParseCounter(old->value(), old->value_size, counter)) return CounterResult::NotNumber;
+
+    if (decrement) {
+        counter = counter > delta ? counter - delta : 0;
+    } else {
+        counter += delta;
+    }
+
+    char text[counter_digits];
+    std::size_t size = FormatCounter(counter, text + sizeof(text));
+    if (!Fits(key.size(), size)) return CounterResult::NoMemory; // Counter does not fit in the cache anymore.
+
+    Node *node = NewNode(key, hash, size, old->flags, old->expire);
+    std::memcpy(node->value(), text + sizeof(text) - size, size);
+    PutNode(node, old, now);
+    Reclaim();
+    value = counter;
+    return CounterResult::Updated;
+}
+
+// See RcuLRU.h
+void RcuLRU::RemoveNode(Node *node) {
+    Table *table = _table.load(std::memory_order_relaxed);
+    std::atomic<Bucket *> &slot = table->buckets()[node->hash & table->mask];
+    Bucket *bucket = slot.load(std::memory_order_relaxed);
+    slot.store(CopyBucket(bucket, node, nullptr), std::memory_order_release);
+
+    uint64_t epoch = _epoch.Current();
+    _retired_buckets.push_back({bucket, epoch});
+    _retired_nodes.push_back({node, epoch});
+
+    // Last node takes place of the removed one, so the hand doesn't skip anything
+    Node *last = _ring.back();
+    last->ring = node->ring;
+    _ring[node->ring] = last;
+    _ring.pop_back();
+
+    _storage_size -= node->key_size + node->value_size;
+}
+
+// See RcuLRU.h
+void RcuLRU::FreeSpace(std::size_t size, time_t now, const Node *keep) {
+    while (_storage_size + size > _max_size && !_ring.empty()) {
+        if (_hand >= _ring.size()) {
+            _hand = 0;
+        }
+
+        Node *node = _ring[_hand];
+        if (node == keep) {
+            if (_ring.size() == 1) break; // Nothing else to evict.
+            _hand++;
+        } else if (IsExpired(node->expire, now)) {
+            RemoveNode(node);
+            _expired++;
+        } else if (node->referenced.load(std::memory_order_relaxed)) {
+            // Second chance
+            node->referenced.store(false, std::memory_order_relaxed);
+            _hand++;
+        } else {
+            RemoveNode(node);
+            _evictions++;
+        }
+    }
+}
+
+// See RcuLRU.h
+RcuLRU::Bucket *RcuLRU::CopyBucket(Bucket *bucket, const Node *drop, Node *add) {
+    std::size_t size = bucket != nullptr ? bucket->size : 0;
+    std::size_t count = size - (drop != nullptr ? 1 : 0) + (add != nullptr ? 1 : 0);
+    if (count == 0) {
+        return nullptr;
+    }
+
+    Bucket *copy = static_cast<Bucket *>(::operator new(sizeof(Bucket) + count * sizeof(Entry)));
+    Entry *entries = copy->entries();
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < size; i++) {
+        if (bucket->entries()[i].node != drop) {
+            entries[n++] = bucket->entries()[i];
+        }
+    }
+    if (add != nullptr) {
+        entries[n++] = Entry{add->hash, add};
+    }
+    copy->size = n;
+    return copy;
+}
+
+// See RcuLRU.h
+RcuLRU::Table *RcuLRU::NewTable(std::size_t size) {
+    void *memory = ::operator new(sizeof(Table) + size * sizeof(std::atomic<Bucket *>));
+    Table *table = static_cast<Table *>(memory);
+    table->mask = size - 1;
+    for (std::size_t i = 0; i < size; i++) {
+        new (&table->buckets()[i]) std::atomic<Bucket *>(nullptr);
+    }
+    return table;
+}
+
+// See RcuLRU.h
+void RcuLRU::Grow() {
+    Table *table = _table.load(std::memory_order_relaxed);
+    std::size_t size = table->mask + 1;
+    Table *grown = NewTable(size * 2);
+
+    // Each bucket splits into two by the next bit of the hash. Readers keep using the old table
+    // until the new one is published, both stay consistent
+    uint64_t epoch = _epoch.Current();
+    for (std::size_t i = 0; i < size; i++) {
+        Bucket *bucket = table->buckets()[i].load(std::memory_order_relaxed);
+        if (bucket == nullptr) {
+            continue;
+        }
+
+        Entry *entries = bucket->entries();
+        std::size_t high = 0;
+        for (uint64_t j = 0; j < bucket->size; j++) {
+            high += (entries[j].hash & size) != 0;
+        }
+
+        Bucket *parts[2] = {nullptr, nullptr};
+        std::size_t counts[2] = {bucket->size - high, high};
+        for (int part = 0; part < 2; part++) {
+            if (counts[part] != 0) {
+                parts[part] = static_cast<Bucket *>(::operator new(sizeof(Bucket) + counts[part] * sizeof(Entry)));
+                parts[part]->size = 0;
+            }
+        }
+        for (uint64_t j = 0; j < bucket->size; j++) {
+            Bucket *part = parts[(entries[j].hash & size) != 0];
+            part->entries()[part->size++] = entries[j];
+        }
+
+        grown->buckets()[i].store(parts[0], std::memory_order_relaxed);
+        grown->buckets()[i + size].store(parts[1], std::memory_order_relaxed);
+        _retired_buckets.push_back({bucket, epoch});
+    }
+
+    _table.store(grown, std::memory_order_release);
+    _retired_tables.push_back({table, epoch});
+}
+
+// See RcuLRU.h
+void RcuLRU::Reclaim() {
+    std::size_t retired = _retired_nodes.size() + _retired_buckets.size() + _retired_tables.size();
+    if (retired < _reclaim_at) {
+        return;
+    }
+
+    // Objects unlinked before the oldest epoch some reader is in can't be reached anymore
+    uint64_t safe = _epoch.Collect();
+
+    std::size_t kept = 0;
+    for (auto &node : _retired_nodes) {
+        // Pinned nodes wait for the last view, acquire pairs with release in ValueRef::Reset
+        if (node.epoch < safe && node.object->refs.load(std::memory_order_acquire) == 0) {
+            ::operator delete(node.object);
+        } else {
+            _retired_nodes[kept++] = node;
+        }
+    }
+    _retired_nodes.resize(kept);
+
+    kept = 0;
+    for (auto &bucket : _retired_buckets) {
+        if (bucket.epoch < safe) {
+            ::operator delete(bucket.object);
+        } else {
+            _retired_buckets[kept++] = bucket;
+        }
+    }
+    _retired_buckets.resize(kept);
+
+    kept = 0;
+    for (auto &table : _retired_tables) {
+        if (table.epoch < safe) {
+            ::operator delete(table.object);
+        } else {
+            _retired_tables[kept++] = table;
+        }
+    }
+    _retired_tables.resize(kept);
+
+    // Whatever is left waits for readers, next attempt makes sense once there is a new batch
+    _reclaim_at = _retired_nodes.size() + _retired_buckets.size() + _retired_tables.size() + reclaim_batch;
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,263 @@
+#ifndef AFINA_STORAGE_RCU_LRU_H
+#define AFINA_STORAGE_RCU_LRU_H
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <afina/Storage.h>
+
+#include "EpochManager.h"
+#include "SimpleLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Read mostly concurrent cache
+ * Lookups take no locks. Index is a table of immutable buckets, readers load it
+ * inside of EpochManager::Guard and follow pointers published by release stores.
+ * Writers are serialized by a single mutex and never change in place anything
+ * readers could see: new version of a bucket or an item is a copy swapped in by
+ * a single pointer store, the old one is freed once all readers that could have
+ * seen it are gone.
+ *
+ * Eviction follows CLOCK: hit only sets reference bit of the item, and only if
+ * it isn't set yet, so reads of hot items don't write shared memory at all. Hit
+ * and miss counters are kept per thread for the same reason.
+ *
+ * Expired items are invisible for readers, they are reaped once writer or clock
+ * hand comes across them.
+ *
+ * Keys are limited by 64KB.
+ */
+class RcuLRU : public Afina::Storage {
+public:
+    RcuLRU(size_t max_size = 1024, SimpleLRU::Clock clock = &SimpleLRU::SystemClock);
+
+    ~RcuLRU();
+
+    // Per thread slots take whole cache lines, plain new aligns to 16 bytes only before C++17
+    static void *operator new(std::size_t size);
+    static void operator delete(void *p) noexcept;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, uint32_t flags = 0, time_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, uint32_t flags = 0, time_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, uint32_t flags = 0, time_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    CasResult CompareAndSet(const std::string &key, const std::string &value, uint64_t cas, uint32_t flags = 0,
+                            time_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    CounterResult Increment(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    CounterResult Decrement(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface, takes no locks
+    bool Get(const std::string &key, std::string &value, uint32_t *flags = nullptr, uint64_t *cas = nullptr,
+             time_t *expire = nullptr) override;
+
+    // Implements Afina::Storage interface, takes no locks
+    bool GetRef(const std::string &key, ValueRef &value, uint32_t *flags = nullptr, uint64_t *cas = nullptr) override;
+
+    // Implements Afina::Storage interface, looks all the keys up inside of a single epoch
+    void MultiGet(const std::string *keys, std::size_t count, const GetVisitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+    // Implements Afina::Storage interface, takes no locks. Cursor is a bucket number, items could be
+    // visited twice if index grows in between of calls
+    std::size_t Scan(std::size_t cursor, std::size_t count, const ScanVisitor &visitor) override;
+
+private:
+    RcuLRU(const RcuLRU &) = delete;
+    RcuLRU &operator=(const RcuLRU &) = delete;
+
+    // Number of unlinked objects that makes writer try to free them
+    static const std::size_t reclaim_batch = 64;
+
+    // Item, a single memory block: header is followed by key bytes and then by value bytes.
+    // Nothing but atomics is changed once item is published
+    struct Node {
+        uint64_t hash;
+
+        // Version of the value
+        uint64_t cas;
+
+        // Opaque client flags stored along with the value
+        uint32_t flags;
+
+        // Unix time node expires at, 0 means never
+        uint32_t expire;
+
+        uint32_t value_size;
+        uint16_t key_size;
+
+        // CLOCK reference bit, set by readers
+        std::atomic<bool> referenced;
+
+        // Number of ValueRef views of the value, node isn't freed while it isn't 0
+        std::atomic<uint32_t> refs;
+
+        // Position in the clock ring, used by writers only
+        uint32_t ring;
+
+        char *key() { return reinterpret_cast<char *>(this + 1); }
+        char *value() { return key() + key_size; }
+    };
+
+    // Bucket of the index: number of entries followed by entries themselves
+    struct Entry {
+        uint64_t hash;
+        Node *node;
+    };
+
+    struct Bucket {
+        uint64_t size;
+
+        Entry *entries() { return reinterpret_cast<Entry *>(this + 1); }
+    };
+
+    // Index: mask followed by mask + 1 bucket pointers, null for empty buckets
+    struct Table {
+        std::size_t mask;
+
+        std::atomic<Bucket *> *buckets() { return reinterpret_cast<std::atomic<Bucket *> *>(this + 1); }
+    };
+
+    // Object unlinked by writer and the epoch it happened in
+    template <typename T> struct Retired {
+        T *object;
+        uint64_t epoch;
+    };
+
+    // Get results of a single thread, only the owner writes them
+    struct alignas(64) Counters {
+        std::atomic<uint64_t> hits;
+        std::atomic<uint64_t> misses;
+    };
+
+    // Maximum number of bytes could be stored in this cache, keys and values only
+    std::size_t _max_size;
+
+    SimpleLRU::Clock _clock;
+
+    EpochManager _epoch;
+
+    // Current index, replaced once it is full
+    std::atomic<Table *> _table;
+
+    // Everything below is guarded by _write_lock, except for the per thread counters
+    std::mutex _write_lock;
+
+    // Nodes in the cache, hand goes around them looking for the node to evict
+    std::vector<Node *> _ring;
+    std::size_t _hand;
+
+    // Number of bytes stored in this cache now
+    std::size_t _storage_size;
+
+    // Version given to the last stored value
+    uint64_t _last_cas;
+
+    // Objects waiting for readers to leave
+    std::vector<Retired<Node>> _retired_nodes;
+    std::vector<Retired<Bucket>> _retired_buckets;
+    std::vector<Retired<Table>> _retired_tables;
+
+    // Number of retired objects Reclaim waits for before it looks at readers again
+    std::size_t _reclaim_at;
+
+    // Counters reported by Stats: nodes evicted to free space, nodes reaped due to expiration
+    // and Get results, per thread. Threads without epoch slot share the last one
+    std::size_t _evictions;
+    std::size_t _expired;
+    Counters _counters[EpochManager::max_threads + 1];
+
+    // Auxiliary methods.
+
+    // Returns node with the given key or nullptr, expired ones included. Could be called
+    // by reader inside of a Guard and by writer under the lock
+    Node *Lookup(const char *key, std::size_t key_size, uint64_t hash) const;
+
+    // Counts Get result in the slot of the given thread
+    void Count(std::size_t thread, bool hit);
+
+    // Sets reference bit unless it is set already
+    static void Touch(Node *node) {
+        if (!node->referenced.load(std::memory_order_relaxed)) {
+            node->referenced.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    // Writer side: returns live node with the given key, reaps it if it has expired
+    Node *FindNode(const std::string &key, uint64_t hash, time_t now);
+
+    // Checks whether item of the given size could be stored at all
+    bool Fits(std::size_t key_size, std::size_t value_size) const {
+        return key_size <= UINT16_MAX && value_size <= UINT32_MAX && key_size + value_size <= _max_size;
+    }
+
+    // Allocates node for the given key and value size, caller fills value bytes
+    Node *NewNode(const std::string &key, uint64_t hash, std::size_t value_size, uint32_t flags, time_t expire);
+
+    // Stores new node or replaces old one with it, old one is freed once readers are gone.
+    // Makes space for it first, old node is never evicted for that
+    void PutNode(Node *node, Node *old, time_t now);
+
+    // Same as Put, but could refuse to insert new key or to update existing one
+    bool Store(const std::string &key, const std::string &value, uint32_t flags, time_t expire, bool insert,
+               bool update);
+
+    // Builds value of the node from the old value and the given bytes: appends them or prepends
+    bool Concat(const std::string &key, const std::string &value, bool prepend);
+
+    // Adds delta to the counter or subtracts it, see Storage::Increment
+    CounterResult UpdateCounter(const std::string &key, uint64_t delta, bool decrement, uint64_t &value);
+
+    // Unlinks node from index and clock ring
+    void RemoveNode(Node *node);
+
+    // Evicts nodes until there is space for the given number of bytes, never evicts keep
+    void FreeSpace(std::size_t size, time_t now, const Node *keep);
+
+    // Bucket with entries of the given one except for the node to drop, plus the entry to add
+    // if any. Returns nullptr for empty bucket
+    static Bucket *CopyBucket(Bucket *bucket, const Node *drop, Node *add);
+
+    static Table *NewTable(std::size_t size);
+
+    // Doubles index size
+    void Grow();
+
+    // Writer's epilogue: frees objects no reader could see anymore
+    void Reclaim();
+
+    static bool IsExpired(time_t expire, time_t now) { return expire != 0 && expire <= now; }
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_RCU_LRU_H
@@ -0,0 +1,221 @@
+#include "ShardedLRU.h"
+
+#include <stdexcept>
+
+#include "HashIndex.h"
+
+namespace Afina {
+namespace Backend {
+
+// See ShardedLRU.h
+ShardedLRU::ShardedLRU(size_t max_size, size_t shards, EvictionPolicy::Kind policy, bool admission,
+                       std::size_t compress_threshold, std::shared_ptr<Allocator::ConcurrentSlabAllocator> slabs)
+    : _slabs(slabs) {
+    if (shards == 0) {
+        throw std::invalid_argument("Number of shards must be positive");
+    }
+
+    _shards.reserve(shards);
+    for (size_t i = 0; i < shards; i++) {
+        _shards.emplace_back(new Shard(max_size / shards, policy, admission, compress_threshold, slabs));
+    }
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::Put(const std::string &key, const std::string &value, uint32_t flags, time_t expire) {
+    Shard &shard = ShardFor(key);
+    std::lock_guard<std::mutex> lock(shard.lock);
+    return shard.storage.Put(key, value, flags, expire);
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::PutExternal(const std::string &key, const char *value, std::size_t size, uint32_t flags,
+                             time_t expire, const std::shared_ptr<const void> &owner) {
+    Shard &shard = ShardFor(key);
+    std::lock_guard<std::mutex> lock(shard.lock);
+    return shard.storage.PutExternal(key, value, size, flags, expire, owner);
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::PutIfAbsent(const std::string &key, const std::string &value, uint32_t flags, time_t expire) {
+    Shard &shard = ShardFor(key);
+    std::lock_guard<std::mutex> lock(shard.lock);
+    return shard.storage.PutIfAbsent(key, value, flags, expire);
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::Set(const std::string &key, const std::string &value, uint32_t flags, time_t expire) {
+    Shard &shard = ShardFor(key);
+    std::lock_guard<std::mutex> lock(shard.lock);
+    return shard.storage.Set(key, value, flags, expire);
+}
+
+// See ShardedLRU.h
+Storage::CasResult ShardedLRU::CompareAndSet(const std::string &key, const std::string &value, uint64_t cas,
+                                             uint32_t flags, time_t expire) {
+    Shard &shard = ShardFor(key);
+    std::lock_guard<std::mutex> lock(shard.lock);
+    return shard.storage.CompareAndSet(key, value, cas, flags, expire);
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::Append(const std::string &key, const std::string &value) {
+    Shard &shard = ShardFor(key);
+    std::lock_guard<std::mutex> lock(shard.lock);
+    return shard.storage.Append(key, value);
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::Prepend(const std::string &key, const std::string &value) {
+    Shard &shard = ShardFor(key);
+    std::lock_guard<std::mutex> lock(shard.lock);
+    return shard.storage.Prepend(key, value);
+}
+
+// See ShardedLRU.h
+Storage::CounterResult ShardedLRU::Increment(const std::string &key, uint64_t delta, uint64_t &value) {
+    Shard &shard = ShardFor(key);
+    std::lock_guard<std::mutex> lock(shard.lock);
+    return shard.storage.Increment(key, delta, value);
+}
+
+// See ShardedLRU.h
+Storage::CounterResult ShardedLRU::Decrement(const std::string &key, uint64_t delta, uint64_t &value) {
+    Shard &shard = ShardFor(key);
+    std::lock_guard<std::mutex> lock(shard.lock);
+    return shard.storage.Decrement(key, delta, value);
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::Delete(const std::string &key) {
+    Shard &shard = ShardFor(key);
+    std::lock_guard<std::mutex> lock(shard.lock);
+    return shard.storage.Delete(key);
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::Get(const std::string &key, std::string &value, uint32_t *flags, uint64_t *cas,
+                     time_t *expire) {
+    Shard &shard = ShardFor(key);
+    std::lock_guard<std::mutex> lock(shard.lock);
+    return shard.storage.Get(key, value, flags, cas, expire);
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::GetRef(const std::string &key, ValueRef &value, uint32_t *flags, uint64_t *cas) {
+    Shard &shard = ShardFor(key);
+    std::lock_guard<std::mutex> lock(shard.lock);
+    return shard.storage.GetRef(key, value, flags, cas);
+}
+
+// See ShardedLRU.h
+void ShardedLRU::MultiGet(const std::string *keys, std::size_t count, const GetVisitor &visitor) {
+    // Counting sort of keys by shards: starts[s] is where keys of shard s begin in order
+    std::vector<uint64_t> hashes(count);
+    std::vector<std::size_t> shards(count);
+    std::vector<std::size_t> starts(_shards.size() + 1, 0);
+    for (std::size_t i = 0; i < count; i++) {
+        hashes[i] = HashBytes(keys[i].data(), keys[i].size());
+        shards[i] = (hashes[i] >> 32) % _shards.size();
+        starts[shards[i] + 1]++;
+    }
+    for (std::size_t s = 1; s < starts.size(); s++) {
+        starts[s] += starts[s - 1];
+    }
+
+    std::vector<std::size_t> order(count);
+    std::vector<std::size_t> next(starts.begin(), starts.end() - 1);
+    for (std::size_t i = 0; i < count; i++) {
+        order[next[shards[i]]++] = i;
+    }
+
+    for (std::size_t s = 0; s < _shards.size(); s++) {
+        if (starts[s] == starts[s + 1]) {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(_shards[s]->lock);
+        _shards[s]->storage.MultiGet(keys, hashes.data(), order.data() + starts[s], starts[s + 1] - starts[s], visitor);
+    }
+}
+
+// See ShardedLRU.h
+void ShardedLRU::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    std::vector<std::pair<std::string, std::string>> per_shard;
+    std::vector<std::pair<std::string, unsigned long long>> totals;
+
+    for (size_t i = 0; i < _shards.size(); i++) {
+        std::vector<std::pair<std::string, std::string>> shard_stats;
+        {
+            std::lock_guard<std::mutex> lock(_shards[i]->lock);
+            _shards[i]->storage.CacheStats(shard_stats);
+        }
+
+        // Every shard reports the same set of counters in the same order
+        if (totals.empty()) {
+            for (auto &s : shard_stats) {
+                totals.emplace_back(s.first, 0);
+            }
+        }
+
+        const std::string prefix = "shard_" + std::to_string(i) + ":";
+        for (size_t j = 0; j < shard_stats.size(); j++) {
+            totals[j].second += std::stoull(shard_stats[j].second);
+            per_shard.emplace_back(prefix + shard_stats[j].first, shard_stats[j].second);
+        }
+    }
+
+    stats.emplace_back("shards", std::to_string(_shards.size()));
+    for (auto &t : totals) {
+        stats.emplace_back(t.first, std::to_string(t.second));
+    }
+    if (_slabs != nullptr) {
+        _slabs->Stats(stats);
+    }
+    stats.insert(stats.end(), per_shard.begin(), per_shard.end());
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::Vacate(const char *slab, std::size_t size, bool restart, std::size_t &relocated,
+                        std::size_t &evicted) {
+    bool vacated = true;
+    for (auto &shard : _shards) {
+        std::lock_guard<std::mutex> lock(shard->lock);
+        vacated = shard->storage.Vacate(slab, size, restart, relocated, evicted) && vacated;
+    }
+    return vacated;
+}
+
+// See ShardedLRU.h
+std::size_t ShardedLRU::Scan(std::size_t cursor, std::size_t count, const ScanVisitor &visitor) {
+    // Cursor is position inside of the shard times number of shards plus the shard number
+    std::size_t shard = cursor % _shards.size();
+    std::size_t next;
+    {
+        std::lock_guard<std::mutex> lock(_shards[shard]->lock);
+        next = _shards[shard]->storage.Scan(cursor / _shards.size(), count, visitor);
+    }
+
+    if (next != 0) {
+        return next * _shards.size() + shard;
+    }
+    return shard + 1 < _shards.size() ? shard + 1 : 0;
+}
+
+// See ShardedLRU.h
+bool ShardedLRU::SetMemoryLimit(size_t limit) {
+    for (auto &shard : _shards) {
+        std::lock_guard<std::mutex> lock(shard->lock);
+        shard->storage.SetMemoryLimit(limit / _shards.size());
+    }
+    return true;
+}
+
+// See ShardedLRU.h
+ShardedLRU::Shard &ShardedLRU::ShardFor(const std::string &key) {
+    // Index inside of shard uses low bits of the same hash, see MultiGet as well
+    return *_shards[(HashBytes(key.data(), key.size()) >> 32) % _shards.size()];
+}
+
+} // namespace Backend
+} // namespace Afina
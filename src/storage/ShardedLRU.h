@@ -0,0 +1,112 @@
+#ifndef AFINA_STORAGE_SHARDED_LRU_H
+#define AFINA_STORAGE_SHARDED_LRU_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <afina/Storage.h>
+
+#include "SimpleLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Lock striped LRU
+ * Keys are hashed onto a fixed number of independent SimpleLRU shards, each
+ * one guarded by its own mutex and owning an equal part of the byte budget.
+ * Eviction happens inside of a shard only, so operations on keys from different
+ * shards never contend with each other.
+ */
+class ShardedLRU : public Afina::Storage, public Allocator::SlabMover::Client {
+public:
+    ShardedLRU(size_t max_size = 1024, size_t shards = 4, EvictionPolicy::Kind policy = EvictionPolicy::Kind::LRU,
+               bool admission = false, std::size_t compress_threshold = 0,
+               std::shared_ptr<Allocator::ConcurrentSlabAllocator> slabs = nullptr);
+    ~ShardedLRU() {}
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, uint32_t flags = 0, time_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    bool PutExternal(const std::string &key, const char *value, std::size_t size, uint32_t flags, time_t expire,
+                     const std::shared_ptr<const void> &owner) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, uint32_t flags = 0, time_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, uint32_t flags = 0, time_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    CasResult CompareAndSet(const std::string &key, const std::string &value, uint64_t cas, uint32_t flags = 0,
+                            time_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    CounterResult Increment(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    CounterResult Decrement(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value, uint32_t *flags = nullptr, uint64_t *cas = nullptr,
+             time_t *expire = nullptr) override;
+
+    // Implements Afina::Storage interface
+    bool GetRef(const std::string &key, ValueRef &value, uint32_t *flags = nullptr, uint64_t *cas = nullptr) override;
+
+    // Implements Afina::Storage interface, keys are grouped by shards so that every
+    // shard is locked once per call
+    void MultiGet(const std::string *keys, std::size_t count, const GetVisitor &visitor) override;
+
+    // Implements Afina::Storage interface, reports totals and stats of the slab allocator shards
+    // share followed by per shard counters prefixed by "shard_<N>:"
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+    // Implements Allocator::SlabMover::Client interface, locks shards one by one for a bounded part of the walk
+    bool Vacate(const char *slab, std::size_t size, bool restart, std::size_t &relocated,
+                std::size_t &evicted) override;
+
+    // Implements Afina::Storage interface, goes through shards one by one, each call locks a single shard
+    std::size_t Scan(std::size_t cursor, std::size_t count, const ScanVisitor &visitor) override;
+
+    // Implements Afina::Storage interface, splits memory limit equally between shards
+    bool SetMemoryLimit(size_t limit) override;
+
+private:
+    // Part of the storage guarded by its own lock
+    struct Shard {
+        Shard(size_t max_size, EvictionPolicy::Kind policy, bool admission, std::size_t compress_threshold,
+              std::shared_ptr<Allocator::ConcurrentSlabAllocator> slabs)
+            : storage(max_size, &SimpleLRU::SystemClock, policy, admission, compress_threshold, std::move(slabs)) {}
+
+        std::mutex lock;
+        SimpleLRU storage;
+    };
+
+    // Returns shard responsible for the given key
+    Shard &ShardFor(const std::string &key);
+
+    // Shards are allocated one by one to keep locks of neighbours apart
+    std::vector<std::unique_ptr<Shard>> _shards;
+
+    // Slab allocator all the shards take nodes from, null if they use malloc
+    std::shared_ptr<Allocator::ConcurrentSlabAllocator> _slabs;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SHARDED_LRU_H
@@ -1,143 +1,1044 @@
 #include "SimpleLRU.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#include "CounterText.h"
+#include "LzBlock.h"
+
 namespace Afina {
 namespace Backend {
 
-// See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Put(const std::string &key, const std::string &value) {
-	if ((key.size() + value.size()) > _max_size) return false; // This pair does not fit in the cache.
-	auto need_iterator = _lru_index.find(key);
-	if (need_iterator != _lru_index.end()) return UpdateNode(value, &(need_iterator->second.get())); // There is already such a key.
-	return PutNewNode(key, value);	// There is not such a key.
+const uint32_t SimpleLRU::nil;
+const uint32_t SimpleLRU::wheel_bits;
+const uint32_t SimpleLRU::wheel_slots;
+const uint32_t SimpleLRU::wheel_levels;
+const uint16_t SimpleLRU::no_slot;
+const std::size_t SimpleLRU::expire_batch;
+const std::size_t SimpleLRU::release_batch;
+const std::size_t SimpleLRU::vacate_batch;
+const std::size_t SimpleLRU::window_percent;
+const std::size_t SimpleLRU::shrink_slice;
+const std::size_t SimpleLRU::compress_gain;
+
+// See SimpleLRU.h
+SimpleLRU::SimpleLRU(size_t max_size, Clock clock, EvictionPolicy::Kind policy, bool admission,
+                     std::size_t compress_threshold, std::shared_ptr<Allocator::ConcurrentSlabAllocator> slabs)
+    : _max_size(max_size), _storage_size(0), _memory_limit(0), _memory_target(0), _node_bytes(0),
+      _external_bytes(0), _external_items(0), _compress_threshold(compress_threshold), _deflated_size(0),
+      _compressed_items(0), _compressed_bytes(0), _compressed_raw_bytes(0), _compress_rejected(0), _compress_ns(0),
+      _decompress_ns(0), _arena(std::move(slabs)), _detached_next(0), _vacate_next(0), _vacate_walked(false),
+      _vacate_allocated(0), _allocated(0), _policy(EvictionPolicy::Create(policy)),
+      _sketch(admission ? new FrequencySketch() : nullptr), _window_limit(max_size * window_percent / 100),
+      _window_bytes(0), _window_items(0), _window_memory(0), _clock(clock), _wheel_time(clock()), _wheel_ticks(0),
+      _wheel_size(0), _last_cas(0), _evictions(0), _expired(0), _get_hits(0), _get_misses(0), _admitted(0),
+      _rejected(0) {
+    std::fill(std::begin(_wheel), std::end(_wheel), nil);
+}
+
+// See SimpleLRU.h
+SimpleLRU::~SimpleLRU() {
+    for (lru_node *node : _nodes) {
+        if (node != nullptr) {
+            ReleaseNode(node);
+        }
+    }
+    for (lru_node *node : _detached) {
+        ReleaseNode(node);
+    }
+}
+
+// See SimpleLRU.h
+time_t SimpleLRU::SystemClock() { return std::time(nullptr); }
+
+// See SimpleLRU.h
+bool SimpleLRU::Put(const std::string &key, const std::string &value, uint32_t flags, time_t expire) {
+    if (!Fits(key.size(), value.size())) return false; // This pair does not fit in the cache.
+    time_t now = _clock();
+    Housekeeping(now);
+    uint64_t hash = HashBytes(key.data(), key.size());
+    uint32_t number = FindNode(key.data(), key.size(), hash, now);
+    if (number != nil) return UpdateNode(value, flags, expire, number, now); // There is already such a key.
+    return PutNewNode(key, value.data(), value.size(), flags, expire, hash, now); // There is not such a key.
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::PutExternal(const std::string &key, const char *value, std::size_t size, uint32_t flags,
+                            time_t expire, const std::shared_ptr<const void> &owner) {
+    if (!Fits(key.size(), size)) return false; // This pair does not fit in the cache.
+    time_t now = _clock();
+    Housekeeping(now);
+    uint64_t hash = HashBytes(key.data(), key.size());
+    uint32_t number = FindNode(key.data(), key.size(), hash, now);
+    if (number != nil) return UpdateNode(std::string(value, size), flags, expire, number, now);
+
+    // Owner is added after the node: making space could have released the last external node and all the owners
+    if (!PutNewNode(key, value, size, flags, expire, hash, now, true)) return false;
+    if (_external_items != 0 && std::find(_owners.begin(), _owners.end(), owner) == _owners.end()) {
+        _owners.push_back(owner);
+    }
+    return true;
 }
 
-// See MapBasedGlobalLockImpl.h
-bool SimpleLRU::PutIfAbsent(const std::string &key, const std::string &value) {
-	if (_lru_index.find(key) != _lru_index.end()) return false; // There is already such a key.
-	if ((key.size() + value.size()) > _max_size) return false; // This pair does not fit in the cache.
-	return PutNewNode(key, value);
+// See SimpleLRU.h
+bool SimpleLRU::PutIfAbsent(const std::string &key, const std::string &value, uint32_t flags, time_t expire) {
+    time_t now = _clock();
+    Housekeeping(now);
+    uint64_t hash = HashBytes(key.data(), key.size());
+    if (FindNode(key.data(), key.size(), hash, now) != nil) return false; // There is already such a key.
+    if (!Fits(key.size(), value.size())) return false; // This pair does not fit in the cache.
+    return PutNewNode(key, value.data(), value.size(), flags, expire, hash, now);
 }
 
-// See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Set(const std::string &key, const std::string &value) {
-	auto need_iterator = _lru_index.find(key);
-	if (need_iterator == _lru_index.end()) return false; // There is not such a key.
-	if ((key.size() + value.size()) > _max_size) return false; // This pair does not fit in the cache.
-	return UpdateNode(value, &(need_iterator->second.get()));
+// See SimpleLRU.h
+bool SimpleLRU::Set(const std::string &key, const std::string &value, uint32_t flags, time_t expire) {
+    time_t now = _clock();
+    Housekeeping(now);
+    uint32_t number = FindNode(key.data(), key.size(), HashBytes(key.data(), key.size()), now);
+    if (number == nil) return false;                           // There is not such a key.
+    if (!Fits(key.size(), value.size())) return false; // This pair does not fit in the cache.
+    return UpdateNode(value, flags, expire, number, now);
 }
 
-// See MapBasedGlobalLockImpl.h
+// See SimpleLRU.h
+Storage::CasResult SimpleLRU::CompareAndSet(const std::string &key, const std::string &value, uint64_t cas,
+                                            uint32_t flags, time_t expire) {
+    time_t now = _clock();
+    Housekeeping(now);
+    uint32_t number = FindNode(key.data(), key.size(), HashBytes(key.data(), key.size()), now);
+    if (number == nil) return CasResult::NotFound;                            // There is not such a key.
+    if (_nodes[number]->cas != cas) return CasResult::Exists;                 // Value has been changed already.
+    if (!Fits(key.size(), value.size())) return CasResult::NotStored; // This pair does not fit in the cache.
+    if (!UpdateNode(value, flags, expire, number, now)) return CasResult::NotStored;
+    return CasResult::Stored;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::Append(const std::string &key, const std::string &value) {
+    time_t now = _clock();
+    Housekeeping(now);
+    uint32_t number = FindNode(key.data(), key.size(), HashBytes(key.data(), key.size()), now);
+    if (number == nil) return false; // There is not such a key.
+    lru_node *node = _nodes[number];
+    std::size_t size = RawSize(node);
+    if (!Fits(key.size(), size + value.size())) return false; // This pair does not fit in the cache.
+
+    if (node->compressed) {
+        std::string joined(size + value.size(), '\0');
+        Inflate(node, &joined[0]);
+        std::memcpy(&joined[size], value.data(), value.size());
+        return UpdateNode(joined, node->flags, node->expire, number, now);
+    }
+
+    // Existing bytes stay where they are, block is reallocated only if there is no spare capacity
+    node = ResizeNode(number, size + value.size(), size, 0, now);
+    if (node == nullptr) return false; // There is no block for the longer value.
+    std::memcpy(node->value() + size, value.data(), value.size());
+    return true;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::Prepend(const std::string &key, const std::string &value) {
+    time_t now = _clock();
+    Housekeeping(now);
+    uint32_t number = FindNode(key.data(), key.size(), HashBytes(key.data(), key.size()), now);
+    if (number == nil) return false; // There is not such a key.
+    lru_node *node = _nodes[number];
+    std::size_t size = RawSize(node);
+    if (!Fits(key.size(), size + value.size())) return false; // This pair does not fit in the cache.
+
+    if (node->compressed) {
+        std::string joined(value.size() + size, '\0');
+        std::memcpy(&joined[0], value.data(), value.size());
+        Inflate(node, &joined[value.size()]);
+        return UpdateNode(joined, node->flags, node->expire, number, now);
+    }
+
+    node = ResizeNode(number, size + value.size(), size, value.size(), now);
+    if (node == nullptr) return false; // There is no block for the longer value.
+    std::memcpy(node->value(), value.data(), value.size());
+    return true;
+}
+
+// See SimpleLRU.h
+Storage::CounterResult SimpleLRU::Increment(const std::string &key, uint64_t delta, uint64_t &value) {
+    return UpdateCounter(key, delta, false, value);
+}
+
+// See SimpleLRU.h
+Storage::CounterResult SimpleLRU::Decrement(const std::string &key, uint64_t delta, uint64_t &value) {
+    return UpdateCounter(key, delta, true, value);
+}
+
+// See SimpleLRU.h
 bool SimpleLRU::Delete(const std::string &key) {
-	auto need_iterator = _lru_index.find(key);
-	if (need_iterator == _lru_index.end()) return false; // There is not such a key. 
-	// Delete the pair from the index storage.
-	_lru_index.erase(key);
-	_storage_size -= (key.size() + need_iterator->second.get().value.size());
-	// Delete the pair from the head storage.
-	lru_node *current_node = _lru_head.get();
-	// Search need node.
-	while(current_node != nullptr) {
-		if (current_node->key == key) break;
-		current_node = current_node->next.get();
-	}
-	if (current_node->next != nullptr) { // It is not the last node.
-		//Change prev node.
-		if (current_node->prev == nullptr) {
-			_lru_head = std::move(current_node->next); // It is first node.
-			current_node->next->prev = nullptr;
-		}
-		else {
-			current_node->next->prev = current_node->prev;
-			current_node->prev->next = std::move(current_node->next); //It is not first node.
-		}
-	}
-	else { // It is the last node.
-		if (_lru_last_node->prev == nullptr) { // There is one element in the storage.
-			_lru_head.reset();
-			_lru_last_node = nullptr;
-		}
-		else {
-			_lru_last_node = _lru_last_node->prev;
-			_lru_last_node->next.reset();
-		}
-	}
-	return true;
-}
-
-// See MapBasedGlobalLockImpl.h
+    time_t now = _clock();
+    Housekeeping(now);
+    uint32_t number = FindNode(key.data(), key.size(), HashBytes(key.data(), key.size()), now);
+    if (number == nil) return false; // There is not such a key.
+    DeleteNode(number);
+    return true;
+}
+
+// See SimpleLRU.h
 // Do not need "const", as it is necessary to renew the popularity of an item.
-bool SimpleLRU::Get(const std::string &key, std::string &value) { // const
-	auto need_iterator = _lru_index.find(key);
-	if (need_iterator == _lru_index.end()) return false; // There is not such a key.
-	value = need_iterator->second.get().value; // There is such an item.
-	return MoveNode(&(need_iterator->second.get()));	// Move this item on the top.
-}
-
-//Auxiliary methods
-// See MapBasedGlobalLockImpl.h
-bool SimpleLRU::DeleteLastNode() {
-	// Delete the pair from the index storage.
-	_lru_index.erase(_lru_last_node->key);
-	_storage_size -= ((_lru_last_node->key).size() + (_lru_last_node->value).size());
-	if (_lru_last_node->prev == nullptr) { // There is one element in the storage.
-		_lru_head.reset();
-		_lru_last_node = nullptr;
-	}
-	else {
-		_lru_last_node = _lru_last_node->prev;
-		_lru_last_node->next.reset();
-	}
-	return true;
-}
-
-// See MapBasedGlobalLockImpl.h
-bool SimpleLRU::PutNewNode(const std::string &key, const std::string &value) {
-	// Delete obsolete fields until there is free space.
-	while (_storage_size + key.size() + value.size() > _max_size)
-		DeleteLastNode();
-	_storage_size += key.size() + value.size();
-	// Input the new node in a head
-	lru_node *current_node;
-	if (_lru_head != nullptr) { // There are elements in the storage.
-		current_node = new lru_node{key, value, nullptr, std::move(_lru_head)};
-		_lru_head.reset(current_node);
-		_lru_head->next->prev = current_node;
-	}
-	else { // There are not elements in the storage.
-		current_node = new lru_node{key, value, nullptr, std::unique_ptr<lru_node>()};
-		_lru_head.reset(current_node);
-		_lru_last_node = current_node;
-	}
-	// Input the new node in the index storage.
-	_lru_index.insert({std::reference_wrapper<const std::string>(current_node->key), std::reference_wrapper<lru_node>(*current_node)});
-	return true;
-}
-
-// See MapBasedGlobalLockImpl.h
-bool SimpleLRU::MoveNode(lru_node *need_node) {
-	if (need_node->prev != nullptr) { // This node in head already
-		_lru_head->prev = need_node;
-		if (need_node->next != nullptr) { // This node in the tail
-			_lru_last_node = need_node->prev;
-			_lru_last_node->next = nullptr;
-		}
-		else need_node->next->prev = std::move(need_node->prev); // This node in the middle of the query
-		need_node->prev->next = std::move(need_node->next);
-		need_node->prev = nullptr;
-		need_node->next = std::move(_lru_head);
-	}
-	return true;
-}
-
-// See MapBasedGlobalLockImpl.h
-bool SimpleLRU::UpdateNode(const std::string &value, lru_node *need_node) {
-	MoveNode(need_node);
-	// Delete obsolete fields until there is free space.
-	while ((_storage_size + value.size() - (need_node->value).size()) > _max_size)
-		DeleteLastNode();
-	_storage_size += value.size() - (need_node->value).size();
-	need_node->value = value;
-	return true;
+bool SimpleLRU::Get(const std::string &key, std::string &value, uint32_t *flags, uint64_t *cas,
+                    time_t *expire) { // const
+    time_t now = _clock();
+    Housekeeping(now);
+    uint64_t hash = HashBytes(key.data(), key.size());
+    RecordAccess(hash);
+    uint32_t number = FindNode(key.data(), key.size(), hash, now);
+    if (number == nil) { // There is not such a key.
+        _get_misses++;
+        return false;
+    }
+    _get_hits++;
+    lru_node *node = _nodes[number];
+    if (node->compressed) {
+        // Decompressed right into the output
+        value.resize(RawSize(node));
+        Inflate(node, &value[0]);
+    } else {
+        value.assign(node->value(), node->value_size); // There is such an item.
+    }
+    if (flags != nullptr) {
+        *flags = node->flags;
+    }
+    if (cas != nullptr) {
+        *cas = node->cas;
+    }
+    if (expire != nullptr) {
+        *expire = node->expire;
+    }
+    TouchNode(number);                             // Renew the popularity of this item.
+    return true;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::GetRef(const std::string &key, ValueRef &value, uint32_t *flags, uint64_t *cas) {
+    time_t now = _clock();
+    Housekeeping(now);
+    uint64_t hash = HashBytes(key.data(), key.size());
+    RecordAccess(hash);
+    uint32_t number = FindNode(key.data(), key.size(), hash, now);
+    if (number == nil) { // There is not such a key.
+        _get_misses++;
+        return false;
+    }
+    lru_node *node = _nodes[number];
+    if (node->compressed) {
+        // View can't point into compressed bytes, it gets a decompressed copy that stays detached until the
+        // view is gone
+        if (!_arena.Available(sizeof(lru_node) + node->key_size + RawSize(node))) {
+            FreeSpace(0, 0, now, number, node->key_size + RawSize(node));
+        }
+        lru_node *copy = AllocateNode(node->key_size + RawSize(node));
+        if (copy == nullptr) return false; // Shared slabs are taken by other caches, value could only be copied.
+        copy->key_size = node->key_size;
+        copy->value_size = RawSize(node);
+        std::memcpy(copy->key(), node->key(), node->key_size);
+        Inflate(node, copy->value());
+        copy->refs.fetch_add(1, std::memory_order_relaxed);
+        _detached.push_back(copy);
+        value = ValueRef(copy->value(), copy->value_size, &copy->refs);
+    } else {
+        node->refs.fetch_add(1, std::memory_order_relaxed);
+        value = ValueRef(node->value(), node->value_size, &node->refs);
+    }
+    _get_hits++;
+    if (flags != nullptr) {
+        *flags = node->flags;
+    }
+    if (cas != nullptr) {
+        *cas = node->cas;
+    }
+    TouchNode(number);
+    return true;
+}
+
+// See SimpleLRU.h
+void SimpleLRU::MultiGet(const std::string *keys, std::size_t count, const GetVisitor &visitor) {
+    std::vector<uint64_t> hashes(count);
+    std::vector<std::size_t> indices(count);
+    for (std::size_t i = 0; i < count; i++) {
+        hashes[i] = HashBytes(keys[i].data(), keys[i].size());
+        indices[i] = i;
+    }
+    MultiGet(keys, hashes.data(), indices.data(), count, visitor);
+}
+
+// See SimpleLRU.h
+void SimpleLRU::MultiGet(const std::string *keys, const uint64_t *hashes, const std::size_t *indices,
+                         std::size_t count, const GetVisitor &visitor) {
+    time_t now = _clock();
+    Housekeeping(now);
+
+    // Index slots of the whole batch are requested first, so that cache misses overlap
+    for (std::size_t i = 0; i < count; i++) {
+        _lru_index.Prefetch(hashes[indices[i]]);
+    }
+
+    for (std::size_t i = 0; i < count; i++) {
+        const std::string &key = keys[indices[i]];
+        RecordAccess(hashes[indices[i]]);
+        uint32_t number = FindNode(key.data(), key.size(), hashes[indices[i]], now);
+        if (number == nil) {
+            _get_misses++;
+            continue;
+        }
+        _get_hits++;
+        lru_node *node = _nodes[number];
+        std::size_t size;
+        const char *value = ValueOf(node, size);
+        visitor(indices[i], value, size, node->flags, node->cas);
+        TouchNode(number);
+    }
+}
+
+// See SimpleLRU.h
+void SimpleLRU::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    CacheStats(stats);
+    _arena.Stats(stats);
+}
+
+// See SimpleLRU.h
+void SimpleLRU::CacheStats(std::vector<std::pair<std::string, std::string>> &stats) {
+    stats.emplace_back("curr_items", std::to_string(_lru_index.Size()));
+    stats.emplace_back("bytes", std::to_string(_storage_size));
+    stats.emplace_back("limit_maxbytes", std::to_string(_max_size));
+
+    // Memory breakdown: payload is reported as bytes, the rest is overhead of nodes and of index.
+    // Fragmentation is memory arena has taken from the system but isn't used by nodes now
+    std::size_t index_memory = IndexMemory();
+    stats.emplace_back("item_overhead_bytes", std::to_string(_node_bytes - _storage_size));
+    stats.emplace_back("index_bytes", std::to_string(index_memory));
+    stats.emplace_back("fragmentation_bytes", std::to_string(_arena.Reserved() - _node_bytes));
+    stats.emplace_back("memory_used", std::to_string(_node_bytes + index_memory));
+    stats.emplace_back("memory_limit", std::to_string(_memory_target));
+    stats.emplace_back("evictions", std::to_string(_evictions));
+    stats.emplace_back("expired", std::to_string(_expired));
+    stats.emplace_back("get_hits", std::to_string(_get_hits));
+    stats.emplace_back("get_misses", std::to_string(_get_misses));
+    stats.emplace_back("detached_items", std::to_string(_detached.size()));
+    stats.emplace_back("external_items", std::to_string(_external_items));
+    stats.emplace_back("external_bytes", std::to_string(_external_bytes));
+    stats.emplace_back("compressed_items", std::to_string(_compressed_items));
+    stats.emplace_back("compressed_bytes", std::to_string(_compressed_bytes));
+    stats.emplace_back("compressed_raw_bytes", std::to_string(_compressed_raw_bytes));
+    stats.emplace_back("compress_rejected", std::to_string(_compress_rejected));
+    stats.emplace_back("compress_us", std::to_string(_compress_ns / 1000));
+    stats.emplace_back("decompress_us", std::to_string(_decompress_ns / 1000));
+    stats.emplace_back("admitted", std::to_string(_admitted));
+    stats.emplace_back("rejected", std::to_string(_rejected));
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::Vacate(const char *slab, std::size_t size, bool restart, std::size_t &relocated,
+                       std::size_t &evicted) {
+    auto inside = [slab, size](const lru_node *node) {
+        return reinterpret_cast<const char *>(node) >= slab && reinterpret_cast<const char *>(node) < slab + size;
+    };
+
+    if (restart || (_vacate_walked && _allocated != _vacate_allocated)) {
+        _vacate_next = 0;
+        _vacate_walked = false;
+        _vacate_allocated = _allocated;
+    } else if (_vacate_walked) {
+        // Retry of a move held up by magazines, no node could have got into the slab since the walk
+        return true;
+    }
+
+    // Blocks of the slab itself that allocator still had in magazines, they are given back at the end
+    std::vector<lru_node *> stray;
+    uint64_t allocated = _allocated;
+    uint32_t end = std::min<std::size_t>(_nodes.size(), _vacate_next + vacate_batch);
+    for (uint32_t number = _vacate_next; number < end; number++) {
+        lru_node *node = _nodes[number];
+        if (node == nullptr || !inside(node)) {
+            continue;
+        }
+
+        // Other caches could take the last free blocks of the class at any moment, node is evicted then
+        lru_node *moved = nullptr;
+        while (!IsPinned(node)) {
+            moved = AllocateNode(node->capacity);
+            if (moved == nullptr || !inside(moved)) {
+                break;
+            }
+            stray.push_back(moved);
+            moved = nullptr;
+        }
+        if (moved == nullptr) {
+            evicted++;
+            DeleteNode(number);
+            continue;
+        }
+
+        // Block has the same size, so node moves as is along with compressed or external value
+        CopyHeader(node, moved);
+        std::memcpy(moved->key(), node->key(), node->capacity);
+        _nodes[number] = moved;
+        _node_bytes -= NodeMemory(node->capacity);
+        _arena.Release(node, sizeof(lru_node) + node->capacity);
+        relocated++;
+    }
+
+    for (lru_node *node : stray) {
+        ReleaseNode(node);
+    }
+    _allocated = allocated;
+
+    _vacate_next = end;
+    _vacate_walked = _vacate_next == _nodes.size();
+    return _vacate_walked;
+}
+
+// See SimpleLRU.h
+std::size_t SimpleLRU::Scan(std::size_t cursor, std::size_t count, const ScanVisitor &visitor) {
+    // Live nodes never change their numbers, so walking the table by numbers doesn't miss them
+    time_t now = _clock();
+    std::size_t end = std::min(_nodes.size(), cursor + std::max<std::size_t>(count, 1));
+    for (; cursor < end; cursor++) {
+        lru_node *node = _nodes[cursor];
+        if (node != nullptr && !IsExpired(node->expire, now)) {
+            std::size_t size;
+            const char *value = ValueOf(node, size);
+            visitor(node->key(), node->key_size, value, size, node->flags, node->expire);
+        }
+    }
+    return cursor < _nodes.size() ? cursor : 0;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::SetMemoryLimit(std::size_t limit) {
+    // Keys and values never take more than the whole memory, payload limit must not be the one that binds
+    if (limit > _max_size) {
+        _max_size = limit;
+        _window_limit = _max_size * window_percent / 100;
+    }
+
+    // Cache keeps what it has for now, Housekeeping brings the limit down step by step
+    std::size_t used = MemoryUsed();
+    _memory_target = limit;
+    _memory_limit = limit != 0 && limit < used ? used : limit;
+    return true;
+}
+
+// Auxiliary methods
+// See SimpleLRU.h
+uint32_t SimpleLRU::FindNode(const char *key, std::size_t key_size, uint64_t hash, time_t now) {
+    uint32_t *found = _lru_index.Find(hash, [this, key, key_size](uint32_t n) {
+        lru_node *node = _nodes[n];
+        return node->key_size == key_size && std::memcmp(node->key(), key, key_size) == 0;
+    });
+    if (found == nullptr) {
+        return nil;
+    }
+
+    // Node expired but timing wheel hasn't reached it yet
+    uint32_t number = *found;
+    if (IsExpired(_nodes[number]->expire, now)) {
+        _expired++;
+        DeleteNode(number);
+        return nil;
+    }
+    return number;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::PutNewNode(const std::string &key, const char *value, std::size_t value_size, uint32_t flags,
+                           time_t expire, uint64_t hash, time_t now, bool external) {
+    // Node would be invisible right away, no need to store it
+    if (IsExpired(expire, now)) return true;
+    RecordAccess(hash);
+
+    bool compressed = !external && Deflate(value, value_size);
+    if (compressed) {
+        value = _deflated.data();
+        value_size = _deflated_size;
+    }
+
+    // External value is charged as memory as well, so that limits hold the same once it is copied
+    std::size_t block = key.size() + (external ? sizeof(value) : value_size);
+    FreeSpace(key.size() + value_size, NodeMemory(block) + (external ? value_size : 0), now, nil, block);
+
+    // Shared slabs could still be out of blocks: other caches hold them or there was nothing left to evict
+    lru_node *node = AllocateNode(block);
+    if (node == nullptr) return false;
+    _storage_size += key.size() + value_size;
+    node->hash = static_cast<uint32_t>(hash);
+    node->key_size = key.size();
+    node->value_size = value_size;
+    node->flags = flags;
+    node->cas = ++_last_cas;
+    node->expire = expire;
+    std::memcpy(node->key(), key.data(), key.size());
+    if (external) {
+        std::memcpy(node->key() + key.size(), &value, sizeof(value));
+        node->external = true;
+        _external_bytes += value_size;
+        _external_items++;
+    } else {
+        std::memcpy(node->value(), value, value_size);
+    }
+    if (compressed) {
+        node->compressed = true;
+        CountCompressed(node, true);
+    }
+
+    uint32_t number;
+    if (!_free_numbers.empty()) {
+        number = _free_numbers.back();
+        _free_numbers.pop_back();
+        _nodes[number] = node;
+    } else {
+        number = _nodes.size();
+        _nodes.push_back(node);
+    }
+
+    // Input the new node in the eviction policy (or admission window), in the index storage and in the timing wheel.
+    node->window = _sketch != nullptr;
+    if (node->window) {
+        _window.Insert(number);
+        _window_bytes += key.size() + value_size;
+        _window_items++;
+        _window_memory += NodeFootprint(node);
+    } else {
+        _policy->Insert(number);
+    }
+    _lru_index.Insert(hash, number);
+    ScheduleNode(number);
+
+    if (_sketch != nullptr) {
+        // Sketch should be able to tell apart at least as many keys as there are in the cache
+        if (_lru_index.Size() > _sketch->Capacity()) {
+            _sketch->EnsureCapacity(_lru_index.Size() * 2);
+        }
+        DrainWindow();
+    }
+    return true;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::UpdateNode(const std::string &value, uint32_t flags, time_t expire, uint32_t number, time_t now) {
+    // New value would be invisible right away, so is the old one
+    if (IsExpired(expire, now)) {
+        DeleteNode(number);
+        return true;
+    }
+
+    const char *bytes = value.data();
+    std::size_t size = value.size();
+    bool compressed = Deflate(bytes, size);
+    if (compressed) {
+        bytes = _deflated.data();
+        size = _deflated_size;
+    }
+
+    lru_node *node = ResizeNode(number, size, 0, 0, now);
+    if (node == nullptr) return false;
+    node->flags = flags;
+    std::memcpy(node->value(), bytes, size);
+    if (compressed) {
+        node->compressed = true;
+        CountCompressed(node, true);
+    }
+
+    if (node->expire != expire) {
+        UnscheduleNode(number);
+        node->expire = expire;
+        ScheduleNode(number);
+    }
+    return true;
 }
+
+// See SimpleLRU.h
+Storage::CounterResult SimpleLRU::UpdateCounter(const std::string &key, uint64_t delta, bool decrement,
+                                                uint64_t &value) {
+    time_t now = _clock();
+    Housekeeping(now);
+    uint32_t number = FindNode(key.data(), key.size(), HashBytes(key.data(), key.size()), now);
+    if (number == nil) return CounterResult::NotFound; // There is not such a key.
+
+    // Counter is kept as text, so that get returns it as is
+    lru_node *node = _nodes[number];
+    uint64_t counter;
+    std::size_t current_size;
+    const char *current = ValueOf(node, current_size);
+    if (!ParseCounter(current, current_size, counter)) return CounterResult::NotNumber;
+
+    if (decrement) {
+        counter = counter > delta ? counter - delta : 0;
+    } else {
+        counter += delta;
+    }
+
+    // New text is at most 20 bytes, it almost always fits into the same block
+    char text[counter_digits];
+    std::size_t size = FormatCounter(counter, text + sizeof(text));
+    if (!Fits(key.size(), size)) return CounterResult::NoMemory; // Counter does not fit in the cache anymore.
+
+    node = ResizeNode(number, size, 0, 0, now);
+    if (node == nullptr) return CounterResult::NoMemory;
+    std::memcpy(node->value(), text + sizeof(text) - size, size);
+    value = counter;
+    return CounterResult::Updated;
+}
+
+// See SimpleLRU.h
+SimpleLRU::lru_node *SimpleLRU::ResizeNode(uint32_t number, std::size_t value_size, std::size_t keep,
+                                           std::size_t shift, time_t now) {
+    TouchNode(number);
+
+    // Delete obsolete fields until there is free space. Resized node isn't expired, it fits
+    // into the cache alone and it is kept by FreeSpace, so it is never evicted here.
+    lru_node *node = _nodes[number];
+    // Value doesn't fit into existing block, somebody reads it or it isn't in the block at all, node is moved
+    // into another one
+    bool move = node->key_size + value_size > node->capacity || IsPinned(node) || node->external;
+    if (value_size > node->value_size || (move && !_arena.Available(sizeof(lru_node) + node->key_size + value_size))) {
+        // Only growth beyond the current block takes more memory
+        std::size_t current = NodeMemory(node->capacity);
+        std::size_t memory = NodeMemory(node->key_size + value_size);
+        FreeSpace(value_size > node->value_size ? value_size - node->value_size : 0,
+                  memory > current ? memory - current : 0, now, number, move ? node->key_size + value_size : 0);
+    }
+
+    // Shared slabs could still be out of blocks, node stays as it is then
+    lru_node *moved = move ? AllocateNode(node->key_size + value_size) : nullptr;
+    if (move && moved == nullptr) {
+        return nullptr;
+    }
+
+    if (node->compressed) {
+        // Compressed value is only ever replaced as a whole, caller marks the new one if it is compressed
+        CountCompressed(node, false);
+        node->compressed = false;
+    }
+    _storage_size += value_size - node->value_size;
+    if (node->window) {
+        _window_bytes += value_size - node->value_size;
+    }
+
+    if (move) {
+        CopyHeader(node, moved);
+        moved->external = false;
+        std::memcpy(moved->key(), node->key(), node->key_size);
+        std::memcpy(moved->value() + shift, node->value(), keep);
+        if (node->window) {
+            _window_memory += NodeMemory(moved->capacity) - NodeFootprint(node);
+        }
+        DropNode(node);
+        _nodes[number] = node = moved;
+    } else if (shift != 0) {
+        std::memmove(node->value() + shift, node->value(), keep);
+    }
+
+    node->value_size = value_size;
+    node->cas = ++_last_cas;
+    return node;
+}
+
+// See SimpleLRU.h
+void SimpleLRU::FreeSpace(std::size_t size, std::size_t memory, time_t now, uint32_t keep, std::size_t block) {
+    while (_storage_size + size > _max_size || (_memory_limit != 0 && MemoryUsed() + memory > _memory_limit) ||
+           (block != 0 && !_arena.Available(sizeof(lru_node) + block))) {
+        if (ExpireNodes(now, 1) != 0) {
+            continue;
+        }
+
+        // Index and tables don't shrink, memory they took while the cache was bigger could not be reclaimed
+        if (_lru_index.Size() == (keep == nil ? 0 : 1)) {
+            break;
+        }
+
+        // With admission on space is taken from the window while it is above its share (counting incoming
+        // bytes) or is the only part that has nodes. Window tail then competes with the main victim
+        uint32_t candidate = _sketch != nullptr ? _window.Victim() : nil;
+        if (candidate != nil && candidate == keep) {
+            // Resized node stays, window moves on to another node if there is one
+            _window.Touch(keep);
+            candidate = _window.Victim() != keep ? _window.Victim() : nil;
+        }
+        // Resized node that is alone in the main part is never its victim, so only the window is left to evict
+        bool main_empty = _lru_index.Size() == _window_items;
+        bool main_kept = keep != nil && !_nodes[keep]->window && _lru_index.Size() - _window_items == 1;
+        if (candidate != nil && (main_empty || main_kept || _window_bytes + size > _window_limit)) {
+            uint32_t victim = main_empty || main_kept ? nil : _policy->Victim();
+            if (victim == keep) {
+                _policy->Touch(keep);
+                continue;
+            }
+
+            if (victim != nil &&
+                _sketch->Frequency(_nodes[candidate]->hash) > _sketch->Frequency(_nodes[victim]->hash)) {
+                _admitted++;
+                AdmitNode(candidate);
+                candidate = victim;
+            } else if (victim != nil) {
+                _rejected++;
+            }
+            _evictions++;
+            DeleteNode(candidate);
+            continue;
+        }
+
+        uint32_t victim = _policy->Victim();
+        if (victim == keep) {
+            // Let policy move on to some other node
+            _policy->Touch(keep);
+            continue;
+        }
+        _evictions++;
+        DeleteNode(victim);
+    }
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::Fits(std::size_t key_size, std::size_t value_size) const {
+    if (key_size > UINT16_MAX || key_size + value_size > _max_size) {
+        return false;
+    }
+    return _memory_limit == 0 || NodeMemory(key_size + value_size) + IndexMemory() <= _memory_limit;
+}
+
+// See SimpleLRU.h
+std::size_t SimpleLRU::IndexMemory() const {
+    std::size_t memory = sizeof(*this) + _lru_index.MemoryUsage() + _policy->MemoryUsage() + _window.MemoryUsage();
+    memory += _nodes.capacity() * sizeof(lru_node *) + _free_numbers.capacity() * sizeof(uint32_t) +
+              _detached.capacity() * sizeof(lru_node *);
+    if (_sketch != nullptr) {
+        memory += sizeof(FrequencySketch) + _sketch->MemoryUsage();
+    }
+    return memory;
+}
+
+// See SimpleLRU.h
+void SimpleLRU::TouchNode(uint32_t number) {
+    if (_nodes[number]->window) {
+        _window.Touch(number);
+    } else {
+        _policy->Touch(number);
+    }
+}
+
+// See SimpleLRU.h
+void SimpleLRU::DrainWindow() {
+    while (_window_bytes > _window_limit) {
+        uint32_t number = _window.Victim();
+        lru_node *node = _nodes[number];
+        // Main part leaves the window its share of both bytes and memory, node takes them from the window
+        std::size_t main_bytes = _storage_size - _window_bytes;
+        std::size_t main_memory = MemoryUsed() - _window_memory;
+        if (main_bytes + node->key_size + node->value_size > _max_size - _window_limit ||
+            (_memory_limit != 0 &&
+             main_memory + NodeFootprint(node) > _memory_limit - _memory_limit / 100 * window_percent)) {
+            // Main part is full, node will have to compete for a place once space is needed
+            break;
+        }
+        AdmitNode(number);
+    }
+}
+
+// See SimpleLRU.h
+void SimpleLRU::AdmitNode(uint32_t number) {
+    lru_node *node = _nodes[number];
+    _window.Erase(number);
+    _window_bytes -= node->key_size + node->value_size;
+    _window_items--;
+    _window_memory -= NodeFootprint(node);
+    node->window = false;
+    _policy->Insert(number);
+}
+
+// See SimpleLRU.h
+void SimpleLRU::DeleteNode(uint32_t number) {
+    lru_node *node = _nodes[number];
+    _lru_index.Erase(node->hash, [number](uint32_t n) { return n == number; });
+    _storage_size -= node->key_size + node->value_size;
+    if (node->window) {
+        _window.Erase(number);
+        _window_bytes -= node->key_size + node->value_size;
+        _window_items--;
+        _window_memory -= NodeFootprint(node);
+    } else {
+        _policy->Erase(number);
+    }
+    UnscheduleNode(number);
+
+    DropNode(node);
+    _nodes[number] = nullptr;
+    _free_numbers.push_back(number);
+}
+
+// See SimpleLRU.h
+void SimpleLRU::ScheduleNode(uint32_t number) {
+    lru_node *node = _nodes[number];
+    if (node->expire == 0) {
+        node->wheel_slot = no_slot;
+        return;
+    }
+
+    // Slot of level N is chosen by bits of expire time that are above the level N-1 range:
+    // once wheel time reaches the slot, nodes from it are moved one level down. Times in the
+    // past are handled by the current tick, times beyond the wheel range wait in the last level
+    const uint64_t range = uint64_t(1) << (wheel_bits * wheel_levels);
+    uint64_t when = std::max<uint64_t>(node->expire, _wheel_time);
+    if (when - _wheel_time >= range) {
+        when = _wheel_time + range - 1;
+    }
+
+    uint32_t level = 0;
+    while ((when - _wheel_time) >= (uint64_t(1) << (wheel_bits * (level + 1)))) {
+        level++;
+    }
+
+    uint16_t slot = level * wheel_slots + ((when >> (wheel_bits * level)) & (wheel_slots - 1));
+    node->wheel_slot = slot;
+    node->wheel_prev = nil;
+    node->wheel_next = _wheel[slot];
+    if (_wheel[slot] != nil) {
+        _nodes[_wheel[slot]]->wheel_prev = number;
+    }
+    _wheel[slot] = number;
+    _wheel_size++;
+    if (slot < wheel_slots) {
+        _wheel_ticks |= uint64_t(1) << slot;
+    }
+}
+
+// See SimpleLRU.h
+void SimpleLRU::UnscheduleNode(uint32_t number) {
+    lru_node *node = _nodes[number];
+    if (node->wheel_slot == no_slot) {
+        return;
+    }
+
+    if (node->wheel_next != nil) {
+        _nodes[node->wheel_next]->wheel_prev = node->wheel_prev;
+    }
+    if (node->wheel_prev != nil) {
+        _nodes[node->wheel_prev]->wheel_next = node->wheel_next;
+    } else {
+        _wheel[node->wheel_slot] = node->wheel_next;
+        if (node->wheel_next == nil && node->wheel_slot < wheel_slots) {
+            _wheel_ticks &= ~(uint64_t(1) << node->wheel_slot);
+        }
+    }
+    node->wheel_slot = no_slot;
+    _wheel_size--;
+}
+
+// See SimpleLRU.h
+std::size_t SimpleLRU::ExpireNodes(time_t now, std::size_t budget) {
+    std::size_t reaped = 0;
+    if (_wheel_size == 0 && _wheel_time <= now) {
+        // Nothing to reap, skip idle ticks at once
+        _wheel_time = now + 1;
+        return reaped;
+    }
+
+    while (_wheel_time <= now) {
+        uint32_t tick = _wheel_time & (wheel_slots - 1);
+        uint64_t pending = _wheel_ticks >> tick;
+        if ((pending & 1) == 0) {
+            // No nodes in the current tick, jump to the next busy one but not over the level 0 turn
+            time_t skip = pending != 0 ? __builtin_ctzll(pending) : wheel_slots - tick;
+            _wheel_time = std::min<time_t>(_wheel_time + skip, now + 1);
+        } else {
+            // Nodes of the current tick, all of them are expired
+            uint32_t &head = _wheel[tick];
+            while (head != nil) {
+                if (reaped == budget) {
+                    return reaped;
+                }
+
+                uint32_t number = head;
+                if (IsExpired(_nodes[number]->expire, now)) {
+                    _expired++;
+                    reaped++;
+                    DeleteNode(number);
+                } else {
+                    UnscheduleNode(number);
+                    ScheduleNode(number);
+                }
+            }
+            _wheel_time++;
+        }
+
+        // Lower level has made a full turn, move nodes of the next slot in upper level down
+        for (uint32_t level = 1; level < wheel_levels; level++) {
+            if (((_wheel_time >> (wheel_bits * (level - 1))) & (wheel_slots - 1)) != 0) {
+                break;
+            }
+
+            uint32_t slot = level * wheel_slots + ((_wheel_time >> (wheel_bits * level)) & (wheel_slots - 1));
+            uint32_t number = _wheel[slot];
+            _wheel[slot] = nil;
+            while (number != nil) {
+                uint32_t next = _nodes[number]->wheel_next;
+                _wheel_size--;
+                ScheduleNode(number);
+                number = next;
+            }
+        }
+    }
+    return reaped;
+}
+
+// See SimpleLRU.h
+SimpleLRU::lru_node *SimpleLRU::AllocateNode(std::size_t capacity) {
+    // Whatever arena rounded block up to is left for the value to grow in place
+    std::size_t size = _arena.BlockSize(sizeof(lru_node) + capacity);
+    lru_node *node = static_cast<lru_node *>(_arena.Allocate(size));
+    if (node == nullptr) {
+        return nullptr;
+    }
+    node->capacity = size - sizeof(lru_node);
+    node->external = false;
+    node->compressed = false;
+    _node_bytes += _arena.Footprint(size);
+    _allocated++;
+    new (&node->refs) std::atomic<uint32_t>(0);
+    return node;
+}
+
+// See SimpleLRU.h
+void SimpleLRU::ReleaseNode(lru_node *node) {
+    if (node->compressed) {
+        CountCompressed(node, false);
+    }
+    if (node->external) {
+        _external_bytes -= node->value_size;
+        if (--_external_items == 0) {
+            _owners.clear();
+        }
+    }
+    _node_bytes -= NodeMemory(node->capacity);
+    _arena.Release(node, sizeof(lru_node) + node->capacity);
+}
+
+// See SimpleLRU.h
+void SimpleLRU::CopyHeader(const lru_node *from, lru_node *to) {
+    to->hash = from->hash;
+    to->value_size = from->value_size;
+    to->key_size = from->key_size;
+    to->wheel_slot = from->wheel_slot;
+    to->expire = from->expire;
+    to->flags = from->flags;
+    to->cas = from->cas;
+    to->wheel_prev = from->wheel_prev;
+    to->wheel_next = from->wheel_next;
+    to->window = from->window;
+    to->external = from->external;
+    to->compressed = from->compressed;
+}
+
+// See SimpleLRU.h
+void SimpleLRU::DropNode(lru_node *node) {
+    if (IsPinned(node)) {
+        _detached.push_back(node);
+    } else {
+        ReleaseNode(node);
+    }
+}
+
+// See SimpleLRU.h
+void SimpleLRU::Housekeeping(time_t now) {
+    // Detached nodes are looked at round robin a few per operation, so that many views held
+    // don't slow every operation down
+    for (std::size_t i = 0; i < release_batch && !_detached.empty(); i++) {
+        if (_detached_next >= _detached.size()) {
+            _detached_next = 0;
+        }
+        if (IsPinned(_detached[_detached_next])) {
+            _detached_next++;
+            continue;
+        }
+        ReleaseNode(_detached[_detached_next]);
+        _detached[_detached_next] = _detached.back();
+        _detached.pop_back();
+    }
+    ExpireNodes(now, expire_batch);
+
+    if (_memory_limit != _memory_target) {
+        std::size_t used = MemoryUsed();
+        _memory_limit = used > _memory_target + shrink_slice ? used - shrink_slice : _memory_target;
+        FreeSpace(0, 0, now);
+    }
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::Deflate(const char *value, std::size_t size) {
+    // Value too small to save 1/compress_gain of it besides the size prefix never pays off
+    if (_compress_threshold == 0 || size < _compress_threshold || size <= sizeof(uint32_t) * compress_gain ||
+        size > UINT32_MAX) {
+        return false;
+    }
+
+    // Compressor gives up as soon as the block gets too big to pay off
+    auto start = std::chrono::steady_clock::now();
+    std::size_t limit = size - size / compress_gain - sizeof(uint32_t);
+    if (_deflated.size() < sizeof(uint32_t) + limit) {
+        _deflated.resize(sizeof(uint32_t) + limit);
+    }
+    uint32_t raw_size = size;
+    std::memcpy(_deflated.data(), &raw_size, sizeof(raw_size));
+    std::size_t compressed = LzBlock::Compress(value, size, _deflated.data() + sizeof(uint32_t), limit);
+    _compress_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)
+                        .count();
+
+    if (compressed == 0) {
+        _compress_rejected++;
+        return false;
+    }
+    _deflated_size = sizeof(uint32_t) + compressed;
+    return true;
+}
+
+// See SimpleLRU.h
+void SimpleLRU::Inflate(lru_node *node, char *buffer) {
+    auto start = std::chrono::steady_clock::now();
+    std::size_t size = RawSize(node);
+    long inflated =
+        LzBlock::Decompress(node->value() + sizeof(uint32_t), node->value_size - sizeof(uint32_t), buffer, size);
+    _decompress_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)
+                          .count();
+    if (inflated < 0 || std::size_t(inflated) != size) {
+        throw std::runtime_error("Compressed value is damaged");
+    }
+}
+
+// See SimpleLRU.h
+const char *SimpleLRU::ValueOf(lru_node *node, std::size_t &size) {
+    if (!node->compressed) {
+        size = node->value_size;
+        return node->value();
+    }
+    size = RawSize(node);
+    if (_inflated.size() < size) {
+        _inflated.resize(size);
+    }
+    Inflate(node, _inflated.data());
+    return _inflated.data();
+}
+
+// See SimpleLRU.h
+void SimpleLRU::CountCompressed(lru_node *node, bool add) {
+    if (add) {
+        _compressed_items++;
+        _compressed_bytes += node->value_size;
+        _compressed_raw_bytes += RawSize(node);
+    } else {
+        _compressed_items--;
+        _compressed_bytes -= node->value_size;
+        _compressed_raw_bytes -= RawSize(node);
+    }
+}
+
 } // namespace Backend
 } // namespace Afina
@@ -1,57 +1,245 @@
 #ifndef AFINA_STORAGE_SIMPLE_LRU_H
 #define AFINA_STORAGE_SIMPLE_LRU_H
 
-#include <map>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
 #include <memory>
-#include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <afina/Storage.h>
+#include <afina/allocator/SlabMover.h>
+
+#include "EvictionPolicy.h"
+#include "FrequencySketch.h"
+#include "HashIndex.h"
+#include "NodeArena.h"
 
 namespace Afina {
 namespace Backend {
 
 /**
- * # Map based implementation
+ * # Hash based LRU implementation
+ * Which node is evicted when there is no space is decided by EvictionPolicy,
+ * strict LRU by default.
+ *
+ * Items with expiration time are reaped lazily once found expired on access,
+ * and in background of regular operations by hierarchical timing wheel, so there
+ * is never a full scan over items. When cache is out of space expired items are
+ * reclaimed first and only then live ones get evicted.
+ *
+ * Optionally new items have to pass W-TinyLFU admission: they enter a small
+ * window LRU first, and once pushed out of it compete with the victim chosen by
+ * eviction policy for a place in the main part of the cache. Winner is the one
+ * accessed more often recently according to the frequency sketch, so a scan of
+ * one-off keys passes through the window without flushing the working set.
+ *
+ * Values could be pinned by GetRef: pinned value bytes are never changed in
+ * place, node gets copied on update instead, and memory of a pinned node that
+ * left the cache is reclaimed by a later operation once the last view is gone.
+ *
+ * Besides max_size, which limits keys and values only, cache could be given a
+ * memory limit. It bounds everything the cache takes: node headers, allocator
+ * rounding and malloc headers, index, node table and eviction policy state.
+ * Memory freed blocks keep in the arena free lists is reported as fragmentation
+ * but not limited, it is reused by the following allocations.
+ *
+ * Values of compress_threshold bytes and more could be stored compressed, so that
+ * the same memory holds more of them. Value is compressed once it is written as a
+ * whole and only if that saves at least 1/compress_gain of it, reads decompress it
+ * every time. Appending to a compressed value decompresses it and writes it anew.
+ *
+ * Nodes could take memory from a slab allocator shared with other caches, see NodeArena.
+ * Once it is out of slabs nodes are evicted until the node being stored fits, so cache
+ * holds as much as its share of slabs allows even below its limits. Slab mover takes nodes out
+ * of slabs it moves to other classes through Vacate.
+ *
+ * Keys are limited by 64KB.
+ *
  * That is NOT thread safe implementaiton!!
  */
-class SimpleLRU : public Afina::Storage {
+class SimpleLRU : public Afina::Storage, public Allocator::SlabMover::Client {
 public:
-    SimpleLRU(size_t max_size = 1024) : _max_size(max_size) {}
-
-    ~SimpleLRU() {
-        _lru_index.clear();
-	if (_lru_head)
-		while (_lru_last_node->prev != nullptr) {
-			_lru_last_node = _lru_last_node->prev;
-			_lru_last_node->next.reset();
-		}
-        _lru_head.reset();
-    }
+    // Source of current unix time
+    using Clock = time_t (*)();
+
+    SimpleLRU(size_t max_size = 1024, Clock clock = &SystemClock,
+              EvictionPolicy::Kind policy = EvictionPolicy::Kind::LRU, bool admission = false,
+              std::size_t compress_threshold = 0,
+              std::shared_ptr<Allocator::ConcurrentSlabAllocator> slabs = nullptr);
+
+    ~SimpleLRU();
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, uint32_t flags = 0, time_t expire = 0) override;
+
+    // Implements Afina::Storage interface, new node keeps pointer to the value, existing one gets a copy
+    bool PutExternal(const std::string &key, const char *value, std::size_t size, uint32_t flags, time_t expire,
+                     const std::shared_ptr<const void> &owner) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, uint32_t flags = 0, time_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, uint32_t flags = 0, time_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    CasResult CompareAndSet(const std::string &key, const std::string &value, uint64_t cas, uint32_t flags = 0,
+                            time_t expire = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &value) override;
 
     // Implements Afina::Storage interface
-    bool Put(const std::string &key, const std::string &value) override;
+    bool Prepend(const std::string &key, const std::string &value) override;
 
     // Implements Afina::Storage interface
-    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+    CounterResult Increment(const std::string &key, uint64_t delta, uint64_t &value) override;
 
     // Implements Afina::Storage interface
-    bool Set(const std::string &key, const std::string &value) override;
+    CounterResult Decrement(const std::string &key, uint64_t delta, uint64_t &value) override;
 
     // Implements Afina::Storage interface
     bool Delete(const std::string &key) override;
 
     // Implements Afina::Storage interface
-    bool Get(const std::string &key, std::string &value) override; //const
+    bool Get(const std::string &key, std::string &value, uint32_t *flags = nullptr, uint64_t *cas = nullptr,
+             time_t *expire = nullptr) override; //const
+
+    // Implements Afina::Storage interface, view of a compressed value points to a decompressed copy of it,
+    // there is no view if arena has no block for the copy
+    bool GetRef(const std::string &key, ValueRef &value, uint32_t *flags = nullptr, uint64_t *cas = nullptr) override;
+
+    // Implements Afina::Storage interface, looks keys up in a batch with prefetched index slots
+    void MultiGet(const std::string *keys, std::size_t count, const GetVisitor &visitor) override;
+
+    /**
+     * Same as MultiGet, but works on a subset of keys with precomputed hashes. Used by
+     * wrappers that spread keys across several instances
+     *
+     * @param keys full set of requested keys
+     * @param hashes HashBytes of every key from the full set
+     * @param indices positions of keys to be looked up here
+     * @param count number of indices
+     * @param visitor to be called for each key found, gets position from indices
+     */
+    void MultiGet(const std::string *keys, const uint64_t *hashes, const std::size_t *indices, std::size_t count,
+                  const GetVisitor &visitor);
+
+    // Implements Afina::Storage interface, CacheStats followed by stats of the slab allocator if there is one
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+    /**
+     * Counters of this cache only, without the slab allocator which could be shared with other
+     * caches. Used by wrappers that sum counters of several instances
+     */
+    void CacheStats(std::vector<std::pair<std::string, std::string>> &stats);
+
+    /**
+     * Implements Allocator::SlabMover::Client interface. Nodes are copied into other blocks of the
+     * same class while there are free ones outside of the slab, the rest and the pinned ones are
+     * deleted. Looks at vacate_batch nodes per call and goes on from there on the next one. Once
+     * all nodes are walked, retries do nothing unless nodes were allocated since the walk started
+     */
+    bool Vacate(const char *slab, std::size_t size, bool restart, std::size_t &relocated,
+                std::size_t &evicted) override;
+
+    // Implements Afina::Storage interface, cursor is a node number
+    std::size_t Scan(std::size_t cursor, std::size_t count, const ScanVisitor &visitor) override;
+
+    /**
+     * Implements Afina::Storage interface. Limits memory used by the cache, including all the
+     * per item and index overhead, 0 means there is no limit other than max_size. Limit bigger
+     * than max_size raises max_size as well. Cache shrinks by evicting at most shrink_slice bytes
+     * per operation
+     */
+    bool SetMemoryLimit(std::size_t limit) override;
+
+    // Default clock, returns time(nullptr)
+    static time_t SystemClock();
+
+    // Maximum number of nodes looked at by a single call of Vacate
+    static const std::size_t vacate_batch = 4096;
 
 private:
+    // Number used instead of missing node, for example in wheel_prev of the slot head
+    static const uint32_t nil = UINT32_MAX;
+
+    // Timing wheel geometry: levels of 64 slots each, slot of level N spans 64^N seconds, so
+    // wheel covers 64^4 seconds (~194 days) ahead. Items expiring later wait in the last level
+    static const uint32_t wheel_bits = 6;
+    static const uint32_t wheel_slots = 1 << wheel_bits;
+    static const uint32_t wheel_levels = 4;
+    static const uint16_t no_slot = UINT16_MAX;
+
+    // Maximum number of expired items reaped in background of a single operation
+    static const std::size_t expire_batch = 16;
+
+    // Maximum number of detached nodes checked for views in background of a single operation
+    static const std::size_t release_batch = 16;
+
+    // Share of max_size given to the admission window, in percents
+    static const std::size_t window_percent = 1;
+
+    // Maximum number of bytes evicted by a single operation while cache shrinks to the new memory limit
+    static const std::size_t shrink_slice = 64 * 1024;
+
+    // Value is kept compressed only if compression saves at least this part of it, 1/compress_gain
+    static const std::size_t compress_gain = 8;
+
+    // LRU cache node. Node is a single memory block: header is followed by key bytes
+    // and then by value bytes. Nodes are linked by numbers rather than pointers, see _nodes
+    struct lru_node {
+        // Low bits of the key hash, used to find node in the index without rehashing key
+        uint32_t hash;
+
+        uint32_t value_size;
+
+        // Number of bytes allocated after header, key_size + value_size <= capacity
+        uint32_t capacity;
+
+        uint16_t key_size;
+
+        // Timing wheel slot node is linked into, no_slot if node never expires
+        uint16_t wheel_slot;
 
-    // LRU cache node
-    using lru_node = struct lru_node {
-        const std::string key;
-        std::string value;
-        lru_node *prev;
-        std::unique_ptr<lru_node> next;
+        // Unix time node expires at, 0 means never
+        uint32_t expire;
+
+        // Opaque client flags stored along with the value
+        uint32_t flags;
+
+        // Version of the value, changes on every update
+        uint64_t cas;
+
+        // Number of ValueRef views of the value, node bytes are immutable while it isn't 0
+        std::atomic<uint32_t> refs;
+
+        // Neighbours in the timing wheel slot
+        uint32_t wheel_prev;
+        uint32_t wheel_next;
+
+        // Node is in the admission window rather than in the main part of the cache
+        bool window;
+
+        // Value bytes are external, see PutExternal: block holds pointer to them right after the key
+        bool external;
+
+        // Value bytes are compressed: uint32 size of the value followed by compressed block, value_size
+        // counts them all
+        bool compressed;
+
+        char *key() { return reinterpret_cast<char *>(this + 1); }
+        char *value() {
+            char *bytes = key() + key_size;
+            if (external) {
+                std::memcpy(&bytes, bytes, sizeof(bytes));
+            }
+            return bytes;
+        }
     };
 
     // Maximum number of bytes could be stored in this cache.
@@ -61,26 +249,220 @@ private:
     // Number of bytes stored in this cache now.
     std::size_t _storage_size;
 
-    // Main storage of lru_nodes, elements in this list ordered descending by "freshness": in the head
-    // element that wasn't used for longest time.
-    //
-    // List owns all nodes
-    std::unique_ptr<lru_node> _lru_head;
-	
-    // The most unpopular node.
-    lru_node *_lru_last_node;
+    // Limit of memory used by the cache, 0 if there is none, see SetMemoryLimit. While cache shrinks
+    // _memory_limit is the current step and _memory_target is the limit requested
+    std::size_t _memory_limit;
+    std::size_t _memory_target;
+
+    // Memory taken by all the node blocks, including detached ones, with allocator overhead
+    std::size_t _node_bytes;
+
+    // External values served now, including detached ones, and owners that keep them alive. Owners
+    // are dropped once the last external value is gone
+    std::size_t _external_bytes;
+    std::size_t _external_items;
+    std::vector<std::shared_ptr<const void>> _owners;
+
+    // Values of at least that many bytes are compressed, 0 if compression is off
+    std::size_t _compress_threshold;
+
+    // Scratch buffers for the value being compressed and the value being read
+    std::vector<char> _deflated;
+    std::size_t _deflated_size;
+    std::vector<char> _inflated;
 
-    // Index of nodes from list above, allows fast random access to elements by lru_node#key
-    std::map<std::reference_wrapper<const std::string>, std::reference_wrapper<lru_node>, std::less<std::string>> _lru_index;
+    // Compression counters: compressed nodes, bytes they take, bytes of values they hold, values that
+    // didn't compress well enough and time spent both ways
+    std::size_t _compressed_items;
+    std::size_t _compressed_bytes;
+    std::size_t _compressed_raw_bytes;
+    std::size_t _compress_rejected;
+    uint64_t _compress_ns;
+    uint64_t _decompress_ns;
+
+    // Memory all nodes are allocated from
+    NodeArena _arena;
+
+    // Nodes by numbers, node owns memory it points to. List links, index and head/tail all
+    // refer nodes by position in this table
+    std::vector<lru_node *> _nodes;
+
+    // Positions in _nodes that are free to be reused
+    std::vector<uint32_t> _free_numbers;
+
+    // Nodes that left the cache while pinned, they are released once all views are gone. Housekeeping
+    // checks them starting from _detached_next
+    std::vector<lru_node *> _detached;
+    std::size_t _detached_next;
+
+    // Walk of Vacate over node numbers: where it goes on from, whether it has reached the end and
+    // value of _allocated when it started. Node gets into the slab after the walk has passed it only
+    // in a block allocated since then
+    uint32_t _vacate_next;
+    bool _vacate_walked;
+    uint64_t _vacate_allocated;
+
+    // Node blocks allocated so far, not counting the ones Vacate allocates itself
+    uint64_t _allocated;
+
+    // Chooses nodes to evict, knows nodes by numbers
+    std::unique_ptr<EvictionPolicy> _policy;
+
+    // Admission: recent access frequencies and LRU of the nodes that haven't been admitted yet,
+    // sketch is null if admission is off. Window takes at most _window_limit bytes once the cache is full
+    std::unique_ptr<FrequencySketch> _sketch;
+    LruPolicy _window;
+    std::size_t _window_limit;
+    std::size_t _window_bytes;
+    std::size_t _window_items;
+
+    // Memory charged against the limit for window nodes, see NodeFootprint
+    std::size_t _window_memory;
+
+    // Index of nodes, allows fast random access to elements by lru_node#key
+    HashIndex<uint32_t> _lru_index;
+
+    Clock _clock;
+
+    // Heads of timing wheel slots, level by level
+    uint32_t _wheel[wheel_levels * wheel_slots];
+
+    // All wheel ticks before this time are processed
+    time_t _wheel_time;
+
+    // Bit per level 0 slot that has nodes, lets wheel jump over empty ticks
+    uint64_t _wheel_ticks;
+
+    // Number of nodes linked into the wheel, when there are none wheel doesn't need to tick
+    std::size_t _wheel_size;
+
+    // Version given to the last stored value
+    uint64_t _last_cas;
+
+    // Counters reported by Stats: nodes evicted to free space, nodes reaped due to expiration
+    // and Get results.
+    std::size_t _evictions;
+    std::size_t _expired;
+    std::size_t _get_hits;
+    std::size_t _get_misses;
+
+    // Admission results: window nodes moved into the main part, window nodes evicted
+    // as less popular than the main victim
+    std::size_t _admitted;
+    std::size_t _rejected;
 
     // Auxiliary methods.
-    bool PutNewNode(const std::string &key, const std::string &value);
-	
-    bool UpdateNode(const std::string &value, lru_node *need_node);
 
-    bool DeleteLastNode();
+    // Background work every operation starts with: reaps some expired nodes, releases
+    // detached nodes that aren't pinned anymore and shrinks cache a slice closer to the memory limit
+    void Housekeeping(time_t now);
+
+    // Returns number of the node with the given key, reaps it if node has expired
+    uint32_t FindNode(const char *key, std::size_t key_size, uint64_t hash, time_t now);
+
+    // Adds node for the key that isn't in the cache, external node keeps pointer to the value bytes
+    bool PutNewNode(const std::string &key, const char *value, std::size_t value_size, uint32_t flags, time_t expire,
+                    uint64_t hash, time_t now, bool external = false);
+
+    bool UpdateNode(const std::string &value, uint32_t flags, time_t expire, uint32_t number, time_t now);
+
+    // Adds delta to the counter stored as decimal text or subtracts it, see Storage::Increment
+    CounterResult UpdateCounter(const std::string &key, uint64_t delta, bool decrement, uint64_t &value);
+
+    // Makes node hold value of the given size and marks it accessed. First keep bytes
+    // of the current value are preserved and moved forward by shift bytes, the rest of the value is up to
+    // the caller. Node gets a new version. Returns node, which is reallocated if it had not enough capacity,
+    // or nullptr if there is no block to reallocate it into, node is left unchanged then
+    lru_node *ResizeNode(uint32_t number, std::size_t value_size, std::size_t keep, std::size_t shift, time_t now);
+
+    // Frees space for the given number of payload bytes, which take the given number of bytes of memory,
+    // and for the node of block payload bytes to be allocated, if any. Expired nodes go first and then ones
+    // chosen by eviction policy. Node with number keep, if any, is never evicted
+    void FreeSpace(std::size_t size, std::size_t memory, time_t now, uint32_t keep = nil, std::size_t block = 0);
+
+    // Checks whether item with the given key and value sizes could be stored at all
+    bool Fits(std::size_t key_size, std::size_t value_size) const;
+
+    // Memory of node with the given payload size
+    std::size_t NodeMemory(std::size_t size) const { return _arena.Footprint(sizeof(lru_node) + size); }
+
+    // Memory taken by the cache besides nodes: index, node table, policy and admission state
+    std::size_t IndexMemory() const;
+
+    // Memory charged against the limit
+    std::size_t MemoryUsed() const { return _node_bytes + _external_bytes + IndexMemory(); }
+
+    // Memory charged against the limit for the node: its block and external value bytes
+    std::size_t NodeFootprint(const lru_node *node) const {
+        return NodeMemory(node->capacity) + (node->external ? node->value_size : 0);
+    }
+
+    // Marks node accessed in the policy of the part it is in
+    void TouchNode(uint32_t number);
+
+    // Counts access to the key for admission decisions
+    void RecordAccess(uint64_t hash) {
+        if (_sketch != nullptr) {
+            _sketch->Increment(static_cast<uint32_t>(hash));
+        }
+    }
+
+    // Moves nodes from the window tail into the main part while window is above its share
+    // and the main part has room for them
+    void DrainWindow();
+
+    // Moves window node into the main part of the cache
+    void AdmitNode(uint32_t number);
+
+    // Removes node from index, policy and wheel, releases its memory
+    void DeleteNode(uint32_t number);
+
+    // Timing wheel primitives: put node into the slot according to its expire time, remove
+    // node from the wheel
+    void ScheduleNode(uint32_t number);
+    void UnscheduleNode(uint32_t number);
+
+    // Advances timing wheel up to the given time reaping at most budget expired nodes, returns
+    // number of nodes reaped
+    std::size_t ExpireNodes(time_t now, std::size_t budget);
+
+    // Allocate/release single memory block for node header and at least given number of payload bytes.
+    // Allocation returns nullptr if shared slabs are out of such blocks. Releasing the last external node
+    // drops owners of external values
+    lru_node *AllocateNode(std::size_t capacity);
+    void ReleaseNode(lru_node *node);
+
+    // Releases node that has left the cache, or keeps it in _detached while it is pinned
+    void DropNode(lru_node *node);
+
+    // Copies header fields of the node that moves into another block, but capacity and refs that
+    // belong to the block
+    static void CopyHeader(const lru_node *from, lru_node *to);
+
+    static bool IsPinned(const lru_node *node) { return node->refs.load(std::memory_order_acquire) != 0; }
+
+    // Compresses value into _deflated if compression is on for its size and pays off, returns true if so
+    bool Deflate(const char *value, std::size_t size);
+
+    // Decompresses value of the compressed node into the buffer of RawSize bytes
+    void Inflate(lru_node *node, char *buffer);
+
+    // Returns value bytes of the node, compressed value is decompressed into _inflated
+    const char *ValueOf(lru_node *node, std::size_t &size);
+
+    // Size of the value node holds, before compression
+    static std::size_t RawSize(lru_node *node) {
+        uint32_t size = node->value_size;
+        if (node->compressed) {
+            std::memcpy(&size, node->value(), sizeof(size));
+        }
+        return size;
+    }
+
+    // Takes compressed node into account in counters, or out of them once it is released or rewritten
+    void CountCompressed(lru_node *node, bool add);
 
-    bool MoveNode(lru_node *need_node);
+    static bool IsExpired(time_t expire, time_t now) { return expire != 0 && expire <= now; }
 };
 
 } // namespace Backend
@@ -0,0 +1,253 @@
+#include "Snapshot.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <libgen.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+const char snapshot_magic[8] = {'A', 'F', 'N', 'S', 'N', 'A', 'P', 3};
+
+// Buffered values are written out once there is that many bytes
+const std::size_t flush_size = 1 << 20;
+
+struct FileHeader {
+    char magic[8];
+    uint64_t started;
+    uint64_t items;
+    uint64_t index_offset;
+    uint64_t index_size;
+    uint64_t generation;
+};
+
+struct IndexEntry {
+    uint32_t key_size;
+    uint32_t value_size;
+    uint32_t flags;
+    uint32_t expire;
+    uint64_t value_offset;
+};
+
+// Index entries are aligned, so that they could be read right from the mapping
+std::size_t Padded(std::size_t size) { return (size + 7) & ~std::size_t(7); }
+
+std::runtime_error Failure(const std::string &what, const std::string &path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+// Closes descriptor once it goes out of scope
+struct File {
+    explicit File(int fd) : fd(fd) {}
+    ~File() {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    int fd;
+};
+
+void WriteAll(int fd, const char *data, std::size_t size, off_t offset, const std::string &path) {
+    while (size != 0) {
+        ssize_t written = pwrite(fd, data, size, offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw Failure("Failed to write", path);
+        }
+        data += written;
+        size -= written;
+        offset += written;
+    }
+}
+
+// Makes rename of the file durable
+void SyncDirectory(const std::string &path) {
+    std::string copy = path;
+    File dir(open(dirname(&copy[0]), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (dir.fd >= 0) {
+        fsync(dir.fd);
+    }
+}
+
+} // namespace
+
+// See Snapshot.h
+void WriteSnapshot(Storage &storage, const std::string &path, std::size_t batch, SnapshotProgress &progress,
+                   uint64_t generation) {
+    progress.items.store(0, std::memory_order_relaxed);
+    progress.bytes.store(0, std::memory_order_relaxed);
+    progress.max_pause_us.store(0, std::memory_order_relaxed);
+
+    const std::string temporary = path + ".tmp";
+    File file(open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+    if (file.fd < 0) {
+        throw Failure("Failed to create", temporary);
+    }
+
+    try {
+        FileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        header.started = std::time(nullptr);
+        header.generation = generation;
+
+        // Values are streamed right after the space left for the header, index entries point to them
+        std::string values, index;
+        values.reserve(flush_size * 2);
+        uint64_t offset = sizeof(header), written = sizeof(header);
+        std::size_t cursor = 0;
+        do {
+            auto start = std::chrono::steady_clock::now();
+            cursor = storage.Scan(cursor, batch,
+                                  [&](const char *key, std::size_t key_size, const char *value,
+                                      std::size_t value_size, uint32_t flags, time_t expire) {
+                                      IndexEntry entry{static_cast<uint32_t>(key_size),
+                                                       static_cast<uint32_t>(value_size), flags,
+                                                       static_cast<uint32_t>(expire), offset};
+                                      index.append(reinterpret_cast<const char *>(&entry), sizeof(entry));
+                                      index.append(key, key_size);
+                                      index.append(Padded(key_size) - key_size, '\0');
+                                      values.append(value, value_size);
+                                      offset += value_size;
+                                      header.items++;
+                                  });
+            uint64_t pause = std::chrono::duration_cast<std::chrono::microseconds>(
+                                 std::chrono::steady_clock::now() - start)
+                                 .count();
+            if (pause > progress.max_pause_us.load(std::memory_order_relaxed)) {
+                progress.max_pause_us.store(pause, std::memory_order_relaxed);
+            }
+
+            if (values.size() >= flush_size || cursor == 0) {
+                WriteAll(file.fd, values.data(), values.size(), written, temporary);
+                written += values.size();
+                values.clear();
+            }
+            progress.items.store(header.items, std::memory_order_relaxed);
+            progress.bytes.store(offset + index.size(), std::memory_order_relaxed);
+        } while (cursor != 0);
+
+        // Index starts aligned, so that entries in the mapping are aligned as well
+        header.index_offset = Padded(offset);
+        header.index_size = index.size();
+        index.insert(0, header.index_offset - offset, '\0');
+        WriteAll(file.fd, index.data(), index.size(), offset, temporary);
+
+        std::memcpy(header.magic, snapshot_magic, sizeof(header.magic));
+        WriteAll(file.fd, reinterpret_cast<const char *>(&header), sizeof(header), 0, temporary);
+
+        if (fsync(file.fd) != 0) {
+            throw Failure("Failed to sync", temporary);
+        }
+        if (close(file.fd) != 0) {
+            file.fd = -1;
+            throw Failure("Failed to close", temporary);
+        }
+        file.fd = -1;
+
+        if (rename(temporary.c_str(), path.c_str()) != 0) {
+            throw Failure("Failed to rename to", path);
+        }
+        SyncDirectory(path);
+    } catch (...) {
+        unlink(temporary.c_str());
+        throw;
+    }
+}
+
+// See Snapshot.h
+std::size_t LoadSnapshot(Storage &storage, const std::string &path, uint64_t *generation) {
+    if (generation != nullptr) {
+        *generation = 0;
+    }
+    File file(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+    if (file.fd < 0) {
+        if (errno == ENOENT) {
+            return 0;
+        }
+        throw Failure("Failed to open", path);
+    }
+
+    struct stat info;
+    if (fstat(file.fd, &info) != 0) {
+        throw Failure("Failed to stat", path);
+    }
+    std::size_t size = info.st_size;
+    if (size < sizeof(FileHeader)) {
+        throw std::runtime_error("Not a snapshot file " + path);
+    }
+
+    // Private read only mapping: pages are shared with page cache and aren't read until touched. Mapping
+    // stays valid after descriptor is closed and after the file is replaced by a new snapshot
+    void *address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file.fd, 0);
+    if (address == MAP_FAILED) {
+        throw Failure("Failed to map", path);
+    }
+    std::shared_ptr<const void> mapping(address, [size](const void *address) {
+        munmap(const_cast<void *>(address), size);
+    });
+    const char *base = static_cast<const char *>(address);
+
+    const FileHeader *header = reinterpret_cast<const FileHeader *>(base);
+    if (std::memcmp(header->magic, snapshot_magic, sizeof(header->magic)) != 0) {
+        throw std::runtime_error("Not a snapshot file " + path);
+    }
+    if (header->index_offset % 8 != 0 || header->index_offset < sizeof(FileHeader) || header->index_offset > size ||
+        header->index_size != size - header->index_offset) {
+        throw std::runtime_error("Snapshot file is damaged " + path);
+    }
+
+    // Index is read once from start to end, values are read on demand
+    std::size_t page = sysconf(_SC_PAGESIZE);
+    std::size_t index_page = header->index_offset / page * page;
+    madvise(address, index_page, MADV_RANDOM);
+    madvise(const_cast<char *>(base) + index_page, size - index_page, MADV_SEQUENTIAL);
+
+    time_t now = std::time(nullptr);
+    std::size_t stored = 0;
+    uint64_t items = 0;
+    std::string key;
+    for (std::size_t position = header->index_offset; position != size; items++) {
+        const IndexEntry *entry = reinterpret_cast<const IndexEntry *>(base + position);
+        if (size - position < sizeof(IndexEntry) || entry->key_size == 0 ||
+            size - position - sizeof(IndexEntry) < Padded(entry->key_size) ||
+            entry->value_offset < sizeof(FileHeader) || entry->value_offset > header->index_offset ||
+            header->index_offset - entry->value_offset < entry->value_size) {
+            throw std::runtime_error("Snapshot file is damaged " + path);
+        }
+        key.assign(base + position + sizeof(IndexEntry), entry->key_size);
+        position += sizeof(IndexEntry) + Padded(entry->key_size);
+
+        if (entry->expire != 0 && entry->expire <= now) {
+            continue;
+        }
+        if (storage.PutExternal(key, base + entry->value_offset, entry->value_size, entry->flags, entry->expire,
+                                mapping)) {
+            stored++;
+        }
+    }
+
+    if (items != header->items) {
+        throw std::runtime_error("Snapshot file is damaged " + path);
+    }
+    if (generation != nullptr) {
+        *generation = header->generation;
+    }
+    return stored;
+}
+
+} // namespace Backend
+} // namespace Afina
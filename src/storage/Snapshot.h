@@ -0,0 +1,80 @@
+#ifndef AFINA_STORAGE_SNAPSHOT_H
+#define AFINA_STORAGE_SNAPSHOT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Snapshot file
+ * Binary dump of live items laid out to be mapped into memory rather than parsed: values go first,
+ * followed by a compact index of keys, so that loading reads the index only and values are paged in
+ * once they are requested. Written in host byte order:
+ *
+ *   header:  8 bytes magic "AFNSNAP" + format version, uint64 unix time snapshot started at,
+ *            uint64 number of items, uint64 index offset, uint64 index size, uint64 generation of
+ *            the operation log to replay on top of the snapshot
+ *   values:  value bytes of all the items one after another
+ *   index:   per item uint32 key size (never 0), uint32 value size, uint32 flags, uint32 expire,
+ *            uint64 value offset, key bytes padded to 8 bytes
+ *
+ * Header is written last, so file cut short has no magic. Expiration time is absolute, so items keep
+ * their TTL across restarts and those expired meanwhile are skipped on load.
+ */
+
+// Progress of the snapshot being written, updated as it goes so that other threads could report it
+struct SnapshotProgress {
+    SnapshotProgress() : items(0), bytes(0), max_pause_us(0) {}
+
+    // Items and bytes written so far
+    std::atomic<uint64_t> items;
+    std::atomic<uint64_t> bytes;
+
+    // Longest single Scan call, that is the longest time storage could be blocked by the snapshot
+    std::atomic<uint64_t> max_pause_us;
+};
+
+/**
+ * Writes all live items of the storage into the file at the given path. Storage is walked through
+ * with Scan, at most batch positions per call: items are copied out while storage holds its locks and
+ * go to disk after locks are released. Values are streamed to the file, index is collected in memory
+ * and written at the end. File is written next to the path and replaces it only once it is complete
+ * and synced, so the previous snapshot survives any failure, as do the mappings of it.
+ *
+ * Throws std::runtime_error on I/O errors
+ *
+ * @param storage to dump
+ * @param path of the snapshot file
+ * @param batch number of positions Scan looks at per call, bounds every pause of the storage
+ * @param progress counters to update, reset first
+ * @param generation of the operation log segment changes made since the snapshot started go to, see OperationLog
+ */
+void WriteSnapshot(Storage &storage, const std::string &path, std::size_t batch, SnapshotProgress &progress,
+                   uint64_t generation = 0);
+
+/**
+ * Maps snapshot file and puts its items into the storage with PutExternal, skips expired ones. Storage
+ * that serves values from the mapping keeps it until the last of them is overwritten or evicted, so
+ * loading takes time proportional to the index rather than to the data. File must not be changed in
+ * place meanwhile, WriteSnapshot replaces it with a new one. Missing file is an empty snapshot.
+ *
+ * Throws std::runtime_error if file can't be read or is damaged, items read before the damage stay
+ * in the storage
+ *
+ * @param storage to fill
+ * @param path of the snapshot file
+ * @param generation optional output parameter to copy generation of the operation log to, 0 if there is no file
+ * @return number of items stored
+ */
+std::size_t LoadSnapshot(Storage &storage, const std::string &path, uint64_t *generation = nullptr);
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SNAPSHOT_H
@@ -17,25 +17,66 @@ namespace Backend {
  */
 class ThreadSafeSimplLRU : public SimpleLRU {
 public:
-    ThreadSafeSimplLRU(size_t max_size = 1024) : SimpleLRU(max_size) {}
+    ThreadSafeSimplLRU(size_t max_size = 1024, EvictionPolicy::Kind policy = EvictionPolicy::Kind::LRU,
+                       bool admission = false, std::size_t compress_threshold = 0,
+                       std::shared_ptr<Allocator::ConcurrentSlabAllocator> slabs = nullptr)
+        : SimpleLRU(max_size, &SystemClock, policy, admission, compress_threshold, std::move(slabs)) {}
     ~ThreadSafeSimplLRU() {}
 
     // see SimpleLRU.h
-    bool Put(const std::string &key, const std::string &value) override {
+    bool Put(const std::string &key, const std::string &value, uint32_t flags = 0, time_t expire = 0) override {
 	std::lock_guard<std::mutex> lock (_mutex);
-        return SimpleLRU::Put(key, value);
+        return SimpleLRU::Put(key, value, flags, expire);
     }
 
     // see SimpleLRU.h
-    bool PutIfAbsent(const std::string &key, const std::string &value) override {
+    bool PutExternal(const std::string &key, const char *value, std::size_t size, uint32_t flags, time_t expire,
+                     const std::shared_ptr<const void> &owner) override {
 	std::lock_guard<std::mutex> lock (_mutex);
-        return SimpleLRU::PutIfAbsent(key, value);
+        return SimpleLRU::PutExternal(key, value, size, flags, expire, owner);
     }
 
     // see SimpleLRU.h
-    bool Set(const std::string &key, const std::string &value) override {
+    bool PutIfAbsent(const std::string &key, const std::string &value, uint32_t flags = 0, time_t expire = 0) override {
 	std::lock_guard<std::mutex> lock (_mutex);
-        return SimpleLRU::Set(key, value);
+        return SimpleLRU::PutIfAbsent(key, value, flags, expire);
+    }
+
+    // see SimpleLRU.h
+    bool Set(const std::string &key, const std::string &value, uint32_t flags = 0, time_t expire = 0) override {
+	std::lock_guard<std::mutex> lock (_mutex);
+        return SimpleLRU::Set(key, value, flags, expire);
+    }
+
+    // see SimpleLRU.h
+    CasResult CompareAndSet(const std::string &key, const std::string &value, uint64_t cas, uint32_t flags = 0,
+                            time_t expire = 0) override {
+	std::lock_guard<std::mutex> lock (_mutex);
+        return SimpleLRU::CompareAndSet(key, value, cas, flags, expire);
+    }
+
+    // see SimpleLRU.h
+    bool Append(const std::string &key, const std::string &value) override {
+	std::lock_guard<std::mutex> lock (_mutex);
+        return SimpleLRU::Append(key, value);
+    }
+
+    // see SimpleLRU.h
+    bool Prepend(const std::string &key, const std::string &value) override {
+	std::lock_guard<std::mutex> lock (_mutex);
+        return SimpleLRU::Prepend(key, value);
+    }
+
+    // see SimpleLRU.h
+    CounterResult Increment(const std::string &key, uint64_t delta, uint64_t &value) override {
+	std::lock_guard<std::mutex> lock (_mutex);
+        return SimpleLRU::Increment(key, delta, value);
+    }
+
+    // see SimpleLRU.h
+    CounterResult Decrement(const std::string &key, uint64_t delta, uint64_t &value) override {
+	std::lock_guard<std::mutex> lock (_mutex);
+        return SimpleLRU::Decrement(key, delta, value);
     }
 
     // see SimpleLRU.h
@@ -45,9 +86,47 @@ public:
     }
 
     // see SimpleLRU.h
-    bool Get(const std::string &key, std::string &value) const override {
+    bool Get(const std::string &key, std::string &value, uint32_t *flags = nullptr, uint64_t *cas = nullptr,
+             time_t *expire = nullptr) override {
+	std::lock_guard<std::mutex> lock (_mutex);
+        return SimpleLRU::Get(key, value, flags, cas, expire);
+    }
+
+    // see SimpleLRU.h
+    bool GetRef(const std::string &key, ValueRef &value, uint32_t *flags = nullptr, uint64_t *cas = nullptr) override {
+	std::lock_guard<std::mutex> lock (_mutex);
+        return SimpleLRU::GetRef(key, value, flags, cas);
+    }
+
+    // see SimpleLRU.h
+    void MultiGet(const std::string *keys, std::size_t count, const GetVisitor &visitor) override {
+	std::lock_guard<std::mutex> lock (_mutex);
+        SimpleLRU::MultiGet(keys, count, visitor);
+    }
+
+    // see SimpleLRU.h
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override {
+	std::lock_guard<std::mutex> lock (_mutex);
+        SimpleLRU::Stats(stats);
+    }
+
+    // see SimpleLRU.h
+    std::size_t Scan(std::size_t cursor, std::size_t count, const ScanVisitor &visitor) override {
+	std::lock_guard<std::mutex> lock (_mutex);
+        return SimpleLRU::Scan(cursor, count, visitor);
+    }
+
+    // see SimpleLRU.h
+    bool Vacate(const char *slab, std::size_t size, bool restart, std::size_t &relocated,
+                std::size_t &evicted) override {
+	std::lock_guard<std::mutex> lock (_mutex);
+        return SimpleLRU::Vacate(slab, size, restart, relocated, evicted);
+    }
+
+    // see SimpleLRU.h
+    bool SetMemoryLimit(std::size_t limit) override {
 	std::lock_guard<std::mutex> lock (_mutex);
-        return SimpleLRU::Get(key, value);
+        return SimpleLRU::SetMemoryLimit(limit);
     }
 
 private:
@@ -1,4 +1,5 @@
 #include "gtest/gtest.h"
+#include <algorithm>
 #include <iostream>
 #include <set>
 #include <vector>
@@ -322,3 +323,93 @@ TEST(SimpleTest, ReallocGrow) {
     a.free(p);
     a.free(p2);
 }
+
+TEST(SimpleTest, ReallocGrowIntoFreeNeighbour) {
+    Simple a(buf, sizeof(buf));
+
+    int size = 135;
+    Pointer p = a.alloc(size);
+    Pointer p2 = a.alloc(size);
+    Pointer p3 = a.alloc(size);
+    writeTo(p, size);
+    writeTo(p3, size);
+    a.free(p2);
+
+    void *ptr = p.get();
+    a.realloc(p, size * 2);
+
+    EXPECT_EQ(p.get(), ptr);
+    EXPECT_TRUE(isDataOk(p, size));
+    writeTo(p, size * 2);
+    EXPECT_TRUE(isDataOk(p, size * 2));
+    EXPECT_TRUE(isDataOk(p3, size));
+
+    a.free(p);
+    a.free(p3);
+}
+
+TEST(SimpleTest, InvalidFree) {
+    Simple a(buf, sizeof(buf));
+
+    Pointer p = a.alloc(100);
+    Pointer copy = p;
+    a.free(p);
+    EXPECT_EQ(p.get(), nullptr);
+
+    try {
+        a.free(copy);
+        EXPECT_TRUE(false);
+    } catch (AllocError &e) {
+        EXPECT_EQ(e.getType(), AllocErrorType::InvalidFree);
+    }
+
+    // Empty pointer is ignored
+    a.free(p);
+}
+
+TEST(SimpleTest, RandomWorkload) {
+    Simple a(buf, sizeof(buf));
+
+    // Every block is filled with its own byte, so blocks overwriting each other are caught
+    vector<Pointer> ptrs(64);
+    vector<size_t> sizes(64);
+    unsigned seed = 42;
+    for (int i = 0; i < 100000; i++) {
+        seed = seed * 1103515245 + 12345;
+        size_t index = (seed >> 8) % ptrs.size();
+        size_t size = 1 + (seed >> 16) % 2000;
+
+        try {
+            if (ptrs[index].get() == nullptr) {
+                ptrs[index] = a.alloc(size);
+            } else if (seed % 3 == 0) {
+                a.free(ptrs[index]);
+                continue;
+            } else {
+                a.realloc(ptrs[index], size);
+                sizes[index] = std::min(sizes[index], size);
+                ASSERT_TRUE(std::all_of(static_cast<char *>(ptrs[index].get()),
+                                        static_cast<char *>(ptrs[index].get()) + sizes[index],
+                                        [index](char c) { return c == char(index); }));
+            }
+        } catch (AllocError &) {
+            a.defrag();
+            continue;
+        }
+        sizes[index] = size;
+        std::fill_n(static_cast<char *>(ptrs[index].get()), size, char(index));
+    }
+
+    for (size_t i = 0; i < ptrs.size(); i++) {
+        char *v = static_cast<char *>(ptrs[i].get());
+        if (v != nullptr) {
+            EXPECT_TRUE(isValidMemory(ptrs[i], sizes[i]));
+            EXPECT_TRUE(std::all_of(v, v + sizes[i], [i](char c) { return c == char(i); }));
+        }
+        a.free(ptrs[i]);
+    }
+
+    // Everything is back in a single piece
+    Pointer p = a.alloc(sizeof(buf) / 2);
+    a.free(p);
+}
@@ -0,0 +1,310 @@
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <afina/allocator/Arena.h>
+#include <afina/allocator/ConcurrentSlabAllocator.h>
+#include <afina/allocator/Mempool.h>
+#include <afina/allocator/SlabAllocator.h>
+#include <afina/allocator/SlabCache.h>
+
+using namespace std;
+using namespace Afina::Allocator;
+
+static const size_t slab_size = 64 * 1024;
+
+// Returns value of the stat with the given name, empty string if there is none
+template <typename Allocator> static string Stat(Allocator &allocator, const string &name) {
+    vector<pair<string, string>> stats;
+    allocator.Stats(stats);
+    for (auto &stat : stats) {
+        if (stat.first == name) {
+            return stat.second;
+        }
+    }
+    return "";
+}
+
+TEST(SlabTest, ArenaSlabs) {
+    Arena arena(4 * slab_size, slab_size);
+    EXPECT_EQ(4u, arena.Capacity());
+
+    set<void *> slabs;
+    for (int i = 0; i < 4; i++) {
+        void *slab = arena.Map();
+        ASSERT_NE(nullptr, slab);
+        EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(slab) % slab_size);
+        slabs.insert(slab);
+    }
+    EXPECT_EQ(4u, slabs.size());
+    EXPECT_EQ(nullptr, arena.Map());
+    EXPECT_FALSE(arena.Available());
+
+    arena.Unmap(*slabs.begin());
+    EXPECT_EQ(3u, arena.Used());
+    EXPECT_EQ(*slabs.begin(), arena.Map());
+}
+
+TEST(SlabTest, MempoolReturnsEmptySlabs) {
+    auto arena = make_shared<Arena>(16 * slab_size, slab_size);
+    SlabCache cache(arena);
+    Mempool pool(cache, 1024);
+
+    vector<void *> objects;
+    for (size_t i = 0; i < pool.ObjectsPerSlab() * 5; i++) {
+        objects.push_back(pool.Alloc());
+        ASSERT_NE(nullptr, objects.back());
+        EXPECT_EQ(&pool, Mempool::Of(objects.back(), slab_size));
+        std::fill_n(static_cast<char *>(objects.back()), 1024, char(i));
+    }
+    EXPECT_EQ(5u, pool.Slabs());
+    EXPECT_EQ(set<void *>(objects.begin(), objects.end()).size(), objects.size());
+    for (size_t i = 0; i < objects.size(); i++) {
+        EXPECT_EQ(char(i), static_cast<char *>(objects[i])[1023]);
+    }
+
+    for (void *object : objects) {
+        pool.Free(object);
+    }
+    EXPECT_EQ(0u, pool.Slabs());
+    EXPECT_EQ(0u, pool.Used());
+
+    // Cache keeps a few empty slabs, the rest goes back to the arena
+    EXPECT_EQ(SlabCache::max_spare, cache.Spare());
+    EXPECT_EQ(SlabCache::max_spare, arena->Used());
+}
+
+TEST(SlabTest, MempoolDrainsColdestSlab) {
+    auto arena = make_shared<Arena>(16 * slab_size, slab_size);
+    SlabCache cache(arena);
+    Mempool pool(cache, 1024);
+
+    // Single slab is never drained
+    void *first = pool.Alloc();
+    EXPECT_EQ(nullptr, pool.Coldest());
+
+    // Slab allocated from the longest ago is the coldest one
+    vector<void *> objects;
+    for (size_t i = 1; i < pool.ObjectsPerSlab() * 3; i++) {
+        objects.push_back(pool.Alloc());
+    }
+    pool.Free(first);
+    objects.push_back(pool.Alloc());
+    EXPECT_EQ(first, objects.back());
+    char *coldest = static_cast<char *>(pool.Coldest());
+    ASSERT_NE(nullptr, coldest);
+    auto inside = [coldest](void *object) {
+        return static_cast<char *>(object) >= coldest && static_cast<char *>(object) < coldest + slab_size;
+    };
+    EXPECT_FALSE(inside(objects.back()));
+
+    // Nothing is allocated from the drained slab even if it has free objects
+    pool.Drain(coldest);
+    EXPECT_TRUE(pool.Draining(coldest));
+    EXPECT_EQ(3u, pool.Slabs());
+    bool keep = false;
+    for (auto it = objects.begin(); it != objects.end();) {
+        if (inside(*it) && (keep = !keep)) {
+            pool.Free(*it);
+            it = objects.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    EXPECT_TRUE(pool.Draining(coldest));
+    for (int i = 0; i < 10; i++) {
+        void *object = pool.Alloc();
+        EXPECT_FALSE(inside(object));
+        objects.push_back(object);
+    }
+
+    // It goes back to the cache once the last object is freed
+    for (auto it = objects.begin(); it != objects.end();) {
+        if (inside(*it)) {
+            pool.Free(*it);
+            it = objects.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    EXPECT_FALSE(pool.Draining(coldest));
+    EXPECT_EQ(3u, pool.Slabs());
+    for (void *object : objects) {
+        pool.Free(object);
+    }
+    EXPECT_EQ(0u, pool.Slabs());
+}
+
+TEST(SlabTest, SizeClasses) {
+    SlabAllocator allocator(make_shared<Arena>(16 * slab_size, slab_size), 64, 1.25);
+    EXPECT_EQ(64u, allocator.ClassSize(1));
+    EXPECT_EQ(64u, allocator.ClassSize(64));
+    EXPECT_EQ(80u, allocator.ClassSize(65));
+    EXPECT_EQ(slab_size / 4, allocator.MaxSize());
+
+    // Every class wastes at most a quarter of an object
+    for (size_t size = 64; size <= allocator.MaxSize(); size += 7) {
+        EXPECT_GE(allocator.ClassSize(size), size);
+        EXPECT_LE(allocator.ClassSize(size), size * 5 / 4 + 16);
+    }
+
+    void *object = allocator.Allocate(100);
+    ASSERT_NE(nullptr, object);
+    string prefix = "slab_class_" + to_string(allocator.ClassSize(100));
+    EXPECT_EQ("1", Stat(allocator, prefix + "_slabs"));
+    EXPECT_EQ("1", Stat(allocator, prefix + "_used"));
+    allocator.Free(object, 100);
+    EXPECT_EQ("0", Stat(allocator, prefix + "_used"));
+    EXPECT_EQ("0", Stat(allocator, prefix + "_slabs"));
+}
+
+TEST(SlabTest, SharedArena) {
+    auto arena = make_shared<Arena>(8 * slab_size, slab_size);
+    SlabAllocator first(arena), second(arena);
+
+    // First allocator takes all the slabs
+    vector<void *> objects;
+    while (void *object = first.Allocate(1000)) {
+        objects.push_back(object);
+    }
+    EXPECT_FALSE(first.Available(1000));
+    EXPECT_FALSE(second.Available(100));
+    EXPECT_EQ(nullptr, second.Allocate(100));
+
+    // Slabs it has freed go to the other one
+    for (void *object : objects) {
+        first.Free(object, 1000);
+    }
+    EXPECT_EQ(SlabCache::max_spare, arena->Used());
+    EXPECT_NE(nullptr, second.Allocate(100));
+}
+
+TEST(SlabTest, MagazinesExhaustion) {
+    ConcurrentSlabAllocator allocator(make_shared<Arena>(4 * slab_size, slab_size));
+    const size_t magazine_objects = ConcurrentSlabAllocator::magazine_size;
+
+    vector<void *> objects;
+    while (void *object = allocator.Allocate(1000)) {
+        objects.push_back(object);
+    }
+    EXPECT_LT(4 * magazine_objects, objects.size());
+    EXPECT_FALSE(allocator.Available(1000));
+    EXPECT_FALSE(allocator.Available(100));
+
+    // Freed object is in the magazine of this thread, the other class has to wait for slabs
+    allocator.Free(objects.back(), 1000);
+    EXPECT_TRUE(allocator.Available(1000));
+    EXPECT_FALSE(allocator.Available(100));
+    EXPECT_EQ(objects.back(), allocator.Allocate(1000));
+
+    // They stay in magazines and in the depot, depot gives them back to slabs once allocation of the other
+    // class fails, asking for availability doesn't drain it
+    for (void *object : objects) {
+        allocator.Free(object, 1000);
+    }
+    EXPECT_FALSE(allocator.Available(100));
+    EXPECT_NE(nullptr, allocator.Allocate(100));
+    EXPECT_TRUE(allocator.Available(100));
+}
+
+TEST(SlabTest, MagazinesCrossThreadFree) {
+    auto arena = make_shared<Arena>(16 * slab_size, slab_size);
+    ConcurrentSlabAllocator allocator(arena);
+
+    // Objects allocated here are freed by another thread and come back through the depot
+    const size_t count = 2000;
+    set<void *> first;
+    vector<void *> objects;
+    for (size_t i = 0; i < count; i++) {
+        void *object = allocator.Allocate(200);
+        ASSERT_NE(nullptr, object);
+        objects.push_back(object);
+        first.insert(object);
+    }
+    size_t slabs = arena->Used();
+    std::thread([&allocator, &objects]() {
+        for (void *object : objects) {
+            allocator.Free(object, 200);
+        }
+    }).join();
+    EXPECT_EQ(count, first.size());
+
+    set<void *> second;
+    for (size_t i = 0; i < count; i++) {
+        void *object = allocator.Allocate(200);
+        ASSERT_NE(nullptr, object);
+        EXPECT_TRUE(second.insert(object).second);
+    }
+    EXPECT_EQ(slabs, arena->Used());
+    EXPECT_NE("0", Stat(allocator, "slab_refills"));
+}
+
+TEST(SlabTest, MagazinesConcurrent) {
+    auto arena = make_shared<Arena>(64 * slab_size, slab_size);
+    ConcurrentSlabAllocator allocator(arena);
+
+    // Threads fill objects with own byte and check it before free, some objects are freed by other threads
+    std::mutex lock;
+    vector<pair<char *, size_t>> shared;
+    vector<std::thread> workers;
+    for (int t = 0; t < 4; t++) {
+        workers.emplace_back([&, t]() {
+            std::mt19937 random(t);
+            vector<pair<char *, size_t>> own;
+            for (int i = 0; i < 50000; i++) {
+                if (own.size() < 500 && random() % 2 == 0) {
+                    size_t size = 16 + random() % 2000;
+                    char *object = static_cast<char *>(allocator.Allocate(size));
+                    ASSERT_NE(nullptr, object);
+                    std::fill(object, object + size, char(t));
+                    own.emplace_back(object, size);
+                } else if (!own.empty()) {
+                    auto object = own.back();
+                    own.pop_back();
+                    ASSERT_EQ(object.second, size_t(std::count(object.first, object.first + object.second,
+                                                               char(object.first[0]))));
+                    if (random() % 4 == 0) {
+                        std::lock_guard<std::mutex> guard(lock);
+                        shared.push_back(object);
+                        continue;
+                    }
+                    allocator.Free(object.first, object.second);
+                }
+                if (i % 100 == 0) {
+                    std::lock_guard<std::mutex> guard(lock);
+                    for (auto &object : shared) {
+                        allocator.Free(object.first, object.second);
+                    }
+                    shared.clear();
+                }
+            }
+            for (auto &object : own) {
+                allocator.Free(object.first, object.second);
+            }
+        });
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+    for (auto &object : shared) {
+        allocator.Free(object.first, object.second);
+    }
+
+    // Workers gave their magazines back on exit, all that is left are magazines of this thread and the depot
+    const size_t per_class = (2 + ConcurrentSlabAllocator::depot_limit) * ConcurrentSlabAllocator::magazine_size;
+    vector<pair<string, string>> stats;
+    allocator.Stats(stats);
+    for (auto &stat : stats) {
+        if (stat.first.compare(0, 11, "slab_class_") == 0 && stat.first.rfind("_used") == stat.first.size() - 5) {
+            EXPECT_GE(per_class, std::stoul(stat.second)) << stat.first;
+        }
+    }
+}
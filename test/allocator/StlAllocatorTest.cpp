@@ -0,0 +1,170 @@
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <afina/allocator/Arena.h>
+#include <afina/allocator/ConcurrentSlabAllocator.h>
+#include <afina/allocator/Region.h>
+#include <afina/allocator/SlabAllocator.h>
+#include <afina/allocator/StlAllocator.h>
+
+using namespace std;
+using namespace Afina::Allocator;
+
+static const size_t slab_size = 64 * 1024;
+
+template <typename Source> using String = basic_string<char, char_traits<char>, StlAllocator<char, Source>>;
+
+template <typename Source> using Vector = vector<String<Source>, StlAllocator<String<Source>, Source>>;
+
+template <typename Source>
+using Map = map<String<Source>, int, less<String<Source>>, StlAllocator<pair<const String<Source>, int>, Source>>;
+
+TEST(StlAllocatorTest, RegionContainers) {
+    auto arena = make_shared<Arena>(16 * slab_size, slab_size);
+    Region region(arena);
+    StlAllocator<char, Region> allocator(region);
+
+    // Strings of the vector take the allocator of the vector through rebind
+    Vector<Region> keys(allocator);
+    for (int i = 0; i < 1000; i++) {
+        keys.emplace_back(("key" + to_string(i) + string(100, 'x')).c_str(), allocator);
+    }
+    Map<Region> index(allocator);
+    for (size_t i = 0; i < keys.size(); i++) {
+        index.emplace(keys[i], int(i));
+    }
+    EXPECT_EQ(1000u, index.size());
+    EXPECT_EQ(42, index.at(keys[42]));
+    EXPECT_EQ(&region, &index.begin()->first.get_allocator().source());
+    EXPECT_LT(1u, region.Slabs());
+    EXPECT_LT(200000u, region.Used());
+
+    // Objects are freed all at once, arena gets all slabs but one back
+    index.clear();
+    keys.clear();
+    keys.shrink_to_fit();
+    region.Reset();
+    EXPECT_EQ(0u, region.Used());
+    EXPECT_EQ(1u, region.Slabs());
+    EXPECT_EQ(1u, arena->Used());
+
+    // Block bigger than a slab comes from the heap
+    String<Region> big(2 * slab_size, 'y', allocator);
+    EXPECT_EQ(0u, region.Used());
+    EXPECT_EQ('y', big.back());
+}
+
+TEST(StlAllocatorTest, RegionTakesLastBack) {
+    auto arena = make_shared<Arena>(4 * slab_size, slab_size);
+    Region region(arena);
+
+    // Temporary freed before the next allocation gives its place back
+    vector<uint64_t, StlAllocator<uint64_t, Region>> numbers(1000, 1, StlAllocator<uint64_t, Region>(region));
+    EXPECT_EQ(8000u, region.Used());
+    for (int i = 0; i < 100; i++) {
+        String<Region> temporary(1000, 't', StlAllocator<char, Region>(region));
+    }
+    EXPECT_EQ(8000u, region.Used());
+    EXPECT_EQ(1u, region.Slabs());
+
+    // Out of slabs is bad_alloc
+    vector<String<Region>> blocks;
+    EXPECT_THROW(
+        {
+            while (true) {
+                blocks.emplace_back(slab_size / 2, 'z', StlAllocator<char, Region>(region));
+            }
+        },
+        std::bad_alloc);
+    EXPECT_EQ(4u, region.Slabs());
+}
+
+TEST(StlAllocatorTest, EmptyAllocation) {
+    auto arena = make_shared<Arena>(4 * slab_size, slab_size);
+    Region region(arena);
+    StlAllocator<uint64_t, Region> allocator(region);
+
+    // Empty block is a real one even before region has any slab, and could be given back
+    uint64_t *first = allocator.allocate(0);
+    uint64_t *second = allocator.allocate(0);
+    EXPECT_NE(nullptr, first);
+    EXPECT_NE(first, second);
+    allocator.deallocate(second, 0);
+    allocator.deallocate(first, 0);
+    EXPECT_EQ(0u, region.Used());
+
+    vector<uint64_t, StlAllocator<uint64_t, Region>> numbers(allocator);
+    numbers.reserve(0);
+    numbers.shrink_to_fit();
+    EXPECT_TRUE(numbers.empty());
+}
+
+TEST(StlAllocatorTest, Propagation) {
+    auto arena = make_shared<Arena>(16 * slab_size, slab_size);
+    Region first(arena), second(arena);
+    StlAllocator<char, Region> a(first), b(second);
+    EXPECT_TRUE((a == StlAllocator<int, Region>(first)));
+    EXPECT_TRUE(a != b);
+
+    // Copy keeps the source, assignment and swap take the source of the other container
+    Vector<Region> x(a), y(b);
+    x.emplace_back(String<Region>("first", a));
+    y.emplace_back(String<Region>("second", b));
+    Vector<Region> z(x);
+    EXPECT_TRUE(z.get_allocator() == a);
+    z = y;
+    EXPECT_TRUE(z.get_allocator() == b);
+    x.swap(y);
+    EXPECT_TRUE(x.get_allocator() == b);
+    EXPECT_EQ("second", x[0]);
+    x = std::move(y);
+    EXPECT_TRUE(x.get_allocator() == a);
+    EXPECT_EQ("first", x[0]);
+}
+
+TEST(StlAllocatorTest, SlabAllocators) {
+    auto arena = make_shared<Arena>(16 * slab_size, slab_size);
+    SlabAllocator slabs(arena);
+    {
+        Map<SlabAllocator> index{StlAllocator<char, SlabAllocator>(slabs)};
+        for (int i = 0; i < 1000; i++) {
+            index.emplace(String<SlabAllocator>(to_string(i).c_str(), index.get_allocator()), i);
+        }
+        EXPECT_EQ(999, index.at(String<SlabAllocator>("999", index.get_allocator())));
+        EXPECT_NE(0u, slabs.Reserved());
+    }
+
+    // Nodes of the map went back to their classes
+    vector<pair<string, string>> stats;
+    slabs.Stats(stats);
+    for (auto &stat : stats) {
+        if (stat.first.rfind("_used") == stat.first.size() - 5) {
+            EXPECT_EQ("0", stat.second) << stat.first;
+        }
+    }
+
+    // Threads share the concurrent one
+    ConcurrentSlabAllocator shared(make_shared<Arena>(64 * slab_size, slab_size));
+    vector<std::thread> workers;
+    for (int t = 0; t < 4; t++) {
+        workers.emplace_back([&shared, t]() {
+            StlAllocator<char, ConcurrentSlabAllocator> allocator(shared);
+            Vector<ConcurrentSlabAllocator> values(allocator);
+            for (int i = 0; i < 2000; i++) {
+                values.emplace_back(size_t(i % 200), char('a' + t), allocator);
+            }
+            for (int i = 0; i < 2000; i++) {
+                ASSERT_EQ(String<ConcurrentSlabAllocator>(size_t(i % 200), char('a' + t), allocator), values[i]);
+            }
+        });
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+}
@@ -0,0 +1,55 @@
+#include "gtest/gtest.h"
+#include <string>
+#include <vector>
+
+#include <afina/execute/Get.h>
+
+#include "storage/ShardedLRU.h"
+
+using namespace Afina::Backend;
+using namespace Afina::Execute;
+
+TEST(GetTest, ResponseFormat) {
+    ShardedLRU storage(4 * 1024, 4);
+    storage.Put("KEY1", "val1", 7);
+    storage.Put("KEY3", "value3");
+
+    std::string out;
+    Get get({"KEY1", "KEY2", "KEY3"});
+    get.Execute(storage, "", out);
+    EXPECT_EQ("VALUE KEY1 7 4\r\nval1\r\nVALUE KEY3 0 6\r\nvalue3\r\nEND", out);
+}
+
+TEST(GetTest, RequestOrder) {
+    ShardedLRU storage(64 * 1024, 4);
+    std::vector<std::string> keys;
+    std::string expected;
+    for (int i = 0; i < 32; i++) {
+        keys.push_back("key" + std::to_string(31 - i));
+        if (i % 3 != 0) {
+            storage.Put(keys.back(), std::to_string(i));
+            expected += "VALUE " + keys.back() + " 0 " + std::to_string(std::to_string(i).size()) + "\r\n" +
+                        std::to_string(i) + "\r\n";
+        }
+    }
+
+    // Shards are visited one by one, items still come in the order of keys
+    std::string out;
+    Get get(keys);
+    get.Execute(storage, "", out);
+    EXPECT_EQ(expected + "END", out);
+}
+
+TEST(GetTest, Gets) {
+    ShardedLRU storage(4 * 1024, 4);
+    storage.Put("KEY1", "val1");
+
+    uint64_t cas = 0;
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value, nullptr, &cas));
+
+    std::string out;
+    Get gets({"KEY1"}, true);
+    gets.Execute(storage, "", out);
+    EXPECT_EQ("VALUE KEY1 0 4 " + std::to_string(cas) + "\r\nval1\r\nEND", out);
+}
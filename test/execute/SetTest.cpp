@@ -0,0 +1,26 @@
+#include "gtest/gtest.h"
+#include <string>
+
+#include <afina/execute/Set.h>
+
+#include "storage/ShardedLRU.h"
+
+using namespace Afina::Backend;
+using namespace Afina::Execute;
+
+TEST(SetTest, ResponseFormat) {
+    ShardedLRU storage(4 * 1024, 4);
+
+    std::string out;
+    Set set("KEY1", 0, 0);
+    set.Execute(storage, "val1", out);
+    EXPECT_EQ("STORED", out);
+
+    // Item storage rejects is reported, not silently dropped
+    set.Execute(storage, std::string(2 * 1024, 'v'), out);
+    EXPECT_EQ("NOT_STORED", out);
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val1", value);
+}
@@ -4,7 +4,13 @@
 #include <string>
 
 #include <afina/execute/Add.h>
+#include <afina/execute/CacheMemlimit.h>
+#include <afina/execute/Cas.h>
+#include <afina/execute/Decr.h>
 #include <afina/execute/Get.h>
+#include <afina/execute/Incr.h>
+#include <afina/execute/Prepend.h>
+#include <afina/execute/Replace.h>
 #include <afina/execute/Set.h>
 #include <afina/execute/Stats.h>
 
@@ -58,6 +64,130 @@ TEST(MemcachedParserTest, SimpleAdd) {
     ASSERT_EQ(-1, tmp->expire());
 }
 
+// Verify multi digit expiration time is parsed as a whole number
+TEST(MemcachedParserTest, SetWithExpire) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    bool cmd_avail = parser.Parse("set foo 0 3600 6\r\nfooval\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ(18, consumed);
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+
+    Execute::Set *tmp = reinterpret_cast<Execute::Set *>(cmd.get());
+    ASSERT_EQ(3600, tmp->expire());
+}
+
+// Verify expiration time doesn't silently wrap around
+TEST(MemcachedParserTest, ExpireOverflow) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    ASSERT_THROW(parser.Parse("set foo 0 99999999999 6\r\n", consumed), std::runtime_error);
+}
+
+// Verify cas command carries version client has seen
+TEST(MemcachedParserTest, SimpleCas) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    bool cmd_avail = parser.Parse("cas foo 3 0 6 18446744073709551615\r\nfooval\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ(36, consumed);
+    ASSERT_EQ("cas", parser.Name());
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(6, value_size);
+
+    Execute::Cas *tmp = reinterpret_cast<Execute::Cas *>(cmd.get());
+    ASSERT_EQ("foo", tmp->key());
+    ASSERT_EQ(3, tmp->flags());
+    ASSERT_EQ(UINT64_MAX, tmp->cas());
+}
+
+// Verify gets command asks for versions
+TEST(MemcachedParserTest, SimpleGets) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    bool cmd_avail = parser.Parse("gets foo bar\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+
+    Execute::Get *tmp = reinterpret_cast<Execute::Get *>(cmd.get());
+    ASSERT_EQ(2, tmp->keys().size());
+    ASSERT_TRUE(tmp->cas());
+}
+
+// Verify replace and prepend commands are built
+TEST(MemcachedParserTest, ReplacePrepend) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    size_t value_size;
+    ASSERT_TRUE(parser.Parse("replace foo 1 0 3\r\n", consumed));
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(dynamic_cast<Execute::Replace *>(cmd.get()) == nullptr);
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("prepend foo 0 0 3\r\n", consumed));
+    cmd = parser.Build(value_size);
+    ASSERT_FALSE(dynamic_cast<Execute::Prepend *>(cmd.get()) == nullptr);
+    ASSERT_EQ(3, value_size);
+}
+
+// Verify incr/decr commands have no data block
+TEST(MemcachedParserTest, IncrDecr) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    size_t value_size = 1;
+    ASSERT_TRUE(parser.Parse("incr counter 18446744073709551615\r\n", consumed));
+    ASSERT_EQ(35, consumed);
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_EQ(0, value_size);
+    Execute::Incr *incr = dynamic_cast<Execute::Incr *>(cmd.get());
+    ASSERT_FALSE(incr == nullptr);
+    ASSERT_EQ("counter", incr->key());
+    ASSERT_EQ(UINT64_MAX, incr->delta());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("decr counter 5\r\n", consumed));
+    cmd = parser.Build(value_size);
+    Execute::Decr *decr = dynamic_cast<Execute::Decr *>(cmd.get());
+    ASSERT_FALSE(decr == nullptr);
+    ASSERT_EQ(5, decr->delta());
+
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("incr counter 18446744073709551616\r\n", consumed), std::runtime_error);
+}
+
+TEST(MemcachedParserTest, CacheMemlimit) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    size_t value_size = 1;
+    ASSERT_TRUE(parser.Parse("cache_memlimit 4096\r\n", consumed));
+    ASSERT_EQ(21, consumed);
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_EQ(0, value_size);
+    Execute::CacheMemlimit *memlimit = dynamic_cast<Execute::CacheMemlimit *>(cmd.get());
+    ASSERT_FALSE(memlimit == nullptr);
+    ASSERT_EQ(4096, memlimit->megabytes());
+
+    // Limit must fit 64 bits once converted to bytes
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("cache_memlimit 17592186044416\r\n", consumed), std::runtime_error);
+}
+
 // Verify simple get command passed in a single string
 TEST(MemcachedParserTest, SimpleGet) {
     Protocol::Parser parser;
@@ -0,0 +1,152 @@
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "storage/FrequencySketch.h"
+#include "storage/SimpleLRU.h"
+
+#include "TestHelpers.h"
+
+using namespace Afina::Backend;
+
+static std::string Key(char prefix, int i) {
+    char key[8];
+    std::snprintf(key, sizeof(key), "%c%04d", prefix, i);
+    return key;
+}
+
+TEST(AdmissionTest, SketchCounts) {
+    FrequencySketch sketch(64);
+    for (int i = 0; i < 5; i++) {
+        sketch.Increment(42);
+    }
+    sketch.Increment(7);
+
+    EXPECT_EQ(5, sketch.Frequency(42));
+    EXPECT_EQ(1, sketch.Frequency(7));
+    EXPECT_EQ(0, sketch.Frequency(1000));
+
+    // Counters saturate
+    for (int i = 0; i < 100; i++) {
+        sketch.Increment(42);
+    }
+    EXPECT_EQ(15, sketch.Frequency(42));
+}
+
+TEST(AdmissionTest, SketchAges) {
+    FrequencySketch sketch(16);
+    for (int i = 0; i < 8; i++) {
+        sketch.Increment(42);
+    }
+
+    // Sample size is 10 times the width, one-off keys push sketch over it
+    for (uint32_t i = 0; i < 10 * sketch.Capacity(); i++) {
+        sketch.Increment(1000 + i);
+    }
+    EXPECT_LE(sketch.Frequency(42), 4);
+    EXPECT_LT(sketch.Size(), 10 * sketch.Capacity());
+}
+
+// Fills cache with hot keys that are read several times, then scans one-off keys through it.
+// Returns number of hot keys that survived the scan
+static int HotAfterScan(SimpleLRU &storage) {
+    std::string value;
+    for (int round = 0; round < 5; round++) {
+        for (int i = 0; i < 500; i++) {
+            if (!storage.Get(Key('h', i), value)) {
+                storage.Put(Key('h', i), "vvvvv");
+            }
+        }
+    }
+
+    for (int i = 0; i < 2000; i++) {
+        if (!storage.Get(Key('s', i), value)) {
+            storage.Put(Key('s', i), "vvvvv");
+        }
+    }
+
+    int hot = 0;
+    for (int i = 0; i < 500; i++) {
+        hot += storage.Get(Key('h', i), value);
+    }
+    return hot;
+}
+
+TEST(AdmissionTest, ScanResistance) {
+    // Room for 1000 items, window takes 10 of them
+    SimpleLRU plain(10000, &SimpleLRU::SystemClock, EvictionPolicy::Kind::LRU, false);
+    EXPECT_EQ(0, HotAfterScan(plain));
+    EXPECT_EQ("0", Stat(plain, "admitted"));
+
+    SimpleLRU admitting(10000, &SimpleLRU::SystemClock, EvictionPolicy::Kind::LRU, true);
+    EXPECT_GE(HotAfterScan(admitting), 490);
+    EXPECT_NE("0", Stat(admitting, "rejected"));
+    EXPECT_EQ("10000", Stat(admitting, "bytes"));
+}
+
+TEST(AdmissionTest, PopularKeyGetsAdmitted) {
+    SimpleLRU storage(1000, &SimpleLRU::SystemClock, EvictionPolicy::Kind::LRU, true);
+    std::string value;
+    for (int i = 0; i < 100; i++) {
+        storage.Put(Key('k', i), "vvvvv");
+    }
+
+    // New key is rejected until it is requested more often than the main victim
+    storage.Put(Key('n', 0), "vvvvv");
+    storage.Put(Key('n', 1), "vvvvv");
+    EXPECT_FALSE(storage.Get(Key('n', 0), value));
+
+    for (int i = 0; i < 3; i++) {
+        storage.Get(Key('n', 2), value);
+    }
+    storage.Put(Key('n', 2), "vvvvv");
+    storage.Put(Key('n', 3), "vvvvv");
+    EXPECT_TRUE(storage.Get(Key('n', 2), value));
+    EXPECT_NE("0", Stat(storage, "admitted"));
+}
+
+TEST(AdmissionTest, WindowAccounting) {
+    SimpleLRU storage(1000, &SimpleLRU::SystemClock, EvictionPolicy::Kind::SLRU, true);
+    for (int i = 0; i < 100; i++) {
+        storage.Put(Key('k', i), "vvvvv");
+    }
+
+    // Nodes change size and leave the cache both while in the window and in the main part
+    for (int i = 0; i < 200; i++) {
+        storage.Put(Key('m', i), "vvvvv");
+        storage.Append(Key('m', i), "vvvvv");
+        storage.Append(Key('k', i % 100), "vvvvv");
+        if (i % 3 == 0) {
+            storage.Delete(Key('k', i % 100));
+        }
+        ASSERT_LE(std::stoull(Stat(storage, "bytes")), 1000);
+    }
+
+    for (int i = 0; i < 200; i++) {
+        storage.Delete(Key('k', i % 100));
+        storage.Delete(Key('m', i));
+    }
+    EXPECT_EQ("0", Stat(storage, "bytes"));
+
+    // Once empty, cache takes as much as before
+    for (int i = 0; i < 100; i++) {
+        storage.Put(Key('n', i), "vvvvv");
+    }
+    EXPECT_EQ("100", Stat(storage, "curr_items"));
+}
+
+TEST(AdmissionTest, GrowLastMainNode) {
+    SimpleLRU storage(10000, &SimpleLRU::SystemClock, EvictionPolicy::Kind::LRU, true);
+    ASSERT_TRUE(storage.Put("A", std::string(5000, 'a')));
+    ASSERT_TRUE(storage.Put("B", std::string(40, 'b')));
+
+    // Growing node is the only one in the main part, space comes from the window
+    EXPECT_TRUE(storage.Put("A", std::string(9990, 'a')));
+    EXPECT_TRUE(storage.Append("A", std::string(9, 'a')));
+    std::string value;
+    EXPECT_TRUE(storage.Get("A", value));
+    EXPECT_EQ(std::string(9999, 'a'), value);
+    EXPECT_FALSE(storage.Get("B", value));
+    EXPECT_EQ("1", Stat(storage, "curr_items"));
+}
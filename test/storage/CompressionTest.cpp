@@ -0,0 +1,150 @@
+#include "gtest/gtest.h"
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "storage/LzBlock.h"
+#include "storage/ShardedLRU.h"
+#include "storage/SimpleLRU.h"
+
+#include "TestHelpers.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+// JSON document of about the given size, compresses well
+static std::string Json(std::size_t size, int seed) {
+    std::string json = "[";
+    for (int i = 0; json.size() < size; i++) {
+        json += "{\"id\":" + std::to_string(seed * 1000 + i) + ",\"enabled\":true,\"name\":\"feature\"},";
+    }
+    json.back() = ']';
+    return json;
+}
+
+TEST(CompressionTest, Codec) {
+    std::mt19937 random(42);
+    std::vector<std::string> inputs = {"", "a", "abcabcabcabcabcabcabc", Json(100000, 1)};
+    std::string noise(10000, '\0');
+    for (auto &c : noise) {
+        c = random();
+    }
+    inputs.push_back(noise);
+
+    for (auto &input : inputs) {
+        std::string compressed(LzBlock::CompressBound(input.size()), '\0');
+        std::size_t size = LzBlock::Compress(input.data(), input.size(), &compressed[0], compressed.size());
+        ASSERT_NE(0u, size);
+
+        std::string output(input.size(), '\0');
+        EXPECT_EQ(long(input.size()), LzBlock::Decompress(compressed.data(), size, &output[0], output.size()));
+        EXPECT_EQ(input, output);
+
+        // Damaged block never writes past the output
+        if (!input.empty()) {
+            EXPECT_EQ(-1, LzBlock::Decompress(compressed.data(), size, &output[0], output.size() - 1));
+        }
+        for (std::size_t cut = 0; cut < size && cut < 64; cut++) {
+            LzBlock::Decompress(compressed.data(), cut, &output[0], output.size());
+        }
+    }
+}
+
+TEST(CompressionTest, ReadPaths) {
+    SimpleLRU storage(1024 * 1024, &SimpleLRU::SystemClock, EvictionPolicy::Kind::LRU, false, 1024);
+    std::string json = Json(20000, 1);
+    EXPECT_TRUE(storage.Put("json", json, 42));
+    EXPECT_TRUE(storage.Put("small", "value"));
+    EXPECT_EQ("1", Stat(storage, "compressed_items"));
+    EXPECT_EQ(std::to_string(json.size()), Stat(storage, "compressed_raw_bytes"));
+    EXPECT_GT(json.size() / 4, std::stoul(Stat(storage, "compressed_bytes")));
+
+    std::string value;
+    uint32_t flags;
+    EXPECT_TRUE(storage.Get("json", value, &flags));
+    EXPECT_EQ(json, value);
+    EXPECT_EQ(42u, flags);
+
+    std::string keys[] = {"small", "json"};
+    std::vector<std::string> values(2);
+    storage.MultiGet(keys, 2, [&](std::size_t index, const char *value, std::size_t size, uint32_t flags,
+                                  uint64_t cas) { values[index].assign(value, size); });
+    EXPECT_EQ("value", values[0]);
+    EXPECT_EQ(json, values[1]);
+
+    // View gets a copy of its own that outlives the item
+    Afina::ValueRef ref;
+    EXPECT_TRUE(storage.GetRef("json", ref));
+    EXPECT_EQ("1", Stat(storage, "detached_items"));
+    EXPECT_TRUE(storage.Delete("json"));
+    EXPECT_EQ(json, ref.str());
+    ref.Reset();
+    storage.Put("small", "value");
+    EXPECT_EQ("0", Stat(storage, "detached_items"));
+
+    EXPECT_TRUE(storage.Put("json", json));
+    std::size_t cursor = 0;
+    do {
+        cursor = storage.Scan(cursor, 16,
+                              [&](const char *key, std::size_t key_size, const char *value, std::size_t value_size,
+                                  uint32_t flags, time_t expire) {
+                                  if (std::string(key, key_size) == "json") {
+                                      EXPECT_EQ(json, std::string(value, value_size));
+                                  }
+                              });
+    } while (cursor != 0);
+}
+
+TEST(CompressionTest, Updates) {
+    SimpleLRU storage(1024 * 1024, &SimpleLRU::SystemClock, EvictionPolicy::Kind::LRU, false, 1024);
+    std::string json = Json(20000, 1);
+    EXPECT_TRUE(storage.Put("json", json));
+
+    // Changed value is compressed anew
+    std::string value;
+    EXPECT_TRUE(storage.Append("json", "]"));
+    EXPECT_TRUE(storage.Prepend("json", "["));
+    EXPECT_TRUE(storage.Get("json", value));
+    EXPECT_EQ("[" + json + "]", value);
+    EXPECT_EQ("1", Stat(storage, "compressed_items"));
+    EXPECT_EQ(std::to_string(json.size() + 2), Stat(storage, "compressed_raw_bytes"));
+
+    uint64_t counter;
+    EXPECT_EQ(Afina::Storage::CounterResult::NotNumber, storage.Increment("json", 1, counter));
+
+    // Value that doesn't compress well is stored as is
+    std::mt19937 random(42);
+    std::string noise(4096, '\0');
+    for (auto &c : noise) {
+        c = random();
+    }
+    EXPECT_TRUE(storage.Set("json", noise));
+    EXPECT_EQ("0", Stat(storage, "compressed_items"));
+    EXPECT_EQ("1", Stat(storage, "compress_rejected"));
+    EXPECT_TRUE(storage.Get("json", value));
+    EXPECT_EQ(noise, value);
+
+    EXPECT_TRUE(storage.Put("json", json));
+    EXPECT_TRUE(storage.Put("json", "small"));
+    EXPECT_EQ("0", Stat(storage, "compressed_items"));
+    EXPECT_TRUE(storage.Put("json", json));
+    EXPECT_TRUE(storage.Delete("json"));
+    EXPECT_EQ("0", Stat(storage, "compressed_items"));
+    EXPECT_EQ("0", Stat(storage, "compressed_bytes"));
+    EXPECT_EQ("0", Stat(storage, "compressed_raw_bytes"));
+}
+
+TEST(CompressionTest, MoreItemsFit) {
+    // Same memory holds several times more compressible values
+    std::size_t fit[2];
+    for (int compress = 0; compress < 2; compress++) {
+        ShardedLRU storage(1024 * 1024, 2, EvictionPolicy::Kind::LRU, false, compress ? 1024 : 0);
+        storage.SetMemoryLimit(512 * 1024);
+        for (int i = 0; i < 500; i++) {
+            storage.Put("key" + std::to_string(i), Json(10000, i));
+        }
+        fit[compress] = std::stoul(Stat(storage, "curr_items"));
+    }
+    EXPECT_GT(fit[1], fit[0] * 3);
+}
@@ -0,0 +1,108 @@
+#include "gtest/gtest.h"
+#include <memory>
+#include <string>
+
+#include "storage/EvictionPolicy.h"
+#include "storage/SimpleLRU.h"
+
+#include "TestHelpers.h"
+
+using namespace Afina::Backend;
+
+TEST(EvictionPolicyTest, Lru) {
+    LruPolicy policy;
+    for (uint32_t i = 0; i < 4; i++) {
+        policy.Insert(i);
+    }
+
+    policy.Touch(0);
+    EXPECT_EQ(1, policy.Victim());
+    policy.Erase(1);
+    EXPECT_EQ(2, policy.Victim());
+}
+
+TEST(EvictionPolicyTest, Clock) {
+    ClockPolicy policy;
+    for (uint32_t i = 0; i < 4; i++) {
+        policy.Insert(i);
+    }
+
+    // Referenced nodes get a second chance
+    policy.Touch(0);
+    policy.Touch(1);
+    EXPECT_EQ(2, policy.Victim());
+    policy.Erase(2);
+    EXPECT_EQ(3, policy.Victim());
+    policy.Erase(3);
+    EXPECT_EQ(0, policy.Victim());
+}
+
+TEST(EvictionPolicyTest, ClockAfterDeletes) {
+    ClockPolicy policy;
+    for (uint32_t i = 0; i < 1000; i++) {
+        policy.Insert(i);
+    }
+
+    // Hand goes over the nodes left after mass delete only
+    for (uint32_t i = 0; i < 998; i++) {
+        policy.Erase(i);
+    }
+    policy.Touch(998);
+    EXPECT_EQ(999, policy.Victim());
+    policy.Erase(999);
+    EXPECT_EQ(998, policy.Victim());
+}
+
+TEST(EvictionPolicyTest, Slru) {
+    SlruPolicy policy;
+    for (uint32_t i = 0; i < 10; i++) {
+        policy.Insert(i);
+    }
+
+    // Nodes hit on probation are promoted, even the oldest ones
+    policy.Touch(0);
+    policy.Touch(1);
+    EXPECT_EQ(2, policy.Victim());
+    policy.Erase(2);
+
+    // Promoted nodes outlive fresh ones
+    for (uint32_t i = 10; i < 20; i++) {
+        policy.Insert(i);
+        uint32_t victim = policy.Victim();
+        EXPECT_NE(0, victim);
+        EXPECT_NE(1, victim);
+        policy.Erase(victim);
+    }
+}
+
+TEST(EvictionPolicyTest, Parse) {
+    EXPECT_EQ(EvictionPolicy::Kind::LRU, EvictionPolicy::Parse("lru"));
+    EXPECT_EQ(EvictionPolicy::Kind::CLOCK, EvictionPolicy::Parse("clock"));
+    EXPECT_EQ(EvictionPolicy::Kind::SLRU, EvictionPolicy::Parse("slru"));
+    EXPECT_THROW(EvictionPolicy::Parse("mru"), std::invalid_argument);
+}
+
+// Cache stays within its limit and keeps recently hit items with any policy
+TEST(EvictionPolicyTest, SimpleLRUWithPolicies) {
+    const EvictionPolicy::Kind kinds[] = {EvictionPolicy::Kind::LRU, EvictionPolicy::Kind::CLOCK,
+                                          EvictionPolicy::Kind::SLRU};
+    for (auto kind : kinds) {
+        SimpleLRU storage(1000, &SimpleLRU::SystemClock, kind);
+
+        std::string value;
+        for (int i = 0; i < 1000; i++) {
+            EXPECT_TRUE(storage.Put("key" + std::to_string(i), "value"));
+            EXPECT_TRUE(storage.Get("key0", value));
+        }
+
+        // Updated item may grow, but is never evicted by itself
+        for (int i = 0; i < 1000; i++) {
+            std::string key = "key" + std::to_string(i);
+            EXPECT_TRUE(storage.Put(key, "value"));
+            EXPECT_TRUE(storage.Append(key, std::string(i % 50, 'x')));
+            EXPECT_TRUE(storage.Get(key, value));
+        }
+
+        EXPECT_LE(std::stoul(Stat(storage, "bytes")), 1000);
+    }
+}
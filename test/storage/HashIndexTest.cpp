@@ -0,0 +1,53 @@
+#include "gtest/gtest.h"
+#include <string>
+#include <vector>
+
+#include "storage/HashIndex.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+TEST(HashIndexTest, InsertFindErase) {
+    HashIndex<int> index;
+    for (int i = 0; i < 1000; i++) {
+        std::string key = "key" + std::to_string(i);
+        index.Insert(HashBytes(key.data(), key.size()), i);
+    }
+    EXPECT_EQ(1000, index.Size());
+
+    for (int i = 0; i < 1000; i += 2) {
+        std::string key = "key" + std::to_string(i);
+        EXPECT_TRUE(index.Erase(HashBytes(key.data(), key.size()), [i](int v) { return v == i; }));
+    }
+    EXPECT_EQ(500, index.Size());
+
+    for (int i = 0; i < 1000; i++) {
+        std::string key = "key" + std::to_string(i);
+        int *value = index.Find(HashBytes(key.data(), key.size()), [i](int v) { return v == i; });
+        if (i % 2 == 0) {
+            EXPECT_TRUE(value == nullptr);
+        } else {
+            ASSERT_TRUE(value != nullptr);
+            EXPECT_EQ(i, *value);
+        }
+    }
+}
+
+// All values share the same bucket of the initial table, so lookups and removals walk through a long probe chain.
+// There are as many of them as fit without growing the table, growth would spread them over buckets
+TEST(HashIndexTest, Collisions) {
+    HashIndex<int> index;
+    for (int i = 0; i < 14; i++) {
+        index.Insert(16 * i + 3, i);
+    }
+    EXPECT_EQ(16u, index.Capacity());
+
+    EXPECT_TRUE(index.Erase(16 * 5 + 3, [](int v) { return v == 5; }));
+    EXPECT_FALSE(index.Erase(16 * 5 + 3, [](int v) { return v == 5; }));
+    EXPECT_TRUE(index.Erase(16 * 0 + 3, [](int v) { return v == 0; }));
+
+    for (int i = 0; i < 14; i++) {
+        int *value = index.Find(16 * i + 3, [i](int v) { return v == i; });
+        EXPECT_EQ(i != 5 && i != 0, value != nullptr);
+    }
+}
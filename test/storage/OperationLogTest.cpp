@@ -0,0 +1,186 @@
+#include "gtest/gtest.h"
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "storage/OperationLog.h"
+#include "storage/PersistentStorage.h"
+#include "storage/ShardedLRU.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+#include "TestHelpers.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+// Snapshot and log files unique for the test process, removed once test is over
+class Files {
+public:
+    Files()
+        : snapshot("/tmp/afina_snapshot_" + std::to_string(getpid())),
+          log("/tmp/afina_wal_" + std::to_string(getpid())) {}
+    ~Files() {
+        unlink(snapshot.c_str());
+        for (int i = 0; i < 100; i++) {
+            unlink((log + "." + std::to_string(i)).c_str());
+        }
+    }
+
+    // Storage that logs changes, is neither started nor stopped
+    std::unique_ptr<PersistentStorage> Open(uint32_t window = 0) {
+        return std::unique_ptr<PersistentStorage>(new PersistentStorage(
+            std::make_shared<ShardedLRU>(1024 * 1024, 4), snapshot, 0,
+            std::unique_ptr<OperationLog>(new OperationLog(log, window))));
+    }
+
+    const std::string snapshot;
+    const std::string log;
+};
+
+TEST(OperationLogTest, ReplayAfterCrash) {
+    Files files;
+    {
+        auto storage = files.Open();
+        storage->Start();
+        uint64_t counter;
+        EXPECT_TRUE(storage->Put("key", "value", 7));
+        EXPECT_TRUE(storage->Append("key", "+"));
+        EXPECT_TRUE(storage->Prepend("key", "-"));
+        EXPECT_TRUE(storage->Put("counter", "10", 0, std::time(nullptr) + 3600));
+        EXPECT_EQ(Afina::Storage::CounterResult::Updated, storage->Increment("counter", 5, counter));
+        EXPECT_TRUE(storage->Put("deleted", "value"));
+        EXPECT_TRUE(storage->Delete("deleted"));
+        EXPECT_FALSE(storage->Set("missing", "value"));
+        EXPECT_EQ("7", Stat(*storage, "wal_records"));
+        // No Stop, so there is no snapshot
+    }
+
+    auto storage = files.Open();
+    storage->Start();
+    EXPECT_EQ("7", Stat(*storage, "wal_replayed"));
+    std::string value;
+    uint32_t flags;
+    time_t expire;
+    EXPECT_TRUE(storage->Get("key", value, &flags));
+    EXPECT_EQ("-value+", value);
+    EXPECT_EQ(7u, flags);
+    EXPECT_TRUE(storage->Get("counter", value, nullptr, nullptr, &expire));
+    EXPECT_EQ("15", value);
+    EXPECT_NE(0, expire);
+    EXPECT_FALSE(storage->Get("deleted", value));
+    EXPECT_FALSE(storage->Get("missing", value));
+}
+
+TEST(OperationLogTest, SnapshotCompactsLog) {
+    Files files;
+    {
+        auto storage = files.Open();
+        storage->Start();
+        EXPECT_TRUE(storage->Put("old", "value"));
+        EXPECT_TRUE(storage->Snapshot());
+        EXPECT_EQ("2", Stat(*storage, "wal_generation"));
+        EXPECT_NE(0, access((files.log + ".1").c_str(), F_OK));
+        EXPECT_TRUE(storage->Put("new", "value"));
+    }
+
+    // Only changes made after the snapshot are replayed
+    auto storage = files.Open();
+    storage->Start();
+    EXPECT_EQ("1", Stat(*storage, "snapshot_loaded_items"));
+    EXPECT_EQ("1", Stat(*storage, "wal_replayed"));
+    std::string value;
+    EXPECT_TRUE(storage->Get("old", value));
+    EXPECT_TRUE(storage->Get("new", value));
+    storage->Stop();
+    EXPECT_NE(0, access((files.log + ".2").c_str(), F_OK));
+}
+
+TEST(OperationLogTest, SnapshotDuringChanges) {
+    // Snapshot walks the storage while counters go up, log replayed over it must not count anything twice
+    Files files;
+    const int threads = 4, increments = 2000;
+    {
+        auto storage = files.Open();
+        storage->Start();
+        for (int t = 0; t < threads; t++) {
+            storage->Put("counter" + std::to_string(t), "0");
+            storage->Put("list" + std::to_string(t), "");
+        }
+
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&storage, t] {
+                uint64_t counter;
+                for (int i = 0; i < increments; i++) {
+                    storage->Increment("counter" + std::to_string(t), 1, counter);
+                    storage->Append("list" + std::to_string(t), "x");
+                }
+            });
+        }
+        for (int i = 0; i < 3; i++) {
+            EXPECT_TRUE(storage->Snapshot());
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+    }
+
+    auto storage = files.Open();
+    storage->Start();
+    std::string value;
+    for (int t = 0; t < threads; t++) {
+        EXPECT_TRUE(storage->Get("counter" + std::to_string(t), value));
+        EXPECT_EQ(std::to_string(increments), value);
+        EXPECT_TRUE(storage->Get("list" + std::to_string(t), value));
+        EXPECT_EQ(std::size_t(increments), value.size());
+    }
+}
+
+TEST(OperationLogTest, TornRecord) {
+    Files files;
+    {
+        auto storage = files.Open();
+        storage->Start();
+        EXPECT_TRUE(storage->Put("key1", "value1"));
+        EXPECT_TRUE(storage->Put("key2", "value2"));
+    }
+
+    // Crash in the middle of a write leaves part of the record
+    std::ifstream in(files.log + ".1", std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::ofstream(files.log + ".1", std::ios::binary | std::ios::trunc) << content.substr(0, content.size() - 3);
+
+    auto storage = files.Open();
+    storage->Start();
+    EXPECT_EQ("1", Stat(*storage, "wal_replayed"));
+    EXPECT_EQ("1", Stat(*storage, "wal_damaged"));
+    std::string value;
+    EXPECT_TRUE(storage->Get("key1", value));
+    EXPECT_FALSE(storage->Get("key2", value));
+
+    // Log goes on in a new segment
+    EXPECT_TRUE(storage->Put("key3", "value3"));
+    EXPECT_EQ("2", Stat(*storage, "wal_generation"));
+}
+
+TEST(OperationLogTest, DurabilityWindow) {
+    Files files;
+    {
+        auto storage = files.Open(50);
+        storage->Start();
+        for (int i = 0; i < 100; i++) {
+            EXPECT_TRUE(storage->Put("key" + std::to_string(i), "value"));
+        }
+        // Changes of the window are gathered into a few groups
+        EXPECT_GT(100, std::stoi(Stat(*storage, "wal_commits")));
+    }
+
+    auto storage = files.Open();
+    storage->Start();
+    EXPECT_EQ("100", Stat(*storage, "wal_replayed"));
+}
@@ -0,0 +1,191 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "storage/RcuLRU.h"
+
+#include "TestHelpers.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+TEST(RcuLRUTest, PutGetDelete) {
+    RcuLRU storage(4 * 1024);
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_FALSE(storage.PutIfAbsent("KEY1", "val3"));
+    EXPECT_TRUE(storage.Set("KEY2", "val4"));
+    EXPECT_FALSE(storage.Set("KEY3", "val5"));
+
+    std::string value;
+    uint32_t flags;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val1", value);
+    EXPECT_TRUE(storage.Get("KEY2", value, &flags));
+    EXPECT_EQ("val4", value);
+
+    EXPECT_TRUE(storage.Append("KEY1", "+"));
+    EXPECT_TRUE(storage.Prepend("KEY1", "-"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("-val1+", value);
+
+    uint64_t cas;
+    EXPECT_TRUE(storage.Put("KEY3", "41", 7));
+    EXPECT_TRUE(storage.Get("KEY3", value, &flags, &cas));
+    EXPECT_EQ(7u, flags);
+    uint64_t counter;
+    EXPECT_EQ(Afina::Storage::CounterResult::Updated, storage.Increment("KEY3", 1, counter));
+    EXPECT_EQ(42u, counter);
+    EXPECT_EQ(Afina::Storage::CasResult::Exists, storage.CompareAndSet("KEY3", "0", cas));
+    EXPECT_EQ(Afina::Storage::CounterResult::NotNumber, storage.Decrement("KEY1", 1, counter));
+    EXPECT_TRUE(storage.Get("KEY3", value, &flags, &cas));
+    EXPECT_EQ("42", value);
+    EXPECT_EQ(7u, flags);
+    EXPECT_EQ(Afina::Storage::CasResult::Stored, storage.CompareAndSet("KEY3", "0", cas));
+
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_EQ("2", Stat(storage, "curr_items"));
+}
+
+TEST(RcuLRUTest, ManyKeys) {
+    // Index grows several times, nothing gets lost
+    RcuLRU storage(1024 * 1024);
+    for (int i = 0; i < 10000; i++) {
+        ASSERT_TRUE(storage.Put("key" + std::to_string(i), "value" + std::to_string(i)));
+    }
+
+    std::string value;
+    for (int i = 0; i < 10000; i++) {
+        ASSERT_TRUE(storage.Get("key" + std::to_string(i), value));
+        EXPECT_EQ("value" + std::to_string(i), value);
+    }
+    EXPECT_EQ("10000", Stat(storage, "curr_items"));
+    EXPECT_EQ("10000", Stat(storage, "get_hits"));
+}
+
+TEST(RcuLRUTest, Eviction) {
+    RcuLRU storage(100);
+
+    // Each item takes 10 bytes
+    for (int i = 0; i < 10; i++) {
+        EXPECT_TRUE(storage.Put("KEY" + std::to_string(i), "value" + std::to_string(i)));
+    }
+
+    // Referenced item gets the second chance
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY0", value));
+    EXPECT_TRUE(storage.Put("KEYA", "valueA"));
+    EXPECT_TRUE(storage.Get("KEY0", value));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_EQ("1", Stat(storage, "evictions"));
+    EXPECT_EQ("100", Stat(storage, "bytes"));
+
+    EXPECT_FALSE(storage.Put("KEYB", std::string(100, 'v')));
+    EXPECT_TRUE(storage.Put("KEYB", std::string(96, 'v')));
+    EXPECT_TRUE(storage.Get("KEYB", value));
+    EXPECT_EQ("1", Stat(storage, "curr_items"));
+}
+
+TEST(RcuLRUTest, Expiration) {
+    fake_now = 1000000;
+    RcuLRU storage(1024, &FakeClock);
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1", 0, fake_now + 10));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    fake_now += 10;
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_FALSE(storage.Set("KEY1", "val3"));
+    EXPECT_TRUE(storage.PutIfAbsent("KEY1", "val3"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val3", value);
+    EXPECT_EQ("1", Stat(storage, "expired"));
+}
+
+TEST(RcuLRUTest, PinnedValueSurvivesUpdate) {
+    RcuLRU storage(1024);
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+
+    Afina::ValueRef ref;
+    EXPECT_TRUE(storage.GetRef("KEY1", ref));
+
+    // Enough writes for several reclaim attempts, view keeps the old node alive
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_TRUE(storage.Put("KEY1", "new" + std::to_string(i)));
+    }
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_EQ("val1", ref.str());
+
+    ref.Reset();
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_TRUE(storage.Put("KEY2", "new" + std::to_string(i)));
+    }
+    EXPECT_GT(200u, std::stoul(Stat(storage, "retired_items")));
+}
+
+TEST(RcuLRUTest, HeapAligned) {
+    // Per thread slots share no cache lines only if the storage itself starts at one
+    std::unique_ptr<RcuLRU> storage(new RcuLRU(1024));
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(storage.get()) % 64);
+    EXPECT_TRUE(storage->Put("KEY1", "val1"));
+}
+
+TEST(RcuLRUTest, ConcurrentReaders) {
+    RcuLRU storage(64 * 1024);
+    const int keys = 1000;
+    for (int i = 0; i < keys; i++) {
+        storage.Put("key" + std::to_string(i), "value" + std::to_string(i));
+    }
+
+    // Readers must always see either the value or nothing (evicted), never garbage, while writer
+    // replaces, deletes and evicts items and grows the index
+    std::atomic<bool> stop(false);
+    std::atomic<int> errors(0);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&, t]() {
+            std::string value;
+            for (int n = 0; !stop.load(); n++) {
+                int i = (n * 7 + t) % keys;
+                std::string expect = "value" + std::to_string(i);
+                if (storage.Get("key" + std::to_string(i), value) && value.compare(0, expect.size(), expect) != 0) {
+                    errors++;
+                }
+
+                Afina::ValueRef ref;
+                if (storage.GetRef("key" + std::to_string(i), ref) &&
+                    ref.str().compare(0, expect.size(), expect) != 0) {
+                    errors++;
+                }
+            }
+        });
+    }
+
+    for (int round = 0; round < 20; round++) {
+        for (int i = 0; i < keys; i++) {
+            std::string key = "key" + std::to_string(i);
+            std::string value = "value" + std::to_string(i);
+            if ((i + round) % 5 == 0) {
+                storage.Delete(key);
+            } else {
+                storage.Put(key, value + std::string(round * 3, '!'));
+            }
+        }
+    }
+    stop = true;
+    for (auto &reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(0, errors.load());
+}
@@ -0,0 +1,221 @@
+#include "gtest/gtest.h"
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <afina/allocator/Arena.h>
+#include <afina/allocator/ConcurrentSlabAllocator.h>
+
+#include "storage/ShardedLRU.h"
+
+#include "TestHelpers.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+TEST(ShardedLRUTest, PutGetDelete) {
+    ShardedLRU storage(4 * 1024, 4);
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_FALSE(storage.PutIfAbsent("KEY1", "val3"));
+    EXPECT_TRUE(storage.Set("KEY2", "val4"));
+    EXPECT_FALSE(storage.Set("KEY3", "val5"));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val1", value);
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ("val4", value);
+
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+}
+
+TEST(ShardedLRUTest, MultiGet) {
+    ShardedLRU storage(64 * 1024, 4);
+
+    std::vector<std::string> keys;
+    for (int i = 0; i < 200; i++) {
+        keys.push_back("key" + std::to_string(i));
+        if (i % 3 != 0) {
+            storage.Put(keys.back(), "value" + std::to_string(i));
+        }
+    }
+
+    std::vector<int> visits(keys.size(), 0);
+    std::vector<std::string> values(keys.size());
+    storage.MultiGet(keys.data(), keys.size(),
+                     [&](std::size_t i, const char *value, std::size_t size, uint32_t flags, uint64_t cas) {
+                         visits[i]++;
+                         values[i].assign(value, size);
+                     });
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        EXPECT_EQ(i % 3 != 0 ? 1 : 0, visits[i]);
+        EXPECT_EQ(i % 3 != 0 ? "value" + std::to_string(i) : "", values[i]);
+    }
+}
+
+TEST(ShardedLRUTest, Stats) {
+    ShardedLRU storage(4 * 1024, 4);
+    for (int i = 0; i < 100; i++) {
+        storage.Put("key" + std::to_string(i), "value");
+    }
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+
+    size_t shard_items = 0;
+    std::string total_items;
+    for (auto &s : stats) {
+        if (s.first == "curr_items") {
+            total_items = s.second;
+        } else if (s.first.find(":curr_items") != std::string::npos) {
+            shard_items += std::stoul(s.second);
+        }
+    }
+    EXPECT_EQ("100", total_items);
+    EXPECT_EQ(100, shard_items);
+}
+
+TEST(ShardedLRUTest, ConcurrentAccess) {
+    const int threads = 4, keys = 10000;
+    ShardedLRU storage(threads * keys * 64, 8);
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&storage, t]() {
+            for (int i = 0; i < keys; i++) {
+                std::string key = "key" + std::to_string(t) + "_" + std::to_string(i);
+                storage.Put(key, key);
+                std::string value;
+                storage.Get(key, value);
+                if (i % 2 == 0) {
+                    storage.Delete(key);
+                }
+            }
+        });
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+
+    for (int t = 0; t < threads; t++) {
+        for (int i = 0; i < keys; i++) {
+            std::string key = "key" + std::to_string(t) + "_" + std::to_string(i);
+            std::string value;
+            EXPECT_EQ(i % 2 != 0, storage.Get(key, value));
+        }
+    }
+}
+
+TEST(ShardedLRUTest, SlabArena) {
+    // Shards share 64 slabs, caches are out of them long before their own limits
+    const int threads = 4, keys = 4000;
+    auto arena = std::make_shared<Afina::Allocator::Arena>(64 * 64 * 1024, 64 * 1024);
+    auto allocator = std::make_shared<Afina::Allocator::ConcurrentSlabAllocator>(arena);
+    ShardedLRU storage(64 * 1024 * 1024, 4, EvictionPolicy::Kind::LRU, false, 0, allocator);
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&storage, t]() {
+            for (int i = 0; i < keys; i++) {
+                std::string key = "key" + std::to_string(t) + "_" + std::to_string(i);
+                storage.Put(key, std::string(100 + (i * 37) % 300, char('a' + t)));
+                std::string value;
+                if (storage.Get(key, value)) {
+                    EXPECT_EQ(std::string(100 + (i * 37) % 300, char('a' + t)), value);
+                }
+            }
+        });
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+    EXPECT_EQ(64u, arena->Used());
+
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    size_t items = 0, used = 0, slabs = 0, evictions = 0;
+    for (auto &s : stats) {
+        if (s.first == "curr_items") {
+            items = std::stoul(s.second);
+        } else if (s.first == "evictions") {
+            evictions = std::stoul(s.second);
+        } else if (s.first == "slabs") {
+            slabs = std::stoul(s.second);
+        } else if (s.first.compare(0, 11, "slab_class_") == 0 && s.first.rfind("_used") == s.first.size() - 5) {
+            used += std::stoul(s.second);
+        }
+    }
+    // Objects in magazines and in the depot count as used ones
+    EXPECT_LE(items, used);
+    EXPECT_EQ(64u, slabs);
+    EXPECT_LT(0u, evictions);
+    EXPECT_LT(size_t(threads * keys / 2), items);
+
+    // Objects of deleted items go back to slabs, except for the ones magazines of this thread and the
+    // depot keep
+    for (int t = 0; t < threads; t++) {
+        for (int i = 0; i < keys; i++) {
+            storage.Delete("key" + std::to_string(t) + "_" + std::to_string(i));
+        }
+    }
+    stats.clear();
+    storage.Stats(stats);
+    const size_t per_class = (2 + Afina::Allocator::ConcurrentSlabAllocator::depot_limit) *
+                             Afina::Allocator::ConcurrentSlabAllocator::magazine_size;
+    for (auto &s : stats) {
+        if (s.first.compare(0, 11, "slab_class_") == 0 && s.first.rfind("_used") == s.first.size() - 5) {
+            EXPECT_GE(per_class, std::stoul(s.second)) << s.first;
+        }
+    }
+}
+
+TEST(ShardedLRUTest, SlabsTakenByOtherCache) {
+    // One cache holds every slab, the others have nothing to evict that would give them a block of a new class
+    auto arena = std::make_shared<Afina::Allocator::Arena>(4 * 64 * 1024, 64 * 1024);
+    auto allocator = std::make_shared<Afina::Allocator::ConcurrentSlabAllocator>(arena);
+    ShardedLRU hungry(1024 * 1024, 1, EvictionPolicy::Kind::LRU, false, 0, allocator);
+    ShardedLRU starved(1024 * 1024, 1, EvictionPolicy::Kind::LRU, false, 0, allocator);
+    ShardedLRU compressing(1024 * 1024, 1, EvictionPolicy::Kind::LRU, false, 1024, allocator);
+
+    ASSERT_TRUE(starved.Put("small", "value"));
+    ASSERT_TRUE(compressing.Put("packed", std::string(4000, 'x')));
+    for (int i = 0; i < 2000; i++) {
+        ASSERT_TRUE(hungry.Put("key" + std::to_string(i), std::string(1000, 'a')));
+    }
+    EXPECT_EQ(4u, arena->Used());
+
+    std::mt19937 random(42);
+    std::string noise(3000, '\0');
+    for (auto &c : noise) {
+        c = random();
+    }
+
+    // Value that has to move into a bigger block stays as it was
+    EXPECT_FALSE(starved.Append("small", noise));
+    std::string value;
+    EXPECT_TRUE(starved.Get("small", value));
+    EXPECT_EQ("value", value);
+    EXPECT_EQ("1", Stat(starved, "curr_items"));
+    EXPECT_EQ("10", Stat(starved, "bytes"));
+
+    // New item isn't counted, even though cache evicted everything trying to make room for it
+    EXPECT_FALSE(starved.Put("big", noise));
+    EXPECT_FALSE(starved.Get("big", value));
+    EXPECT_EQ("0", Stat(starved, "curr_items"));
+    EXPECT_EQ("0", Stat(starved, "bytes"));
+
+    // Compressed value has no block to be decompressed into for a view, but still could be copied
+    Afina::ValueRef ref;
+    EXPECT_FALSE(compressing.GetRef("packed", ref));
+    EXPECT_TRUE(compressing.Get("packed", value));
+    EXPECT_EQ(std::string(4000, 'x'), value);
+    EXPECT_EQ("1", Stat(compressing, "curr_items"));
+}
@@ -0,0 +1,118 @@
+#include "gtest/gtest.h"
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <afina/allocator/Arena.h>
+#include <afina/allocator/ConcurrentSlabAllocator.h>
+#include <afina/allocator/SlabMover.h>
+
+#include "storage/ShardedLRU.h"
+#include "storage/SimpleLRU.h"
+
+#include "TestHelpers.h"
+
+using namespace Afina::Allocator;
+using namespace Afina::Backend;
+using namespace std;
+
+static std::string Key(int i) { return "key" + std::to_string(i); }
+
+static std::string Value(int i, std::size_t size) { return std::string(size, char('a' + i % 26)); }
+
+TEST(SlabMoverTest, MovesSlabToStarvedClass) {
+    const size_t slab_size = 64 * 1024, small = 200, big = 3000;
+    auto arena = std::make_shared<Arena>(16 * slab_size, slab_size);
+    auto allocator = std::make_shared<ConcurrentSlabAllocator>(arena);
+    ShardedLRU storage(64 * 1024 * 1024, 2, EvictionPolicy::Kind::LRU, false, 0, allocator);
+    SlabMover mover(allocator, storage, 1000);
+
+    // Small items take all the slabs, then three of every four are gone, so that every slab keeps some
+    int items = 0;
+    while (Stat(storage, "evictions") == "0") {
+        ASSERT_TRUE(storage.Put(Key(items), Value(items, small)));
+        items++;
+    }
+    for (int i = 0; i < items; i++) {
+        if (i % 4 != 0) {
+            storage.Delete(Key(i));
+        }
+    }
+    size_t kept = std::stoul(Stat(storage, "curr_items"));
+    EXPECT_FALSE(allocator->Available(big));
+
+    // Class of big items is starved while the small ones take nothing, mover waits for the small class to age.
+    // Only failed allocations count as starvation
+    EXPECT_FALSE(mover.Step());
+    for (uint32_t i = 0; i < SlabMover::min_age - 1; i++) {
+        EXPECT_EQ(nullptr, allocator->Allocate(big));
+        EXPECT_FALSE(mover.Step());
+    }
+    EXPECT_EQ(nullptr, allocator->Allocate(big));
+    EXPECT_TRUE(mover.Step());
+
+    EXPECT_TRUE(allocator->Available(big));
+    EXPECT_EQ("1", Stat(storage, "slab_moves"));
+    EXPECT_EQ("0", Stat(storage, "slab_moves_pending"));
+    EXPECT_NE("0", Stat(storage, "slab_move_relocated"));
+    EXPECT_EQ("0", Stat(storage, "slab_move_evicted"));
+
+    // Small items moved out of the slab are all there
+    EXPECT_EQ(std::to_string(kept), Stat(storage, "curr_items"));
+    for (int i = 0; i < items; i++) {
+        std::string value;
+        if (storage.Get(Key(i), value)) {
+            EXPECT_EQ(Value(i, small), value);
+        }
+    }
+
+    // Big item takes the freed slab instead of evicting small ones
+    ASSERT_TRUE(storage.Put("big", std::string(big, 'x')));
+    EXPECT_EQ(std::to_string(kept + 1), Stat(storage, "curr_items"));
+}
+
+TEST(SlabMoverTest, KeepsLastSlab) {
+    const size_t slab_size = 64 * 1024;
+    auto arena = std::make_shared<Arena>(4 * slab_size, slab_size);
+    auto allocator = std::make_shared<ConcurrentSlabAllocator>(arena);
+    ShardedLRU storage(64 * 1024 * 1024, 1, EvictionPolicy::Kind::LRU, false, 0, allocator);
+    SlabMover mover(allocator, storage, 1000);
+
+    // Every class is starved or has a single slab, so there is nothing to move
+    ASSERT_TRUE(storage.Put("small", std::string(100, 'x')));
+    while (allocator->Available(1000)) {
+        void *object = allocator->Allocate(1000);
+        ASSERT_NE(nullptr, object);
+    }
+    for (uint32_t i = 0; i <= SlabMover::min_age + 1; i++) {
+        EXPECT_FALSE(allocator->Available(1000));
+        EXPECT_FALSE(mover.Step());
+    }
+    EXPECT_EQ("0", Stat(storage, "slab_moves"));
+    EXPECT_EQ("0", Stat(storage, "slab_moves_pending"));
+}
+
+TEST(SlabMoverTest, VacateInParts) {
+    SimpleLRU storage(64 * 1024 * 1024);
+    const size_t items = 2 * SimpleLRU::vacate_batch + 1;
+    for (size_t i = 0; i < items; i++) {
+        ASSERT_TRUE(storage.Put(Key(i), "v"));
+    }
+
+    // Slab holds none of the nodes, walk over them takes a bounded part per call
+    std::vector<char> slab(64 * 1024);
+    size_t relocated = 0, evicted = 0;
+    EXPECT_FALSE(storage.Vacate(slab.data(), slab.size(), true, relocated, evicted));
+    EXPECT_FALSE(storage.Vacate(slab.data(), slab.size(), false, relocated, evicted));
+    EXPECT_TRUE(storage.Vacate(slab.data(), slab.size(), false, relocated, evicted));
+
+    // Retry has nothing to look at until a node is allocated, new move walks anew
+    EXPECT_TRUE(storage.Vacate(slab.data(), slab.size(), false, relocated, evicted));
+    ASSERT_TRUE(storage.Put("new", "v"));
+    EXPECT_FALSE(storage.Vacate(slab.data(), slab.size(), false, relocated, evicted));
+    EXPECT_FALSE(storage.Vacate(slab.data(), slab.size(), true, relocated, evicted));
+    EXPECT_EQ(0u, relocated);
+    EXPECT_EQ(0u, evicted);
+    EXPECT_EQ(std::to_string(items + 1), Stat(storage, "curr_items"));
+}
@@ -0,0 +1,243 @@
+#include "gtest/gtest.h"
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "storage/PersistentStorage.h"
+#include "storage/RcuLRU.h"
+#include "storage/ShardedLRU.h"
+#include "storage/Snapshot.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+#include "TestHelpers.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+// Snapshot file unique for the test process, removed once test is over
+class SnapshotFile {
+public:
+    SnapshotFile() : path("/tmp/afina_snapshot_" + std::to_string(getpid())) {}
+    ~SnapshotFile() { unlink(path.c_str()); }
+
+    const std::string path;
+};
+
+// Keys of all the items Scan visits, in the order of visits
+static std::vector<std::string> ScanAll(Afina::Storage &storage, std::size_t batch) {
+    std::vector<std::string> keys;
+    std::size_t cursor = 0;
+    do {
+        cursor = storage.Scan(cursor, batch,
+                              [&](const char *key, std::size_t key_size, const char *value, std::size_t value_size,
+                                  uint32_t flags, time_t expire) { keys.emplace_back(key, key_size); });
+    } while (cursor != 0);
+    return keys;
+}
+
+TEST(SnapshotTest, ScanVisitsEveryItemOnce) {
+    std::vector<std::unique_ptr<Afina::Storage>> storages;
+    storages.emplace_back(new SimpleLRU(1024 * 1024));
+    storages.emplace_back(new ThreadSafeSimplLRU(1024 * 1024));
+    storages.emplace_back(new ShardedLRU(1024 * 1024, 8));
+    storages.emplace_back(new RcuLRU(1024 * 1024));
+
+    for (auto &storage : storages) {
+        for (int i = 0; i < 1000; i++) {
+            storage->Put("key" + std::to_string(i), "value");
+        }
+        for (int i = 0; i < 1000; i += 3) {
+            storage->Delete("key" + std::to_string(i));
+        }
+        storage->Put("expired", "value", 0, std::time(nullptr) - 1);
+
+        std::vector<std::string> keys = ScanAll(*storage, 7);
+        std::set<std::string> unique(keys.begin(), keys.end());
+        EXPECT_EQ(666u, keys.size());
+        EXPECT_EQ(666u, unique.size());
+        EXPECT_EQ(0u, unique.count("key0"));
+        EXPECT_EQ(1u, unique.count("key1"));
+        EXPECT_EQ(0u, unique.count("expired"));
+    }
+}
+
+TEST(SnapshotTest, ScanDuringUpdates) {
+    // Items that stay in the storage are visited even if others come and go meanwhile
+    RcuLRU storage(1024 * 1024);
+    for (int i = 0; i < 100; i++) {
+        storage.Put("stable" + std::to_string(i), "value");
+    }
+
+    std::set<std::string> keys;
+    std::size_t cursor = 0;
+    int round = 0;
+    do {
+        cursor = storage.Scan(cursor, 3,
+                              [&](const char *key, std::size_t key_size, const char *value, std::size_t value_size,
+                                  uint32_t flags, time_t expire) { keys.emplace(key, key_size); });
+        // Index grows several times during the scan
+        for (int i = 0; i < 50 && round < 40; i++) {
+            storage.Put("new" + std::to_string(round * 50 + i), "value");
+        }
+        round++;
+    } while (cursor != 0);
+
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(1u, keys.count("stable" + std::to_string(i)));
+    }
+}
+
+TEST(SnapshotTest, WriteLoad) {
+    SnapshotFile file;
+    time_t expire = std::time(nullptr) + 3600;
+    {
+        ShardedLRU storage(1024 * 1024, 4);
+        for (int i = 0; i < 1000; i++) {
+            storage.Put("key" + std::to_string(i), "value" + std::to_string(i), i, i % 2 ? expire : 0);
+        }
+        storage.Put("empty", "");
+        storage.Put("expired", "value", 0, std::time(nullptr) - 1);
+
+        SnapshotProgress progress;
+        WriteSnapshot(storage, file.path, 16, progress);
+        EXPECT_EQ(1001u, progress.items.load());
+    }
+
+    SimpleLRU storage(1024 * 1024);
+    EXPECT_EQ(1001u, LoadSnapshot(storage, file.path));
+
+    std::string value;
+    uint32_t flags;
+    for (int i = 0; i < 1000; i++) {
+        ASSERT_TRUE(storage.Get("key" + std::to_string(i), value, &flags));
+        EXPECT_EQ("value" + std::to_string(i), value);
+        EXPECT_EQ(uint32_t(i), flags);
+    }
+    EXPECT_TRUE(storage.Get("empty", value));
+    EXPECT_EQ("", value);
+    EXPECT_FALSE(storage.Get("expired", value));
+
+    // TTL survives
+    std::size_t cursor = 0;
+    do {
+        cursor = storage.Scan(cursor, 100,
+                              [&](const char *key, std::size_t key_size, const char *value, std::size_t value_size,
+                                  uint32_t flags, time_t item_expire) {
+                                  EXPECT_EQ(flags % 2 ? expire : 0, item_expire);
+                              });
+    } while (cursor != 0);
+}
+
+TEST(SnapshotTest, DamagedFile) {
+    SnapshotFile file;
+    SimpleLRU storage(1024 * 1024);
+    EXPECT_EQ(0u, LoadSnapshot(storage, file.path));
+
+    {
+        SimpleLRU source(1024 * 1024);
+        source.Put("key1", "value1");
+        source.Put("key2", "value2");
+        SnapshotProgress progress;
+        WriteSnapshot(source, file.path, 16, progress);
+    }
+
+    // Cut footer off
+    std::ifstream in(file.path, std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::ofstream(file.path, std::ios::binary | std::ios::trunc) << content.substr(0, content.size() - 4);
+    EXPECT_THROW(LoadSnapshot(storage, file.path), std::runtime_error);
+
+    std::ofstream(file.path, std::ios::binary | std::ios::trunc) << "garbage";
+    EXPECT_THROW(LoadSnapshot(storage, file.path), std::runtime_error);
+}
+
+TEST(SnapshotTest, PersistentStorage) {
+    SnapshotFile file;
+    {
+        PersistentStorage storage(std::make_shared<ThreadSafeSimplLRU>(1024 * 1024), file.path);
+        storage.Start();
+        EXPECT_EQ("0", Stat(storage, "snapshot_loaded_items"));
+        for (int i = 0; i < 100; i++) {
+            storage.Put("key" + std::to_string(i), "value");
+        }
+        storage.Stop();
+    }
+
+    PersistentStorage storage(std::make_shared<ShardedLRU>(1024 * 1024, 4), file.path);
+    storage.Start();
+    EXPECT_EQ("100", Stat(storage, "snapshot_loaded_items"));
+    std::string value;
+    EXPECT_TRUE(storage.Get("key42", value));
+
+    storage.Delete("key42");
+    EXPECT_TRUE(storage.Snapshot());
+    EXPECT_EQ("1", Stat(storage, "snapshot_count"));
+    EXPECT_EQ("99", Stat(storage, "snapshot_items"));
+    EXPECT_EQ("0", Stat(storage, "snapshot_in_progress"));
+    storage.Stop();
+    EXPECT_EQ("2", Stat(storage, "snapshot_count"));
+
+    // Damaged snapshot leaves cache cold but working
+    std::ofstream(file.path, std::ios::binary | std::ios::trunc) << "garbage";
+    PersistentStorage cold(std::make_shared<SimpleLRU>(1024), file.path);
+    cold.Start();
+    EXPECT_EQ("1", Stat(cold, "snapshot_load_failures"));
+    EXPECT_TRUE(cold.Put("key", "value"));
+}
+
+TEST(SnapshotTest, MappedValues) {
+    SnapshotFile file;
+    {
+        SimpleLRU source(1024 * 1024);
+        for (int i = 0; i < 100; i++) {
+            source.Put("key" + std::to_string(i), "value" + std::to_string(i));
+        }
+        SnapshotProgress progress;
+        WriteSnapshot(source, file.path, 16, progress);
+    }
+
+    ShardedLRU storage(1024 * 1024, 4);
+    EXPECT_EQ(100u, LoadSnapshot(storage, file.path));
+    EXPECT_EQ("100", Stat(storage, "external_items"));
+
+    // Values are served from the mapping even after the file is replaced
+    Afina::ValueRef ref;
+    EXPECT_TRUE(storage.GetRef("key1", ref));
+    unlink(file.path.c_str());
+    std::string value;
+    EXPECT_TRUE(storage.Get("key0", value));
+    EXPECT_EQ("value0", value);
+
+    // Every kind of update copies value out of the mapping
+    uint64_t counter;
+    EXPECT_TRUE(storage.Put("key1", "new"));
+    EXPECT_TRUE(storage.Append("key2", "+"));
+    EXPECT_TRUE(storage.Prepend("key3", "-"));
+    EXPECT_TRUE(storage.Set("key4", "5"));
+    EXPECT_EQ(Afina::Storage::CounterResult::Updated, storage.Increment("key4", 1, counter));
+    EXPECT_TRUE(storage.Delete("key5"));
+    EXPECT_EQ("value1", ref.str());
+    EXPECT_EQ("96", Stat(storage, "external_items")); // Old key1 is still pinned
+
+    EXPECT_TRUE(storage.Get("key2", value));
+    EXPECT_EQ("value2+", value);
+    EXPECT_TRUE(storage.Get("key3", value));
+    EXPECT_EQ("-value3", value);
+    EXPECT_TRUE(storage.Get("key4", value));
+    EXPECT_EQ("6", value);
+
+    // Pinned value is released once the view is gone
+    ref.Reset();
+    EXPECT_TRUE(storage.Delete("key0"));
+    for (int i = 6; i < 100; i++) {
+        EXPECT_TRUE(storage.Delete("key" + std::to_string(i)));
+    }
+    EXPECT_EQ("0", Stat(storage, "external_items"));
+    EXPECT_EQ("0", Stat(storage, "external_bytes"));
+}
@@ -1,4 +1,5 @@
 #include "gtest/gtest.h"
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <set>
@@ -12,6 +13,8 @@
 
 #include "storage/SimpleLRU.h"
 
+#include "TestHelpers.h"
+
 using namespace Afina::Backend;
 using namespace Afina::Execute;
 using namespace std;
@@ -108,3 +111,449 @@ TEST(StorageTest, MaxTest) {
         EXPECT_FALSE(storage.Get(key, res));
     }
 }
+
+TEST(StorageTest, DeleteHeadMiddleTail) {
+    SimpleLRU storage;
+
+    for (int i = 0; i < 5; i++) {
+        storage.Put("KEY" + std::to_string(i), "val" + std::to_string(i));
+    }
+
+    // KEY4 is the freshest one, KEY0 is the oldest one
+    EXPECT_TRUE(storage.Delete("KEY4"));
+    EXPECT_TRUE(storage.Delete("KEY2"));
+    EXPECT_TRUE(storage.Delete("KEY0"));
+    EXPECT_FALSE(storage.Delete("KEY0"));
+
+    std::string value;
+    EXPECT_FALSE(storage.Get("KEY4", value));
+    EXPECT_FALSE(storage.Get("KEY2", value));
+    EXPECT_FALSE(storage.Get("KEY0", value));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val1", value);
+    EXPECT_TRUE(storage.Get("KEY3", value));
+    EXPECT_EQ("val3", value);
+
+    // List is still consistent: new items go to the head, eviction goes from the tail
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_TRUE(storage.Delete("KEY3"));
+    EXPECT_TRUE(storage.Put("KEY5", "val5"));
+    EXPECT_TRUE(storage.Get("KEY5", value));
+    EXPECT_EQ("val5", value);
+}
+
+TEST(StorageTest, UpdateGrowShrink) {
+    SimpleLRU storage(1024 * 1024);
+
+    std::string value;
+    std::string big(5000, 'x');
+    EXPECT_TRUE(storage.Put("KEY1", "small"));
+    EXPECT_TRUE(storage.Put("KEY2", "other"));
+    EXPECT_TRUE(storage.Set("KEY1", big));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ(big, value);
+
+    EXPECT_TRUE(storage.Put("KEY1", "tiny"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("tiny", value);
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ("other", value);
+}
+
+TEST(StorageTest, Flags) {
+    SimpleLRU storage;
+
+    std::string value;
+    uint32_t flags = 0;
+    EXPECT_TRUE(storage.Put("KEY1", "val1", 0xDEADBEEF));
+    EXPECT_TRUE(storage.PutIfAbsent("KEY2", "val2", 42));
+    EXPECT_TRUE(storage.Get("KEY1", value, &flags));
+    EXPECT_EQ(0xDEADBEEF, flags);
+    EXPECT_TRUE(storage.Get("KEY2", value, &flags));
+    EXPECT_EQ(42, flags);
+
+    // Update replaces flags along with the value
+    EXPECT_TRUE(storage.Set("KEY1", std::string(100, 'x'), 7));
+    EXPECT_TRUE(storage.Get("KEY1", value, &flags));
+    EXPECT_EQ(7, flags);
+    EXPECT_TRUE(storage.Put("KEY2", "val"));
+    EXPECT_TRUE(storage.Get("KEY2", value, &flags));
+    EXPECT_EQ(0, flags);
+}
+
+TEST(StorageTest, CompareAndSet) {
+    SimpleLRU storage;
+
+    std::string value;
+    uint64_t cas1 = 0, cas2 = 0;
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Get("KEY1", value, nullptr, &cas1));
+    EXPECT_TRUE(storage.Get("KEY2", value, nullptr, &cas2));
+    EXPECT_NE(0, cas1);
+    EXPECT_NE(cas1, cas2);
+
+    // Only the first writer of the version wins
+    EXPECT_EQ(Afina::Storage::CasResult::Stored, storage.CompareAndSet("KEY1", "new1", cas1, 5));
+    EXPECT_EQ(Afina::Storage::CasResult::Exists, storage.CompareAndSet("KEY1", "new2", cas1));
+    EXPECT_EQ(Afina::Storage::CasResult::NotFound, storage.CompareAndSet("KEY3", "new3", cas1));
+
+    uint32_t flags = 0;
+    uint64_t cas = 0;
+    EXPECT_TRUE(storage.Get("KEY1", value, &flags, &cas));
+    EXPECT_EQ("new1", value);
+    EXPECT_EQ(5, flags);
+    EXPECT_NE(cas1, cas);
+
+    // Any update changes the version
+    EXPECT_TRUE(storage.Set("KEY1", "new4"));
+    EXPECT_EQ(Afina::Storage::CasResult::Exists, storage.CompareAndSet("KEY1", "new5", cas));
+    EXPECT_TRUE(storage.Get("KEY1", value, nullptr, &cas));
+    EXPECT_EQ(Afina::Storage::CasResult::Stored, storage.CompareAndSet("KEY1", "new5", cas));
+}
+
+TEST(StorageTest, AppendPrepend) {
+    SimpleLRU storage(1024 * 1024);
+
+    std::string value;
+    uint32_t flags = 0;
+    uint64_t cas1 = 0, cas2 = 0;
+    EXPECT_FALSE(storage.Append("KEY1", "tail"));
+    EXPECT_FALSE(storage.Prepend("KEY1", "head"));
+
+    EXPECT_TRUE(storage.Put("KEY1", "body", 3));
+    EXPECT_TRUE(storage.Get("KEY1", value, nullptr, &cas1));
+    EXPECT_TRUE(storage.Append("KEY1", "tail"));
+    EXPECT_TRUE(storage.Prepend("KEY1", "head"));
+    EXPECT_TRUE(storage.Get("KEY1", value, &flags, &cas2));
+    EXPECT_EQ("headbodytail", value);
+    EXPECT_EQ(3, flags);
+    EXPECT_NE(cas1, cas2);
+
+    // Grow well beyond the initial block, so that both in place and moving paths are taken
+    std::string expected = value;
+    for (int i = 0; i < 100; i++) {
+        std::string chunk(i, 'a' + i % 26);
+        if (i % 2 == 0) {
+            EXPECT_TRUE(storage.Append("KEY1", chunk));
+            expected = expected + chunk;
+        } else {
+            EXPECT_TRUE(storage.Prepend("KEY1", chunk));
+            expected = chunk + expected;
+        }
+    }
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ(expected, value);
+}
+
+TEST(StorageTest, IncrementDecrement) {
+    SimpleLRU storage;
+
+    uint64_t counter = 0;
+    EXPECT_EQ(Afina::Storage::CounterResult::NotFound, storage.Increment("KEY1", 1, counter));
+
+    EXPECT_TRUE(storage.Put("KEY1", "99", 8));
+    EXPECT_EQ(Afina::Storage::CounterResult::Updated, storage.Increment("KEY1", 1, counter));
+    EXPECT_EQ(100, counter);
+    EXPECT_EQ(Afina::Storage::CounterResult::Updated, storage.Decrement("KEY1", 91, counter));
+    EXPECT_EQ(9, counter);
+
+    std::string value;
+    uint32_t flags = 0;
+    EXPECT_TRUE(storage.Get("KEY1", value, &flags));
+    EXPECT_EQ("9", value);
+    EXPECT_EQ(8, flags);
+
+    // Decrement stops at 0, increment wraps around
+    EXPECT_EQ(Afina::Storage::CounterResult::Updated, storage.Decrement("KEY1", 10, counter));
+    EXPECT_EQ(0, counter);
+    EXPECT_TRUE(storage.Put("KEY1", "18446744073709551615"));
+    EXPECT_EQ(Afina::Storage::CounterResult::Updated, storage.Increment("KEY1", 2, counter));
+    EXPECT_EQ(1, counter);
+
+    EXPECT_TRUE(storage.Put("KEY2", "12a"));
+    EXPECT_EQ(Afina::Storage::CounterResult::NotNumber, storage.Increment("KEY2", 1, counter));
+    EXPECT_TRUE(storage.Put("KEY2", "18446744073709551616"));
+    EXPECT_EQ(Afina::Storage::CounterResult::NotNumber, storage.Increment("KEY2", 1, counter));
+    EXPECT_TRUE(storage.Put("KEY2", ""));
+    EXPECT_EQ(Afina::Storage::CounterResult::NotNumber, storage.Decrement("KEY2", 1, counter));
+
+    // Counter that outgrows the storage stays as it was
+    SimpleLRU small(7);
+    EXPECT_TRUE(small.Put("KEY1", "999"));
+    EXPECT_EQ(Afina::Storage::CounterResult::NoMemory, small.Increment("KEY1", 1, counter));
+    EXPECT_TRUE(small.Get("KEY1", value));
+    EXPECT_EQ("999", value);
+    EXPECT_EQ(Afina::Storage::CounterResult::Updated, small.Decrement("KEY1", 990, counter));
+    EXPECT_EQ(9, counter);
+}
+
+TEST(StorageTest, MultiGet) {
+    SimpleLRU storage;
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1", 1));
+    EXPECT_TRUE(storage.Put("KEY3", "val3", 3));
+
+    std::vector<std::string> keys = {"KEY1", "KEY2", "KEY3", "KEY1"};
+    std::vector<std::string> values(keys.size());
+    std::vector<uint32_t> flags(keys.size());
+    storage.MultiGet(keys.data(), keys.size(),
+                     [&](std::size_t i, const char *value, std::size_t size, uint32_t f, uint64_t cas) {
+                         values[i].assign(value, size);
+                         flags[i] = f;
+                     });
+    EXPECT_EQ("val1", values[0]);
+    EXPECT_EQ("", values[1]);
+    EXPECT_EQ("val3", values[2]);
+    EXPECT_EQ("val1", values[3]);
+    EXPECT_EQ(3, flags[2]);
+
+    // Visited items become the freshest ones, so KEY4 evicts KEY2
+    SimpleLRU small(16);
+    EXPECT_TRUE(small.Put("KEY1", "val1"));
+    EXPECT_TRUE(small.Put("KEY2", "val2"));
+    small.MultiGet(keys.data(), 1, [](std::size_t, const char *, std::size_t, uint32_t, uint64_t) {});
+    EXPECT_TRUE(small.Put("KEY4", "val4"));
+
+    std::string value;
+    EXPECT_TRUE(small.Get("KEY1", value));
+    EXPECT_FALSE(small.Get("KEY2", value));
+}
+
+TEST(StorageTest, ExpireOnGet) {
+    fake_now = 1000000;
+    SimpleLRU storage(1024, &FakeClock);
+
+    std::string value;
+    EXPECT_TRUE(storage.Put("KEY1", "val1", 0, fake_now + 10));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val1", value);
+
+    fake_now += 10;
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_FALSE(storage.PutIfAbsent("KEY2", "val3"));
+    EXPECT_TRUE(storage.PutIfAbsent("KEY1", "val3"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val3", value);
+    EXPECT_EQ("1", Stat(storage, "expired"));
+}
+
+TEST(StorageTest, AppendKeepsExpire) {
+    fake_now = 1000000;
+    SimpleLRU storage(1024, &FakeClock);
+
+    std::string value;
+    EXPECT_TRUE(storage.Put("KEY1", "val1", 0, fake_now + 10));
+    EXPECT_TRUE(storage.Append("KEY1", std::string(100, 'x')));
+    fake_now += 10;
+    EXPECT_FALSE(storage.Get("KEY1", value));
+}
+
+TEST(StorageTest, ExpireInPast) {
+    fake_now = 1000000;
+    SimpleLRU storage(1024, &FakeClock);
+
+    std::string value;
+    EXPECT_TRUE(storage.Put("KEY1", "val1", 0, fake_now));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+
+    // Update with expiration in the past drops item
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Set("KEY2", "val2", 0, fake_now - 1));
+    EXPECT_FALSE(storage.Get("KEY2", value));
+    EXPECT_EQ("0", Stat(storage, "curr_items"));
+}
+
+TEST(StorageTest, ExpireByWheel) {
+    fake_now = 1000000;
+    SimpleLRU storage(1024 * 1024, &FakeClock);
+
+    // Cover every wheel level including items beyond the wheel range
+    const time_t ttls[] = {1, 63, 64, 100, 4095, 4096, 300000, 20000000, 100000000};
+    int i = 0;
+    for (time_t ttl : ttls) {
+        EXPECT_TRUE(storage.Put("KEY" + std::to_string(i++), "val", 0, fake_now + ttl));
+    }
+    EXPECT_TRUE(storage.Put("FOREVER", "val"));
+
+    // Nobody touches expired items, they are reaped by operations on other keys
+    i = 0;
+    for (time_t ttl : ttls) {
+        std::string value;
+        while (fake_now < 1000000 + ttl) {
+            EXPECT_TRUE(storage.Get("KEY" + std::to_string(i), value));
+            fake_now += std::max<time_t>(1, (1000000 + ttl - fake_now) / 2);
+        }
+        storage.Get("FOREVER", value);
+        EXPECT_EQ(std::to_string(i + 1), Stat(storage, "expired"));
+        i++;
+    }
+    EXPECT_EQ("1", Stat(storage, "curr_items"));
+}
+
+TEST(StorageTest, ExpiredGoFirst) {
+    fake_now = 1000000;
+    SimpleLRU storage(20, &FakeClock);
+
+    // KEY1 is the oldest one, but KEY2 is already expired, so it is reclaimed instead
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2", 0, fake_now + 1));
+    fake_now += 1;
+    EXPECT_TRUE(storage.Put("KEY3", "val3"));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Get("KEY3", value));
+    EXPECT_EQ("0", Stat(storage, "evictions"));
+}
+
+TEST(StorageTest, PinnedValue) {
+    SimpleLRU storage(32);
+
+    Afina::ValueRef view;
+    uint32_t flags = 0;
+    EXPECT_TRUE(storage.Put("KEY1", "val1", 5));
+    EXPECT_TRUE(storage.GetRef("KEY1", view, &flags));
+    EXPECT_EQ("val1", view.str());
+    EXPECT_EQ(5, flags);
+
+    // Updates don't touch bytes being read
+    Afina::ValueRef copy = view;
+    EXPECT_TRUE(storage.Set("KEY1", "new1"));
+    EXPECT_TRUE(storage.Append("KEY1", "tail"));
+    EXPECT_EQ("val1", view.str());
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("new1tail", value);
+
+    // Deleted and evicted values stay in place as well
+    Afina::ValueRef deleted, evicted;
+    EXPECT_TRUE(storage.GetRef("KEY1", deleted));
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.GetRef("KEY2", evicted));
+    EXPECT_TRUE(storage.Put("KEY3", std::string(24, 'x')));
+    EXPECT_FALSE(storage.Get("KEY2", value));
+    EXPECT_EQ("new1tail", deleted.str());
+    EXPECT_EQ("val2", evicted.str());
+    EXPECT_EQ("3", Stat(storage, "detached_items"));
+
+    // Memory is reclaimed once the last view is gone
+    view.Reset();
+    EXPECT_EQ("3", Stat(storage, "detached_items"));
+    copy.Reset();
+    deleted.Reset();
+    evicted = Afina::ValueRef();
+    EXPECT_TRUE(storage.Get("KEY3", value));
+    EXPECT_EQ("0", Stat(storage, "detached_items"));
+}
+
+TEST(StorageTest, ManyViewsReleasedGradually) {
+    SimpleLRU storage(1024 * 1024);
+
+    // Every update of a value being read leaves the old node detached
+    std::vector<Afina::ValueRef> views(100);
+    EXPECT_TRUE(storage.Put("KEY", "value"));
+    for (auto &view : views) {
+        EXPECT_TRUE(storage.GetRef("KEY", view));
+        EXPECT_TRUE(storage.Set("KEY", "value"));
+    }
+    EXPECT_EQ("100", Stat(storage, "detached_items"));
+
+    // Operation looks at a few of them only, all of them are gone after a few operations
+    views.clear();
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY", value));
+    EXPECT_NE("0", Stat(storage, "detached_items"));
+    EXPECT_NE("100", Stat(storage, "detached_items"));
+    for (int i = 0; i < 10; i++) {
+        EXPECT_TRUE(storage.Get("KEY", value));
+    }
+    EXPECT_EQ("0", Stat(storage, "detached_items"));
+}
+
+static size_t StatNumber(SimpleLRU &storage, const std::string &name) { return std::stoull(Stat(storage, name)); }
+
+TEST(StorageTest, MemoryLimit) {
+    const size_t limit = 256 * 1024;
+    SimpleLRU storage(1024 * 1024 * 1024);
+    storage.SetMemoryLimit(limit);
+
+    for (int i = 0; i < 100000; i++) {
+        ASSERT_TRUE(storage.Put("Key " + std::to_string(i), std::string(i % 200, 'v')));
+        ASSERT_LE(StatNumber(storage, "memory_used"), limit);
+    }
+
+    // Everything besides keys and values is counted
+    size_t items = StatNumber(storage, "curr_items");
+    EXPECT_LT(items, 100000);
+    EXPECT_EQ(StatNumber(storage, "memory_used"),
+              StatNumber(storage, "bytes") + StatNumber(storage, "item_overhead_bytes") +
+                  StatNumber(storage, "index_bytes"));
+    EXPECT_GT(StatNumber(storage, "item_overhead_bytes"), items * 32);
+    EXPECT_GT(StatNumber(storage, "memory_used"), limit - 1024);
+
+    // Item bigger than the limit doesn't fit
+    EXPECT_FALSE(storage.Put("Big", std::string(limit, 'v')));
+}
+
+TEST(StorageTest, MemoryFragmentation) {
+    SimpleLRU storage(1024 * 1024);
+    for (int i = 0; i < 1000; i++) {
+        storage.Put("Key " + std::to_string(i), std::string(100, 'v'));
+    }
+    size_t used = StatNumber(storage, "memory_used");
+
+    // Freed blocks stay in the arena and are reused by the same sizes
+    size_t fragmentation = StatNumber(storage, "fragmentation_bytes");
+    for (int i = 0; i < 500; i++) {
+        storage.Delete("Key " + std::to_string(i));
+    }
+    EXPECT_GT(StatNumber(storage, "fragmentation_bytes"), fragmentation);
+    EXPECT_LT(StatNumber(storage, "memory_used"), used);
+
+    for (int i = 0; i < 500; i++) {
+        storage.Put("Key " + std::to_string(i), std::string(100, 'v'));
+    }
+    EXPECT_EQ(fragmentation, StatNumber(storage, "fragmentation_bytes"));
+}
+
+TEST(StorageTest, MemoryLimitResize) {
+    SimpleLRU storage(1024);
+    EXPECT_TRUE(storage.SetMemoryLimit(4 * 1024 * 1024));
+    EXPECT_EQ("4194304", Stat(storage, "limit_maxbytes"));
+    for (int i = 0; i < 100000; i++) {
+        storage.Put("Key " + std::to_string(i), std::string(100, 'v'));
+    }
+    size_t used = StatNumber(storage, "memory_used");
+    EXPECT_GT(used, 4 * 1024 * 1024 - 4096);
+
+    // Cache shrinks by slices, a single operation evicts at most 64KB
+    const size_t limit = 1024 * 1024;
+    EXPECT_TRUE(storage.SetMemoryLimit(limit));
+    EXPECT_EQ(used, StatNumber(storage, "memory_used"));
+    std::string value;
+    int steps = 0;
+    while (StatNumber(storage, "memory_used") > limit) {
+        size_t before = StatNumber(storage, "memory_used");
+        storage.Get("Key 99999", value);
+        ASSERT_LE(before - StatNumber(storage, "memory_used"), 64 * 1024 + 1024);
+        ASSERT_LT(++steps, 1000);
+    }
+    EXPECT_GT(steps, 40);
+    EXPECT_TRUE(storage.Get("Key 99999", value));
+
+    // New items are evicted against the new limit, grown limit takes more of them
+    for (int i = 0; i < 100000; i++) {
+        storage.Put("Key " + std::to_string(i), std::string(100, 'v'));
+    }
+    EXPECT_LE(StatNumber(storage, "memory_used"), limit);
+    size_t items = StatNumber(storage, "curr_items");
+    EXPECT_TRUE(storage.SetMemoryLimit(2 * limit));
+    for (int i = 0; i < 100000; i++) {
+        storage.Put("Key " + std::to_string(i), std::string(100, 'v'));
+    }
+    EXPECT_GT(StatNumber(storage, "curr_items"), items * 3 / 2);
+}
@@ -0,0 +1,22 @@
+#include "TestHelpers.h"
+
+#include <utility>
+#include <vector>
+
+// See TestHelpers.h
+std::string Stat(Afina::Storage &storage, const std::string &name) {
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    for (auto &stat : stats) {
+        if (stat.first == name) {
+            return stat.second;
+        }
+    }
+    return "";
+}
+
+// See TestHelpers.h
+time_t fake_now = 1000000;
+
+// See TestHelpers.h
+time_t FakeClock() { return fake_now; }
@@ -0,0 +1,16 @@
+#ifndef AFINA_TEST_STORAGE_TEST_HELPERS_H
+#define AFINA_TEST_STORAGE_TEST_HELPERS_H
+
+#include <ctime>
+#include <string>
+
+#include <afina/Storage.h>
+
+// Returns value of the stat with the given name, empty string if there is none
+std::string Stat(Afina::Storage &storage, const std::string &name);
+
+// Time seen by storages created with FakeClock, tests move it by hand
+extern time_t fake_now;
+time_t FakeClock();
+
+#endif // AFINA_TEST_STORAGE_TEST_HELPERS_H